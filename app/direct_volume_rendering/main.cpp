@@ -4,6 +4,7 @@
 
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/Viewer>
+#include <osgViewer/ViewerEventHandlers>
 
 #include <vis4earth/osg_util.h>
 #include <vis4earth/scalar_viser/dvr.h>
@@ -15,6 +16,8 @@ int main(int argc, char **argv) {
     viewer->setUpViewInWindow(200, 50, 1000, 1000);
     auto *manipulator = new osgGA::TrackballManipulator;
     viewer->setCameraManipulator(manipulator);
+    // 按 S 键显示帧率，用于比较各绘制选项的开销
+    viewer->addEventHandler(new osgViewer::StatsHandler);
 
     osg::ref_ptr<osg::Group> grp = new osg::Group;
     grp->addChild(VIS4Earth::CreateEarth());
@@ -38,7 +38,7 @@ int main(int argc, char **argv) {
 
         auto &vol = volDat.result.dat;
         memcpy(img->data(),
-               vol.GetData().data() + vol.GetVoxelSize() * voxPerVol[0] * voxPerVol[1] * 10,
+               vol.GetData() + vol.GetVoxelSize() * voxPerVol[0] * voxPerVol[1] * 10,
                vol.GetVoxelSize() * voxPerVol[0] * voxPerVol[1]);
 
         rndrParam.heightMapTex = new osg::Texture2D;
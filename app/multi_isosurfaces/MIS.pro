@@ -1,7 +1,7 @@
 TEMPLATE = app
 TARGET = MIS
 
-CONFIG += c++11 qt plugin
+CONFIG += c++11 qt plugin thread
 QT += core gui widgets charts
 CONFIG += qmake_qt_autogen
 
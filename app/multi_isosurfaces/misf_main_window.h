@@ -102,6 +102,8 @@ class MISFMainWindow : public QWidget {
 
         connect(ui.checkBox_UseSmoothedVol, &QCheckBox::stateChanged, this,
                 &MISFMainWindow::updateRenderer);
+        connect(ui.checkBox_UsePrecomputedGradient, &QCheckBox::stateChanged, this,
+                &MISFMainWindow::updateRenderer);
 
         connect(ui.doubleSpinBox_DeltaT,
                 static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged), this,
@@ -119,6 +121,7 @@ class MISFMainWindow : public QWidget {
                 ui.doubleSpinBox_LightPosLon->setEnabled(true);
                 ui.doubleSpinBox_LightPosLat->setEnabled(true);
                 ui.doubleSpinBox_LightPosH->setEnabled(true);
+                ui.checkBox_UsePrecomputedGradient->setEnabled(true);
 
                 updateRenderer();
             } else {
@@ -129,6 +132,7 @@ class MISFMainWindow : public QWidget {
                 ui.doubleSpinBox_LightPosLon->setEnabled(false);
                 ui.doubleSpinBox_LightPosLat->setEnabled(false);
                 ui.doubleSpinBox_LightPosH->setEnabled(false);
+                ui.checkBox_UsePrecomputedGradient->setEnabled(false);
 
                 updateRenderer();
             }
@@ -207,6 +211,7 @@ class MISFMainWindow : public QWidget {
 
         VIS4Earth::ScalarViser::MultiIsosurfacesRenderer::ShadingParam shadingParam;
         shadingParam.useShading = ui.checkBox_UseShading->isChecked();
+        shadingParam.usePrecomputedGradient = ui.checkBox_UsePrecomputedGradient->isChecked();
         shadingParam.ka = ui.doubleSpinBox_Ka->value();
         shadingParam.kd = ui.doubleSpinBox_Kd->value();
         shadingParam.ks = ui.doubleSpinBox_Ks->value();
@@ -0,0 +1,21 @@
+#include "alloc_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> allocNum(0);
+std::atomic<uint64_t> allocBytes(0);
+
+// 单个对象与数组的分配、释放函数成套替换，均经 malloc/free
+void *operator new(size_t sz) {
+    ++allocNum;
+    allocBytes += sz;
+    if (auto p = std::malloc(sz == 0 ? 1 : sz))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t sz) { return operator new(sz); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
@@ -0,0 +1,13 @@
+#ifndef VIS4EARTH_VOLUME_BENCHMARK_ALLOC_COUNTER_H
+#define VIS4EARTH_VOLUME_BENCHMARK_ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+
+// 全局堆分配的次数与字节数，供 benchAlloc 比较各操作复制体素缓冲的开销。
+// 替换的分配、释放函数定义在 alloc_counter.cpp 中：放在单独的翻译单元里，
+// 编译器不会将其内联到调用处，也就不会把 free 误判为与 operator new 不匹配
+extern std::atomic<uint64_t> allocNum;
+extern std::atomic<uint64_t> allocBytes;
+
+#endif // !VIS4EARTH_VOLUME_BENCHMARK_ALLOC_COUNTER_H
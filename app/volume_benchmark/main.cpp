@@ -0,0 +1,1610 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include <array>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include <osg/CoordinateSystemNode>
+
+#include <vis4earth/data/bricked_vol.h>
+#include <vis4earth/data/macro_cell.h>
+#include <vis4earth/data/vol_ao.h>
+#include <vis4earth/data/vol_compressed.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/data/vol_gradient.h>
+#include <vis4earth/data/vol_gridding.h>
+#include <vis4earth/data/vol_packed.h>
+#include <vis4earth/data/vol_pyramid.h>
+#include <vis4earth/io/vol_io.h>
+#include <vis4earth/scalar_viser/dvr_cpu.h>
+
+#include "alloc_counter.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 各项验证失败的次数，非零时 main 返回 1
+static uint32_t failNum = 0;
+// 由命令行参数 --update-golden 设置，为真时重新生成基准图像而不比较
+static bool updateGolden = false;
+
+/*
+ * 函数: check
+ * 功能: 记录一项验证的结果并原样返回，失败时计数
+ */
+static bool check(bool pass) {
+    if (!pass)
+        ++failNum;
+    return pass;
+}
+static const char *passOrFail(bool pass) { return check(pass) ? "PASS" : "FAIL"; }
+
+/*
+ * 函数: genVolume
+ * 功能: 生成带有低频结构与噪声的测试体数据，使重采样、光滑等算法的分支行为接近真实数据
+ */
+static VIS4Earth::RAWVolumeData genVolume(const std::array<uint32_t, 3> &voxPerVol) {
+    std::vector<uint8_t> dat(static_cast<size_t>(voxPerVol[0]) * voxPerVol[1] * voxPerVol[2]);
+    std::mt19937 rng(0);
+    size_t idx = 0;
+    for (uint32_t z = 0; z < voxPerVol[2]; ++z)
+        for (uint32_t y = 0; y < voxPerVol[1]; ++y)
+            for (uint32_t x = 0; x < voxPerVol[0]; ++x) {
+                auto v = 64.f * (std::sin(.05f * x) + std::cos(.07f * y) + std::sin(.11f * z));
+                dat[idx] = static_cast<uint8_t>(
+                    std::min(255.f, std::max(0.f, 128.f + v + static_cast<float>(rng() % 32))));
+                ++idx;
+            }
+
+    return VIS4Earth::RAWVolumeData::CreateFromData(
+               voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, std::move(dat))
+        .result.dat;
+}
+
+/*
+ * 函数: legacyResizeLinear
+ * 功能: 逐体素重新计算坐标与权重的单线程三线性重采样，作为性能与正确性基准
+ */
+static std::vector<uint8_t> legacyResizeLinear(const VIS4Earth::RAWVolumeData &vol,
+                                               const std::array<uint32_t, 3> &voxPerVolOut) {
+    auto voxPerVol = vol.GetVoxelPerVolume();
+    std::array<float, 3> scale = {1.f * voxPerVol[0] / voxPerVolOut[0],
+                                  1.f * voxPerVol[1] / voxPerVolOut[1],
+                                  1.f * voxPerVol[2] / voxPerVolOut[2]};
+    std::vector<uint8_t> out(static_cast<size_t>(voxPerVolOut[0]) * voxPerVolOut[1] *
+                             voxPerVolOut[2]);
+
+    size_t offsOut = 0;
+    for (uint32_t z = 0; z < voxPerVolOut[2]; ++z)
+        for (uint32_t y = 0; y < voxPerVolOut[1]; ++y)
+            for (uint32_t x = 0; x < voxPerVolOut[0]; ++x) {
+                std::array<float, 3> posIn = {scale[0] * x, scale[1] * y, scale[2] * z};
+                std::array<std::array<uint32_t, 2>, 3> posInRng;
+                std::array<float, 3> omegas;
+                for (int i = 0; i < 3; ++i) {
+                    posInRng[i] = {static_cast<uint32_t>(floorf(posIn[i])),
+                                   static_cast<uint32_t>(ceilf(posIn[i]))};
+                    omegas[i] = posInRng[i][1] - posInRng[i][0];
+                    omegas[i] = omegas[i] == 0.f ? 0.f : (posIn[i] - posInRng[i][0]) / omegas[i];
+                }
+
+                auto valIn = 0.f;
+                for (uint8_t zi = 0; zi < 2; ++zi)
+                    for (uint8_t yi = 0; yi < 2; ++yi)
+                        for (uint8_t xi = 0; xi < 2; ++xi) {
+                            auto omega = (zi == 0 ? 1.f - omegas[2] : omegas[2]) *
+                                         (yi == 0 ? 1.f - omegas[1] : omegas[1]) *
+                                         (xi == 0 ? 1.f - omegas[0] : omegas[0]);
+                            valIn += omega * vol.Sample<uint8_t>(posInRng[0][xi], posInRng[1][yi],
+                                                                 posInRng[2][zi]);
+                        }
+                out[offsOut] = static_cast<uint8_t>(std::round(valIn));
+                ++offsOut;
+            }
+
+    return out;
+}
+
+static void benchResize() {
+    std::vector<std::pair<std::array<uint32_t, 3>, std::array<uint32_t, 3>>> cases = {
+        {{300, 350, 50}, {512, 512, 64}}, {{1024, 1024, 1024}, {512, 512, 512}}};
+
+    for (auto &c : cases) {
+        auto vol = genVolume(c.first);
+        auto voxNumOut = static_cast<double>(c.second[0]) * c.second[1] * c.second[2];
+        std::cout << "Resize " << c.first[0] << 'x' << c.first[1] << 'x' << c.first[2] << " -> "
+                  << c.second[0] << 'x' << c.second[1] << 'x' << c.second[2] << std::endl;
+
+        auto start = Clock::now();
+        auto legacy = legacyResizeLinear(vol, c.second);
+        auto legacySec = secondsSince(start);
+
+        start = Clock::now();
+        auto resized = vol.GetResized(VIS4Earth::RAWVolumeData::ResizeParameters{
+            VIS4Earth::RAWVolumeData::EFilterType::Linear, c.second});
+        auto sec = secondsSince(start);
+
+        auto identical =
+            resized.ok && std::equal(legacy.begin(), legacy.end(), resized.result.dat.GetData());
+        std::cout << "  legacy:    " << voxNumOut / legacySec / 1e6 << " Mvox/s" << std::endl;
+        std::cout << "  separable: " << voxNumOut / sec / 1e6 << " Mvox/s ("
+                  << VIS4Earth::ThreadPool::Global().GetThreadNumber() << " threads), "
+                  << (check(identical) ? "bit-identical" : "MISMATCH") << std::endl;
+    }
+}
+
+/*
+ * 函数: legacySmooth
+ * 功能: 逐体素遍历 3x3x3（XY 模式下为 3x3）邻域的光滑，作为性能与正确性基准
+ */
+static std::vector<uint8_t> legacySmooth(const VIS4Earth::RAWVolumeData &vol, bool isAvg,
+                                         bool isXY) {
+    auto voxPerVol = vol.GetVoxelPerVolume();
+    // 邻域坐标可能为负，以有符号整数比较
+    std::array<int32_t, 3> dim = {static_cast<int32_t>(voxPerVol[0]),
+                                  static_cast<int32_t>(voxPerVol[1]),
+                                  static_cast<int32_t>(voxPerVol[2])};
+    std::vector<uint8_t> out(vol.GetDataSize());
+
+    size_t idx = 0;
+    std::array<int32_t, 3> pos;
+    for (pos[2] = 0; pos[2] < dim[2]; ++pos[2])
+        for (pos[1] = 0; pos[1] < dim[1]; ++pos[1])
+            for (pos[0] = 0; pos[0] < dim[0]; ++pos[0]) {
+                uint32_t sum = 0, num = 0;
+                uint8_t maxVal = 0;
+                for (int32_t dz = isXY ? 0 : -1; dz <= (isXY ? 0 : 1); ++dz)
+                    for (int32_t dy = -1; dy <= 1; ++dy)
+                        for (int32_t dx = -1; dx <= 1; ++dx) {
+                            std::array<int32_t, 3> newPos = {pos[0] + dx, pos[1] + dy,
+                                                             pos[2] + dz};
+                            bool valid = true;
+                            for (int i = 0; i < 3; ++i)
+                                valid &= newPos[i] >= 0 && newPos[i] < dim[i];
+                            if (!valid)
+                                continue;
+
+                            auto v = vol.Sample<uint8_t>(newPos[0], newPos[1], newPos[2]);
+                            sum += v;
+                            maxVal = std::max(maxVal, v);
+                            ++num;
+                        }
+                out[idx] = isAvg ? static_cast<uint8_t>(std::round(1.f * sum / num)) : maxVal;
+                ++idx;
+            }
+
+    return out;
+}
+
+static void benchSmooth() {
+    using VolTy = VIS4Earth::RAWVolumeData;
+
+    std::array<uint32_t, 3> voxPerVol = {300, 350, 50};
+    auto vol = genVolume(voxPerVol);
+    auto voxNum = static_cast<double>(vol.GetDataSize());
+    std::cout << "Smooth " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+              << std::endl;
+
+    for (auto type : {VolTy::ESmoothType::Max, VolTy::ESmoothType::Avg})
+        for (auto dim : {VolTy::ESmoothDimension::XYZ, VolTy::ESmoothDimension::XY}) {
+            auto isAvg = type == VolTy::ESmoothType::Avg;
+            auto isXY = dim == VolTy::ESmoothDimension::XY;
+
+            auto start = Clock::now();
+            auto legacy = legacySmooth(vol, isAvg, isXY);
+            auto legacySec = secondsSince(start);
+
+            std::cout << "  " << (isAvg ? "Avg" : "Max") << ' ' << (isXY ? "XY " : "XYZ")
+                      << " brute-force r=1: " << voxNum / legacySec / 1e6 << " Mvox/s"
+                      << std::endl;
+            for (uint32_t radius : {1, 2, 4, 8}) {
+                start = Clock::now();
+                auto smoothed = vol.GetSmoothed(VolTy::SmoothParameters{type, dim, radius});
+                auto sec = secondsSince(start);
+
+                std::cout << "    sliding r=" << radius << ": " << voxNum / sec / 1e6
+                          << " Mvox/s";
+                if (radius == 1) {
+                    // 均值经过逐轴浮点累加，与直接求和相比可能在 .5 处取整不同
+                    int maxDiff = 0;
+                    for (size_t i = 0; i < legacy.size(); ++i)
+                        maxDiff = std::max(maxDiff, std::abs(static_cast<int>(legacy[i]) -
+                                                             smoothed.GetData()[i]));
+                    std::cout << ", max diff " << maxDiff;
+                }
+                std::cout << std::endl;
+            }
+        }
+}
+
+static void benchUpload() {
+    std::vector<std::array<uint32_t, 3>> cases = {{300, 350, 50}, {520, 520, 130}};
+
+    for (auto &voxPerVol : cases) {
+        auto vol = genVolume(voxPerVol);
+        std::cout << "Upload " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+                  << std::endl;
+
+        auto texBytes = [](const osg::ref_ptr<osg::Texture3D> &tex) {
+            auto img = tex->getImage();
+            return static_cast<size_t>(img->s()) * img->t() * img->r();
+        };
+
+        auto start = Clock::now();
+        auto potTex = vol.ToOSGTexture(VIS4Earth::RAWVolumeData::ETextureSizeMode::PowerOfTwo);
+        auto potSec = secondsSince(start);
+
+        start = Clock::now();
+        auto npotTex =
+            vol.ToOSGTexture(VIS4Earth::RAWVolumeData::ETextureSizeMode::NonPowerOfTwo);
+        auto npotSec = secondsSince(start);
+
+        std::cout << "  POT:  " << potSec * 1e3 << " ms, " << texBytes(potTex) << " bytes"
+                  << std::endl;
+        std::cout << "  NPOT: " << npotSec * 1e3 << " ms, " << texBytes(npotTex) << " bytes ("
+                  << texBytes(potTex) - texBytes(npotTex) << " bytes saved)" << std::endl;
+    }
+}
+
+/*
+ * 函数: benchBrick
+ * 功能: 统计砖块元数据的构建耗时与各等值下 marching cube 需遍历的单元比例，
+ *       并验证所有与等值面相交的单元均落在被查询到的砖块内
+ */
+static void benchBrick() {
+    std::array<uint32_t, 3> voxPerVol = {520, 520, 130};
+    auto vol = genVolume(voxPerVol);
+    std::cout << "Brick " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+              << std::endl;
+
+    for (uint32_t brickSize : {16, 32}) {
+        auto start = Clock::now();
+        auto bricked = VIS4Earth::BrickedVolume::Build(vol, brickSize).result.dat;
+        auto sec = secondsSince(start);
+        std::cout << "  size " << brickSize << ": build " << sec * 1e3 << " ms, "
+                  << bricked.GetBrickNumber() << " bricks" << std::endl;
+
+        for (uint32_t isoval : {32, 128, 224}) {
+            auto mask = bricked.GetBrickMask(bricked.QueryIsovalue(static_cast<float>(isoval)));
+
+            size_t cellNum = 0, visitedNum = 0, missedNum = 0;
+            for (uint32_t z = 0; z < voxPerVol[2] - 1; ++z)
+                for (uint32_t y = 0; y < voxPerVol[1] - 1; ++y)
+                    for (uint32_t x = 0; x < voxPerVol[0] - 1; ++x) {
+                        ++cellNum;
+                        auto active = mask[bricked.GetBrickID(x, y, z)] != 0;
+                        visitedNum += active ? 1 : 0;
+
+                        uint8_t inNum = 0;
+                        for (uint32_t i = 0; i < 8; ++i)
+                            inNum += vol.Sample<uint8_t>(x + (i & 1), y + ((i >> 1) & 1),
+                                                         z + ((i >> 2) & 1)) >= isoval
+                                         ? 1
+                                         : 0;
+                        if (inNum != 0 && inNum != 8 && !active)
+                            ++missedNum;
+                    }
+            std::cout << "    iso " << isoval << ": " << 100. * visitedNum / cellNum
+                      << "% cells visited, " << missedNum << " crossing cells missed"
+                      << std::endl;
+        }
+    }
+}
+
+/*
+ * 函数: benchCompress
+ * 功能: 统计不同关键帧间隔下时间序列的压缩率、编码与解码吞吐量，并验证解码结果无损。
+ *       测试序列的低频结构随时间缓慢漂移，噪声不随时间变化，近似气象数据相邻时间步的相关性
+ */
+static void benchCompress() {
+    std::array<uint32_t, 3> voxPerVol = {300, 350, 50};
+    uint32_t timeNum = 32;
+    std::cout << "Compress " << timeNum << " x " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x'
+              << voxPerVol[2] << std::endl;
+
+    std::vector<VIS4Earth::RAWVolumeData> vols;
+    for (uint32_t t = 0; t < timeNum; ++t) {
+        std::vector<uint8_t> dat(static_cast<size_t>(voxPerVol[0]) * voxPerVol[1] *
+                                 voxPerVol[2]);
+        std::mt19937 rng(0);
+        size_t idx = 0;
+        for (uint32_t z = 0; z < voxPerVol[2]; ++z)
+            for (uint32_t y = 0; y < voxPerVol[1]; ++y)
+                for (uint32_t x = 0; x < voxPerVol[0]; ++x) {
+                    auto v = 64.f * (std::sin(.05f * x + .01f * t) + std::cos(.07f * y) +
+                                     std::sin(.11f * z));
+                    dat[idx] = static_cast<uint8_t>(std::min(
+                        255.f, std::max(0.f, 128.f + v + static_cast<float>(rng() % 32))));
+                    ++idx;
+                }
+        vols.emplace_back(VIS4Earth::RAWVolumeData::CreateFromData(
+                              voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, std::move(dat))
+                              .result.dat);
+    }
+    auto rawMB = timeNum * vols.front().GetDataSize() / 1e6;
+
+    for (uint32_t keyframeInterval : {1, 4, 8, 16}) {
+        VIS4Earth::CompressedVolumeSeries series(keyframeInterval);
+        auto start = Clock::now();
+        for (auto &vol : vols)
+            series.Append(vol);
+        auto encSec = secondsSince(start);
+
+        size_t mismatchNum = 0;
+        for (uint32_t t = 0; t < timeNum; ++t) {
+            auto decoded = series.Decode(t);
+            if (!decoded.ok || std::memcmp(decoded.result.dat.GetData(), vols[t].GetData(),
+                                           vols[t].GetDataSize()) != 0)
+                ++mismatchNum;
+        }
+        std::cout << "  keyframe interval " << keyframeInterval << ": ratio "
+                  << series.GetCompressionRatio() << ", encode " << rawMB / encSec
+                  << " MB/s, decode " << series.GetDecodeThroughput() << " MB/s, "
+                  << mismatchNum << " mismatched steps -> " << passOrFail(mismatchNum == 0)
+                  << std::endl;
+    }
+}
+
+/*
+ * 函数: benchPyramid
+ * 功能: 统计体数据金字塔的构建耗时，以及视点由远及近再远离时各距离下选中的砖块数、
+ *       缓存命中与缺失次数和驻留字节数
+ */
+static void benchPyramid() {
+    std::array<uint32_t, 3> voxPerVol = {520, 520, 130};
+    auto vol = genVolume(voxPerVol);
+    std::string filePath = "vbm_pyramid.v4p";
+    std::cout << "Pyramid " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+              << std::endl;
+
+    VIS4Earth::VolumePyramid::Info info;
+    info.brickSize = 32;
+    info.lonRange = {100.f, 120.f};
+    info.latRange = {20.f, 40.f};
+    info.heightRange = {0.f, 100000.f};
+    auto start = Clock::now();
+    auto errMsg = VIS4Earth::VolumePyramidWriter::Build(filePath, vol, info);
+    auto buildSec = secondsSince(start);
+    if (!errMsg.empty()) {
+        std::cerr << errMsg << std::endl;
+        return;
+    }
+
+    {
+        auto pyramid = VIS4Earth::VolumePyramid::Open(filePath).result.dat;
+        std::cout << "  build " << buildSec * 1e3 << " ms, " << pyramid->GetLevelNumber()
+                  << " levels" << std::endl;
+
+        VIS4Earth::PyramidBrickCache cache(pyramid, size_t(16) << 20);
+        VIS4Earth::PyramidBrickCache::LODParameters param;
+        param.lonRange = {VIS4Earth::Math::DegToRad(info.lonRange[0]),
+                          VIS4Earth::Math::DegToRad(info.lonRange[1])};
+        param.latRange = {VIS4Earth::Math::DegToRad(info.latRange[0]),
+                          VIS4Earth::Math::DegToRad(info.latRange[1])};
+        auto rPolar = static_cast<float>(osg::WGS_84_RADIUS_POLAR);
+        param.radiusRange = {rPolar + info.heightRange[0], rPolar + info.heightRange[1]};
+        param.errorThreshold = .002f;
+
+        auto prevStats = cache.GetStatistics();
+        for (float dist : {3e7f, 1e7f, 3e6f, 1e6f, 3e5f, 1e6f, 1e7f}) {
+            param.eyePos = VIS4Earth::Math::BLHToEarthOSGVec3(
+                VIS4Earth::Math::DegToRad(110.f), VIS4Earth::Math::DegToRad(30.f), rPolar + dist);
+            start = Clock::now();
+            cache.Update(param);
+            auto sec = secondsSince(start);
+
+            auto stats = cache.GetStatistics();
+            std::cout << "  eye height " << dist / 1e3 << " km: " << stats.selectedNum
+                      << " bricks, " << stats.hitNum - prevStats.hitNum << " hits, "
+                      << stats.missNum - prevStats.missNum << " misses, " << stats.residentBytes
+                      << " bytes resident, " << sec * 1e3 << " ms" << std::endl;
+            prevStats = stats;
+        }
+    }
+    std::remove(filePath.c_str());
+}
+
+/*
+ * 函数: benchAlloc
+ * 功能: 统计体数据在加载、以结果类型返回、拷贝、存入容器、构建砖块、光滑与导出纹理等环节
+ *       的堆分配次数与字节数。字节数接近体数据大小的整数倍时，说明该环节复制了体素缓冲
+ */
+static void benchAlloc() {
+    std::array<uint32_t, 3> voxPerVol = {300, 350, 50};
+    auto vol = genVolume(voxPerVol);
+    std::string filePath = "vbm_alloc.raw";
+    {
+        std::ofstream os(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        os.write(reinterpret_cast<const char *>(vol.GetData()), vol.GetDataSize());
+    }
+    auto volBytes = static_cast<double>(vol.GetDataSize());
+    std::cout << "Alloc " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2] << " ("
+              << vol.GetDataSize() << " bytes)" << std::endl;
+
+    auto measure = [&](const char *name, const std::function<void()> &fn) {
+        auto num = allocNum.load();
+        auto bytes = allocBytes.load();
+        fn();
+        num = allocNum.load() - num;
+        bytes = allocBytes.load() - bytes;
+        std::cout << "  " << name << ": " << num << " allocations, " << bytes << " bytes ("
+                  << bytes / volBytes << " volumes)" << std::endl;
+    };
+
+    {
+        std::vector<VIS4Earth::ReteurnOrError<VIS4Earth::RAWVolumeData>> loadeds;
+        loadeds.reserve(1);
+        measure("load", [&]() {
+            loadeds.emplace_back(VIS4Earth::RAWVolumeData::LoadFromFile(
+                VIS4Earth::RAWVolumeData::FromFileParameters{
+                    voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, filePath,
+                    VIS4Earth::RAWVolumeData::EStorageMode::InMemory,
+                    VIS4Earth::MappedFile::EAccessHint::Sequential}));
+        });
+        auto &loaded = loadeds.front();
+        measure("copy result", [&]() { auto copied = loaded; });
+        std::vector<VIS4Earth::RAWVolumeData> volCPUs;
+        volCPUs.reserve(2);
+        measure("store copy", [&]() { volCPUs.emplace_back(loaded.result.dat); });
+        measure("store move", [&]() { volCPUs.emplace_back(std::move(loaded.result.dat)); });
+
+        auto &stored = volCPUs.front();
+        VIS4Earth::BrickedVolume bricked;
+        measure("brick", [&]() {
+            auto volBricked = VIS4Earth::BrickedVolume::Build(stored);
+            bricked = std::move(volBricked.result.dat);
+        });
+        measure("smooth", [&]() {
+            stored.GetSmoothed(VIS4Earth::RAWVolumeData::SmoothParameters{
+                VIS4Earth::RAWVolumeData::ESmoothType::Avg,
+                VIS4Earth::RAWVolumeData::ESmoothDimension::XYZ, 1});
+        });
+        osg::ref_ptr<osg::Texture3D> tex;
+        measure("texture (NPOT)", [&]() {
+            tex = stored.ToOSGTexture(VIS4Earth::RAWVolumeData::ETextureSizeMode::NonPowerOfTwo);
+        });
+
+        // 缓冲被其他体数据与纹理共享，首次写入复制一次，此后独占，不再复制
+        measure("write shared", [&]() { stored.GetMutableData()[0] = 0; });
+        measure("write unique", [&]() { stored.GetMutableData()[0] = 1; });
+    }
+    std::remove(filePath.c_str());
+}
+
+/*
+ * 函数: convertVolume
+ * 功能: 将 UInt8 体数据按归一化值转换为体素类型 T，供不同类型之间比较
+ */
+template <typename T>
+static VIS4Earth::RAWVolumeData convertVolume(const VIS4Earth::RAWVolumeData &volU8) {
+    std::vector<T> dat(volU8.GetDataSize());
+    auto scale = VIS4Earth::VoxelTypeTraits<T>::Max() / 255.f;
+    for (size_t i = 0; i < dat.size(); ++i)
+        dat[i] = VIS4Earth::VoxelTypeTraits<T>::FromFloat(volU8.GetData()[i] * scale);
+    return VIS4Earth::RAWVolumeData::CreateFromVoxels(volU8.GetVoxelPerVolume(), std::move(dat))
+        .result.dat;
+}
+
+/*
+ * 函数: maxNormalizedDiff
+ * 功能: 返回两个体数据按各自类型归一化后的最大差值
+ */
+template <typename T>
+static float maxNormalizedDiff(const VIS4Earth::RAWVolumeData &vol,
+                               const VIS4Earth::RAWVolumeData &volU8) {
+    auto dat = reinterpret_cast<const T *>(vol.GetData());
+    auto maxDiff = 0.f;
+    for (size_t i = 0; i < volU8.GetDataSize(); ++i)
+        maxDiff = std::max(maxDiff, std::abs(dat[i] / VIS4Earth::VoxelTypeTraits<T>::Max() -
+                                             volU8.GetData()[i] / 255.f));
+    return maxDiff;
+}
+
+/*
+ * 函数: benchVoxelType
+ * 功能: 以同一归一化体数据比较 UInt8、UInt16、Float32 三种体素类型下重采样、光滑与构建砖块的
+ *       吞吐量，并检查结果与 UInt8 之差不超过 UInt8 的量化误差
+ */
+template <typename T>
+static void benchVoxelType(const char *name, const VIS4Earth::RAWVolumeData &volU8,
+                           const VIS4Earth::RAWVolumeData &resizedU8,
+                           const VIS4Earth::RAWVolumeData &smoothedU8) {
+    auto vol = std::is_same<T, uint8_t>::value ? volU8 : convertVolume<T>(volU8);
+    auto voxNum = static_cast<double>(vol.GetDataSize() / vol.GetVoxelSize());
+    auto targetVoxPerVol = resizedU8.GetVoxelPerVolume();
+
+    auto start = Clock::now();
+    auto resized = vol.GetResized(VIS4Earth::RAWVolumeData::ResizeParameters{
+        VIS4Earth::RAWVolumeData::EFilterType::Linear, targetVoxPerVol});
+    auto resizeSec = secondsSince(start);
+
+    start = Clock::now();
+    auto smoothed = vol.GetSmoothed(VIS4Earth::RAWVolumeData::SmoothParameters{
+        VIS4Earth::RAWVolumeData::ESmoothType::Avg,
+        VIS4Earth::RAWVolumeData::ESmoothDimension::XYZ, 1});
+    auto smoothSec = secondsSince(start);
+
+    start = Clock::now();
+    auto bricked = VIS4Earth::BrickedVolume::Build(vol);
+    auto brickSec = secondsSince(start);
+
+    auto maxDiff = std::max(maxNormalizedDiff<T>(resized.result.dat, resizedU8),
+                            maxNormalizedDiff<T>(smoothed, smoothedU8));
+    std::cout << "  " << name << ": resize "
+              << resized.result.dat.GetDataSize() / resized.result.dat.GetVoxelSize() /
+                     resizeSec / 1e6
+              << " Mvox/s, smooth " << voxNum / smoothSec / 1e6 << " Mvox/s, brick "
+              << voxNum / brickSec / 1e6 << " Mvox/s, max diff to UInt8 " << maxDiff
+              << (check(bricked.ok && maxDiff <= .5f / 255.f + 1e-5f) ? "" : " MISMATCH")
+              << std::endl;
+}
+
+static void benchVoxelTypes() {
+    std::array<uint32_t, 3> voxPerVol = {300, 350, 50};
+    auto volU8 = genVolume(voxPerVol);
+    std::cout << "VoxelType " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+              << std::endl;
+
+    auto resizedU8 = volU8.GetResized(VIS4Earth::RAWVolumeData::ResizeParameters{
+        VIS4Earth::RAWVolumeData::EFilterType::Linear, {512, 512, 64}});
+    auto smoothedU8 = volU8.GetSmoothed(VIS4Earth::RAWVolumeData::SmoothParameters{
+        VIS4Earth::RAWVolumeData::ESmoothType::Avg,
+        VIS4Earth::RAWVolumeData::ESmoothDimension::XYZ, 1});
+    benchVoxelType<uint8_t>("UInt8  ", volU8, resizedU8.result.dat, smoothedU8);
+    benchVoxelType<uint16_t>("UInt16 ", volU8, resizedU8.result.dat, smoothedU8);
+    benchVoxelType<float>("Float32", volU8, resizedU8.result.dat, smoothedU8);
+}
+
+/*
+ * 结构体: LegacyLabeledTXT
+ * 功能: legacyLoadLabeledTXT 的结果，字段含义同 LabeledTXTVolume
+ */
+struct LegacyLabeledTXT {
+    std::array<uint32_t, 3> dim;
+    std::array<std::array<float, 2>, 4> rngs; // 值、高度、纬度、经度
+    std::vector<float> dat;
+};
+
+/*
+ * 函数: legacyLoadLabeledTXT
+ * 功能: 以 getline 与 sscanf 逐行读取、逐个插入哈希集合统计尺寸的单线程解析，作为基准
+ */
+static LegacyLabeledTXT legacyLoadLabeledTXT(const std::string &filePath) {
+    LegacyLabeledTXT ret;
+    for (auto &rng : ret.rngs)
+        rng = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()};
+    auto computeMinMax = [](std::array<float, 2> &rng, float val) {
+        if (rng[0] > val)
+            rng[0] = val;
+        if (rng[1] < val)
+            rng[1] = val;
+    };
+
+    std::ifstream is(filePath, std::ios::in);
+    std::unordered_set<float> hSets, latSets, lonSets;
+    std::string buf;
+    std::getline(is, buf);
+    while (std::getline(is, buf)) {
+        std::array<float, 5> f5;
+        auto validRead = sscanf(buf.c_str(), "%f%f%f%f%f", &f5[0], &f5[1], &f5[2], &f5[3], &f5[4]);
+        if (validRead < 4)
+            continue;
+
+        hSets.emplace(f5[1]);
+        latSets.emplace(f5[2]);
+        lonSets.emplace(f5[3]);
+        for (int i = 1; i < 4; ++i)
+            computeMinMax(ret.rngs[i], f5[i]);
+        if (validRead == 5)
+            computeMinMax(ret.rngs[0], f5[4]);
+        else
+            f5[4] = std::numeric_limits<float>::quiet_NaN();
+        ret.dat.emplace_back(f5[4]);
+    }
+    ret.dim = {static_cast<uint32_t>(lonSets.size()), static_cast<uint32_t>(latSets.size()),
+               static_cast<uint32_t>(hSets.size())};
+    return ret;
+}
+
+/*
+ * 函数: benchLabeledTXT
+ * 功能: 比较带标签 TXT 体数据的逐行解析、并行解析与旁路缓存加载的吞吐量（按文本大小计），
+ *       并检查三者的尺寸、范围与数据一致（NaN 视为相等）
+ */
+static void benchLabeledTXT() {
+    using LabeledTXTVolume = VIS4Earth::Loader::LabeledTXTVolume;
+
+    std::array<uint32_t, 3> dim = {256, 256, 32};
+    std::string filePath = "vbm_labeled.txt";
+    {
+        std::ofstream os(filePath, std::ios::out | std::ios::trunc);
+        os << "id height lat lon val\n";
+        std::mt19937 rng(0);
+        char line[128];
+        uint64_t id = 0;
+        for (uint32_t z = 0; z < dim[2]; ++z)
+            for (uint32_t y = 0; y < dim[1]; ++y)
+                for (uint32_t x = 0; x < dim[0]; ++x, ++id) {
+                    auto lat = 10.f + .125f * y;
+                    auto lon = 100.f + .125f * x;
+                    auto idLL = static_cast<unsigned long long>(id);
+                    if (rng() % 97 == 0) // 缺测值
+                        std::snprintf(line, sizeof(line), "%llu %.1f %.3f %.3f\n", idLL,
+                                      500.f * z, lat, lon);
+                    else
+                        std::snprintf(line, sizeof(line), "%llu %.1f %.3f %.3f %.6g\n", idLL,
+                                      500.f * z, lat, lon,
+                                      300.f * std::sin(.05f * x) * std::cos(.07f * y) -
+                                          2.5e-3f * (rng() % 1000));
+                    os << line;
+                }
+    }
+    auto txtMB = 0.;
+    {
+        std::ifstream is(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+        txtMB = static_cast<double>(is.tellg()) / (1 << 20);
+    }
+    std::remove(LabeledTXTVolume::GetSidecarPath(filePath).c_str());
+    std::cout << "LabeledTXT " << dim[0] << 'x' << dim[1] << 'x' << dim[2] << " (" << txtMB
+              << " MB)" << std::endl;
+
+    auto start = Clock::now();
+    auto legacy = legacyLoadLabeledTXT(filePath);
+    auto legacySec = secondsSince(start);
+
+    start = Clock::now();
+    auto parsed = LabeledTXTVolume::ParseFromFile(filePath);
+    auto parseSec = secondsSince(start);
+
+    start = Clock::now();
+    auto firstLoaded = LabeledTXTVolume::LoadFromFile(filePath);
+    auto firstSec = secondsSince(start);
+
+    start = Clock::now();
+    auto cached = LabeledTXTVolume::LoadFromFile(filePath);
+    auto cachedSec = secondsSince(start);
+
+    auto matches = [&](const LabeledTXTVolume &vol) {
+        std::array<const std::array<float, 2> *, 4> rngs = {&vol.valRng, &vol.hRng, &vol.latRng,
+                                                            &vol.lonRng};
+        for (int i = 0; i < 4; ++i)
+            if (*rngs[i] != legacy.rngs[i])
+                return false;
+        if (vol.dim != legacy.dim || vol.dat.size() != legacy.dat.size())
+            return false;
+        for (size_t i = 0; i < vol.dat.size(); ++i)
+            if (vol.dat[i] != legacy.dat[i] &&
+                !(std::isnan(vol.dat[i]) && std::isnan(legacy.dat[i])))
+                return false;
+        return true;
+    };
+    std::cout << "  getline+sscanf: " << txtMB / legacySec << " MB/s" << std::endl;
+    std::cout << "  parallel parse: " << txtMB / parseSec << " MB/s ("
+              << VIS4Earth::ThreadPool::Global().GetThreadNumber() << " threads), "
+              << (check(matches(parsed)) ? "identical" : "MISMATCH") << std::endl;
+    std::cout << "  parse + sidecar write: " << txtMB / firstSec << " MB/s" << std::endl;
+    std::cout << "  sidecar load: " << txtMB / cachedSec << " MB/s, "
+              << (check(matches(cached) && matches(firstLoaded)) ? "identical" : "MISMATCH")
+              << std::endl;
+
+    std::remove(LabeledTXTVolume::GetSidecarPath(filePath).c_str());
+    std::remove(filePath.c_str());
+}
+
+/*
+ * 函数: legacyLoadPar
+ * 功能: 原 TXTVolume::LoadFromParFile 的逐行 stringstream 解析，作为性能与正确性基准
+ */
+static std::vector<std::pair<osg::Vec3f, float>> legacyLoadPar(const std::string &filePath) {
+    std::ifstream is(filePath);
+    std::string line;
+    std::vector<std::pair<osg::Vec3f, float>> ret;
+    while (std::getline(is, line)) {
+        float lon, lat, t, data;
+        std::stringstream ss(line);
+        ss >> lon;
+        ss >> lat;
+        ss >> t;
+        ss >> data;
+        ret.push_back(std::make_pair(osg::Vec3f(lon, lat, data), t));
+    }
+    return ret;
+}
+
+/*
+ * 函数: benchPointTXT
+ * 功能: 比较点云文本的逐行解析与流式并行解析的吞吐量，给出流式加载交付首批的延迟与
+ *       单批的最大内存占用，并检查结果一致
+ */
+static void benchPointTXT() {
+    using TXTVolume = VIS4Earth::Loader::TXTVolume;
+
+    uint32_t rowNum = 1000000;
+    std::string filePath = "vbm_points.txt";
+    {
+        std::ofstream os(filePath, std::ios::out | std::ios::trunc);
+        std::mt19937 rng(0);
+        char line[128];
+        for (uint32_t i = 0; i < rowNum; ++i) {
+            std::snprintf(line, sizeof(line), "%.4f %.4f %u %.6g\n",
+                          100.f + .001f * (rng() % 20000), 20.f + .001f * (rng() % 20000),
+                          i / 1000, .01f * (rng() % 100000));
+            os << line;
+        }
+    }
+    auto txtMB = 0.;
+    {
+        std::ifstream is(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+        txtMB = static_cast<double>(is.tellg()) / (1 << 20);
+    }
+    std::cout << "PointTXT " << rowNum << " rows (" << txtMB << " MB, "
+              << VIS4Earth::ThreadPool::Global().GetThreadNumber() << " threads)" << std::endl;
+
+    auto start = Clock::now();
+    auto legacy = legacyLoadPar(filePath);
+    auto legacySec = secondsSince(start);
+
+    start = Clock::now();
+    auto loaded = TXTVolume::LoadFromParFile(filePath);
+    auto loadSec = secondsSince(start);
+
+    TXTVolume::StreamParameters param;
+    param.colNum = 4;
+    size_t streamedNum = 0, maxBatchBytes = 0;
+    auto firstBatchSec = 0.;
+    start = Clock::now();
+    TXTVolume::Stream(filePath, param, [&](TXTVolume::PointBatch &&batch) {
+        if (streamedNum == 0)
+            firstBatchSec = secondsSince(start);
+        streamedNum += batch.GetPointNumber();
+        maxBatchBytes = std::max(maxBatchBytes, 4 * sizeof(float) * batch.cols[0].capacity());
+        return true;
+    });
+    auto streamSec = secondsSince(start);
+
+    auto identical = legacy.size() == loaded.size() && streamedNum == loaded.size();
+    for (size_t i = 0; identical && i < legacy.size(); ++i)
+        identical = legacy[i] == loaded[i];
+    std::cout << "  getline+stringstream: " << txtMB / legacySec << " MB/s" << std::endl;
+    std::cout << "  LoadFromParFile: " << txtMB / loadSec << " MB/s, "
+              << (check(identical) ? "identical" : "MISMATCH") << std::endl;
+    std::cout << "  Stream: " << txtMB / streamSec << " MB/s, first batch after "
+              << 1000. * firstBatchSec << " ms, max batch " << maxBatchBytes / double(1 << 20)
+              << " MB" << std::endl;
+
+    std::remove(filePath.c_str());
+}
+
+/*
+ * 函数: benchGridding
+ * 功能: 以解析场上的随机散点测试反距离加权与普通克里金插值的吞吐量（按散点数与体素数计）
+ *       及相对解析场的均方根误差，并以暴力搜索检查 k-d 树的近邻查询
+ */
+static void benchGridding() {
+    using ScatteredGridder = VIS4Earth::ScatteredGridder;
+
+    std::array<uint32_t, 3> voxPerVol = {64, 64, 32};
+    std::array<float, 2> lonRng = {100.f, 120.f}, latRng = {20.f, 40.f}, hRng = {0.f, 1e4f};
+    auto field = [](float lon, float lat, float h) {
+        return std::sin(.3f * lon) * std::cos(.3f * lat) + h / 1e4f;
+    };
+
+    auto gen = [&](uint32_t sampleNum, std::vector<std::array<float, 3>> &coords,
+                   std::vector<float> &vals) {
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> uni(0.f, 1.f);
+        coords.resize(sampleNum);
+        vals.resize(sampleNum);
+        for (uint32_t i = 0; i < sampleNum; ++i) {
+            coords[i] = {lonRng[0] + (lonRng[1] - lonRng[0]) * uni(rng),
+                         latRng[0] + (latRng[1] - latRng[0]) * uni(rng),
+                         hRng[0] + (hRng[1] - hRng[0]) * uni(rng)};
+            vals[i] = field(coords[i][0], coords[i][1], coords[i][2]);
+        }
+    };
+    auto rmsError = [&](const VIS4Earth::RAWVolumeData &vol, const std::vector<float> &vals) {
+        auto minMax = std::minmax_element(vals.begin(), vals.end());
+        auto dat = reinterpret_cast<const float *>(vol.GetData());
+        double sqrErrSum = 0.;
+        size_t idx = 0;
+        for (uint32_t z = 0; z < voxPerVol[2]; ++z)
+            for (uint32_t y = 0; y < voxPerVol[1]; ++y)
+                for (uint32_t x = 0; x < voxPerVol[0]; ++x, ++idx) {
+                    auto val = field(lonRng[0] + (lonRng[1] - lonRng[0]) * x / (voxPerVol[0] - 1),
+                                     latRng[0] + (latRng[1] - latRng[0]) * y / (voxPerVol[1] - 1),
+                                     hRng[0] + (hRng[1] - hRng[0]) * z / (voxPerVol[2] - 1));
+                    auto err = dat[idx] - (val - *minMax.first) / (*minMax.second - *minMax.first);
+                    sqrErrSum += err * err;
+                }
+        return std::sqrt(sqrErrSum / idx);
+    };
+
+    std::vector<std::array<float, 3>> coords;
+    std::vector<float> vals;
+    for (uint32_t sampleNum : {2000u, 1000000u}) {
+        gen(sampleNum, coords, vals);
+        std::cout << "Gridding " << sampleNum << " samples into " << voxPerVol[0] << 'x'
+                  << voxPerVol[1] << 'x' << voxPerVol[2] << " ("
+                  << VIS4Earth::ThreadPool::Global().GetThreadNumber() << " threads)" << std::endl;
+
+        ScatteredGridder::Parameters param;
+        param.voxPerVol = voxPerVol;
+        param.lonRng = lonRng;
+        param.latRng = latRng;
+        param.hRng = hRng;
+        for (auto method : {ScatteredGridder::EMethod::InverseDistance,
+                            ScatteredGridder::EMethod::OrdinaryKriging}) {
+            param.method = method;
+            ScatteredGridder::Statistics stats;
+            auto vol = ScatteredGridder::Grid(coords, vals, param, &stats);
+            if (!vol.ok) {
+                std::cerr << vol.result.errMsg << std::endl;
+                return;
+            }
+
+            std::cout << (method == ScatteredGridder::EMethod::InverseDistance ? "  IDW: "
+                                                                               : "  kriging: ")
+                      << "build " << stats.buildSeconds << " s, grid " << stats.gridSeconds
+                      << " s, " << stats.samplesPerSecond << " samples/s, "
+                      << stats.voxelsPerSecond << " voxels/s, RMS error "
+                      << rmsError(vol.result.dat, vals);
+            if (method == ScatteredGridder::EMethod::OrdinaryKriging)
+                std::cout << ", " << stats.solveNum << " solves (" << stats.reusedSolveNum
+                          << " reused)";
+            std::cout << std::endl;
+        }
+    }
+
+    // 在体素坐标系下构建 k-d 树，与暴力搜索逐一比较最近邻的距离
+    gen(20000, coords, vals);
+    std::vector<std::array<float, 3>> poss(coords.size());
+    for (size_t i = 0; i < coords.size(); ++i)
+        poss[i] = {(coords[i][0] - lonRng[0]) / (lonRng[1] - lonRng[0]) * (voxPerVol[0] - 1),
+                   (coords[i][1] - latRng[0]) / (latRng[1] - latRng[0]) * (voxPerVol[1] - 1),
+                   (coords[i][2] - hRng[0]) / (hRng[1] - hRng[0]) * (voxPerVol[2] - 1)};
+    auto tree = VIS4Earth::PointKDTree::Build(poss);
+    std::mt19937 rng(1);
+    std::vector<VIS4Earth::PointKDTree::Neighbor> nbrs;
+    std::vector<float> sqrDists(poss.size());
+    auto mismatchNum = 0;
+    for (int q = 0; q < 200; ++q) {
+        std::array<float, 3> pos = {static_cast<float>(rng() % voxPerVol[0]),
+                                    static_cast<float>(rng() % voxPerVol[1]),
+                                    static_cast<float>(rng() % voxPerVol[2])};
+        tree.KNearest(pos, 12, nbrs);
+        if (nbrs.size() != 12) {
+            ++mismatchNum;
+            continue;
+        }
+        for (size_t i = 0; i < poss.size(); ++i) {
+            sqrDists[i] = 0.f;
+            for (int a = 0; a < 3; ++a)
+                sqrDists[i] += (poss[i][a] - pos[a]) * (poss[i][a] - pos[a]);
+        }
+        std::partial_sort(sqrDists.begin(), sqrDists.begin() + 12, sqrDists.end());
+        for (size_t i = 0; i < 12; ++i) {
+            auto &p = poss[tree.GetSourceIndex(nbrs[i].id)];
+            auto sqrDist = 0.f;
+            for (int a = 0; a < 3; ++a)
+                sqrDist += (p[a] - pos[a]) * (p[a] - pos[a]);
+            if (sqrDist != sqrDists[i] || nbrs[i].sqrDist != sqrDists[i])
+                ++mismatchNum;
+        }
+    }
+    std::cout << "  k-d tree 12-NN vs brute force: "
+              << (check(mismatchNum == 0) ? "identical" : "MISMATCH") << std::endl;
+}
+
+/*
+ * 函数: sampleTrilinear
+ * 功能: 按 GL 的纹理坐标约定（体素中心位于 (i + .5) / n，边界外取边界体素）三线性采样
+ *       每个体素 chNum 个通道的数组，写入 out 的前 chNum 个元素
+ */
+template <typename T>
+static void sampleTrilinear(const T *dat, const std::array<uint32_t, 3> &voxPerVol, int chNum,
+                            const std::array<float, 3> &pos, float *out) {
+    std::array<uint32_t, 3> i0, i1;
+    std::array<float, 3> w;
+    for (int a = 0; a < 3; ++a) {
+        auto v = std::min(std::max(pos[a] * voxPerVol[a] - .5f, 0.f), voxPerVol[a] - 1.f);
+        i0[a] = static_cast<uint32_t>(v);
+        i1[a] = std::min(i0[a] + 1, voxPerVol[a] - 1);
+        w[a] = v - i0[a];
+    }
+    for (int c = 0; c < chNum; ++c)
+        out[c] = 0.f;
+    for (int corner = 0; corner < 8; ++corner) {
+        auto x = corner & 1 ? i1[0] : i0[0];
+        auto y = corner & 2 ? i1[1] : i0[1];
+        auto z = corner & 4 ? i1[2] : i0[2];
+        auto wgt = (corner & 1 ? w[0] : 1.f - w[0]) * (corner & 2 ? w[1] : 1.f - w[1]) *
+                   (corner & 4 ? w[2] : 1.f - w[2]);
+        auto texel = dat + ((static_cast<size_t>(z) * voxPerVol[1] + y) * voxPerVol[0] + x) * chNum;
+        for (int c = 0; c < chNum; ++c)
+            out[c] += wgt * texel[c];
+    }
+}
+
+/*
+ * 函数: benchGradient
+ * 功能: 统计预计算梯度的吞吐量，并在随机采样点上按着色器的方式比较两种求法向的 CPU 开销
+ *       （中心差分 6 次体数据采样与梯度纹理 1 次采样）和二者法向的夹角
+ */
+static void benchGradient() {
+    std::vector<std::array<uint32_t, 3>> cases = {{300, 350, 50}, {520, 520, 130}};
+
+    for (auto &voxPerVol : cases) {
+        auto vol = genVolume(voxPerVol);
+        auto voxNum = static_cast<double>(vol.GetDataSize());
+        std::cout << "Gradient " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+                  << std::endl;
+
+        auto start = Clock::now();
+        auto grad = VIS4Earth::GradientVolume::Compute(vol).result.dat;
+        auto sec = secondsSince(start);
+        std::cout << "  precompute: " << sec * 1e3 << " ms, " << voxNum / sec / 1e6
+                  << " Mvox/s, " << grad.GetByteSize() / (1024. * 1024.) << " MB" << std::endl;
+
+        static const int SampleNum = 1 << 20;
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> dist(0.f, 1.f);
+        std::vector<std::array<float, 3>> poss(SampleNum);
+        for (auto &pos : poss)
+            pos = {dist(rng), dist(rng), dist(rng)};
+
+        auto volDat = vol.GetData();
+        std::vector<std::array<float, 3>> centralNs(SampleNum);
+        start = Clock::now();
+        for (int i = 0; i < SampleNum; ++i)
+            for (int a = 0; a < 3; ++a) {
+                auto p = poss[i];
+                float v0, v1;
+                p[a] = poss[i][a] + 1.f / voxPerVol[a];
+                sampleTrilinear(volDat, voxPerVol, 1, p, &v1);
+                p[a] = poss[i][a] - 1.f / voxPerVol[a];
+                sampleTrilinear(volDat, voxPerVol, 1, p, &v0);
+                centralNs[i][a] = v1 - v0;
+            }
+        auto centralSec = secondsSince(start);
+
+        // 与纹理单元一致，先将 10 位分量解包为归一化的定点值再插值
+        std::vector<std::array<float, 3>> texels(grad.GetData().size());
+        for (size_t i = 0; i < texels.size(); ++i)
+            for (int a = 0; a < 3; ++a)
+                texels[i][a] = ((grad.GetData()[i] >> (10 * a)) & 1023u) / 1023.f;
+        std::vector<std::array<float, 3>> gradNs(SampleNum);
+        start = Clock::now();
+        for (int i = 0; i < SampleNum; ++i) {
+            sampleTrilinear(texels.data()->data(), voxPerVol, 3, poss[i], gradNs[i].data());
+            for (int a = 0; a < 3; ++a)
+                gradNs[i][a] = gradNs[i][a] * 2.f - 1.f;
+        }
+        auto gradSec = secondsSince(start);
+
+        // 跳过梯度为 0 的采样点，其方向不确定
+        std::vector<float> errs;
+        errs.reserve(SampleNum);
+        for (int i = 0; i < SampleNum; ++i) {
+            auto &n0 = centralNs[i];
+            auto &n1 = gradNs[i];
+            auto len0 = std::sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+            auto len1 = std::sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+            if (len0 < 1e-3f || len1 < 1e-3f)
+                continue;
+            auto cosA = (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2]) / (len0 * len1);
+            auto err = std::acos(std::min(1.f, cosA)) * 180.f / static_cast<float>(osg::PI);
+            errs.emplace_back(err);
+        }
+        std::cout << "  normals of " << SampleNum << " samples: central diff "
+                  << centralSec * 1e3 << " ms, gradient texture " << gradSec * 1e3 << " ms ("
+                  << centralSec / gradSec << "x)" << std::endl;
+        // 梯度接近 0 处的方向受量化影响大，以分位数代替最大值
+        double errSum = 0.;
+        for (auto err : errs)
+            errSum += err;
+        auto p99 = errs.begin() + errs.size() * 99 / 100;
+        std::nth_element(errs.begin(), p99, errs.end());
+        std::cout << "  angle to central diff: mean " << errSum / std::max<size_t>(errs.size(), 1)
+                  << " deg, p99 " << *p99 << " deg over " << errs.size() << " samples"
+                  << std::endl;
+    }
+}
+
+/*
+ * 函数: benchAmbientOcclusion
+ * 功能: 统计环境光遮蔽体的完整计算耗时，以及只修改传输函数中一段下标范围后增量更新的耗时，
+ *       并与按新传输函数完整计算的结果比较，验证增量更新不遗漏单元
+ */
+static void benchAmbientOcclusion() {
+    std::vector<std::array<uint32_t, 3>> cases = {{300, 350, 50}, {520, 520, 130}};
+
+    VIS4Earth::TransferFunctionData tf;
+    tf.ReplaceOrSetPoint(0, 0, {0.f, 0.f, 0.f, 0.f});
+    tf.ReplaceOrSetPoint(100, 100, {1.f, 1.f, 1.f, 0.f});
+    tf.ReplaceOrSetPoint(160, 160, {1.f, 1.f, 1.f, .8f});
+    tf.ReplaceOrSetPoint(240, 240, {1.f, 1.f, 1.f, .8f});
+    tf.ReplaceOrSetPoint(248, 248, {1.f, 1.f, 1.f, .8f});
+    tf.ReplaceOrSetPoint(255, 255, {1.f, 1.f, 1.f, .8f});
+    // 仅修改 (240, 255) 内的不透明度，模拟拖动传输函数编辑器中的一个控制点
+    auto tfEdited = tf;
+    tfEdited.ReplaceOrSetPoint(248, 248, {1.f, 1.f, 1.f, .2f});
+
+    for (auto &voxPerVol : cases) {
+        auto vol = genVolume(voxPerVol);
+        std::cout << "AO " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x' << voxPerVol[2]
+                  << std::endl;
+
+        VIS4Earth::AmbientOcclusionVolume::Parameters param;
+        VIS4Earth::AmbientOcclusionVolume::Statistics stats;
+        auto ao = VIS4Earth::AmbientOcclusionVolume::Compute(vol, tf, param, &stats).result.dat;
+        std::cout << "  full: " << stats.milliseconds << " ms, "
+                  << vol.GetDataSize() / (stats.milliseconds * 1e3) << " Mvox/s" << std::endl;
+
+        stats = ao.Update(vol, tfEdited);
+        std::cout << "  incremental: " << stats.milliseconds << " ms, " << stats.updatedCellNum
+                  << '/' << stats.cellNum << " cells" << std::endl;
+
+        auto ref =
+            VIS4Earth::AmbientOcclusionVolume::Compute(vol, tfEdited, param).result.dat;
+        int maxDiff = 0;
+        for (size_t i = 0; i < ao.GetByteSize(); ++i)
+            maxDiff = std::max(maxDiff, std::abs(static_cast<int>(ao.GetData()[i]) -
+                                                 static_cast<int>(ref.GetData()[i])));
+        std::cout << "  max diff to full recompute: " << maxDiff << std::endl;
+    }
+}
+
+/*
+ * 函数: benchAdaptiveStep
+ * 功能: 在 CPU 上按着色器的方式沿随机光线投射（不透明度按步长倍数校正，累积不透明度超过 .95 时终止），
+ *       比较按宏单元自适应步长与采样数相同的均匀步长相对于基准步长的误差
+ */
+static void benchAdaptiveStep() {
+    static const float MaxStepScale = 4.f;
+    static const float FineStep = .5f;
+    static const int RayNum = 1 << 14;
+
+    // 100 至 160 缓慢升高，200 至 208 为一个窄的红色尖峰
+    VIS4Earth::TransferFunctionData tf;
+    tf.ReplaceOrSetPoint(0, 0, {0.f, 0.f, 0.f, 0.f});
+    tf.ReplaceOrSetPoint(100, 100, {.2f, .4f, 1.f, 0.f});
+    tf.ReplaceOrSetPoint(160, 160, {.2f, .4f, 1.f, .02f});
+    tf.ReplaceOrSetPoint(200, 200, {.2f, .4f, 1.f, .02f});
+    tf.ReplaceOrSetPoint(204, 204, {1.f, 0.f, 0.f, .6f});
+    tf.ReplaceOrSetPoint(208, 208, {.2f, .4f, 1.f, .02f});
+    tf.ReplaceOrSetPoint(255, 255, {.2f, .4f, 1.f, .02f});
+    auto &flatDat = tf.GetFlatData();
+
+    std::vector<std::array<uint32_t, 3>> cases = {{300, 350, 50}, {256, 256, 256}};
+    for (auto &voxPerVol : cases) {
+        auto vol = genVolume(voxPerVol);
+        auto cells = VIS4Earth::MacroCellGrid::Build(vol).result.dat;
+        auto scales = cells.ComputeStepScales(tf, MaxStepScale);
+        auto &cellPerVol = cells.GetCellPerVolume();
+        std::cout << "Adaptive step " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x'
+                  << voxPerVol[2] << std::endl;
+
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> dist(0.f, 1.f);
+        std::vector<std::array<float, 6>> rays(RayNum);
+        for (auto &ray : rays) {
+            std::array<float, 3> dir = {dist(rng) - .5f, dist(rng) - .5f, 1.f};
+            auto len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+            ray = {dist(rng) * voxPerVol[0], dist(rng) * voxPerVol[1], 0.f,
+                   dir[0] / len,           dir[1] / len,           dir[2] / len};
+        }
+
+        // 写入各光线的颜色并返回总采样数，scaleOf 给出体素坐标 p 处的步长倍数
+        auto march = [&](const std::function<float(const std::array<float, 3> &)> &scaleOf,
+                         std::vector<std::array<float, 4>> &colors) -> size_t {
+            size_t sampleNum = 0;
+            colors.assign(RayNum, {0.f, 0.f, 0.f, 0.f});
+            for (int r = 0; r < RayNum; ++r) {
+                auto &ray = rays[r];
+                auto &color = colors[r];
+                for (float t = 0.f;;) {
+                    std::array<float, 3> p = {ray[0] + t * ray[3], ray[1] + t * ray[4],
+                                              ray[2] + t * ray[5]};
+                    if (p[0] < 0.f || p[1] < 0.f || p[0] >= voxPerVol[0] ||
+                        p[1] >= voxPerVol[1] || p[2] >= voxPerVol[2] || color[3] > .95f)
+                        break;
+
+                    float scalar;
+                    sampleTrilinear(vol.GetData(), voxPerVol, 1,
+                                    {p[0] / voxPerVol[0], p[1] / voxPerVol[1], p[2] / voxPerVol[2]},
+                                    &scalar);
+                    auto idx = std::min(scalar, 254.999f);
+                    auto i0 = static_cast<int>(idx);
+                    auto w = idx - i0;
+                    std::array<float, 4> tfCol;
+                    for (int c = 0; c < 4; ++c)
+                        tfCol[c] = (1.f - w) * flatDat[i0][c] + w * flatDat[i0 + 1][c];
+
+                    auto scale = scaleOf(p);
+                    tfCol[3] = 1.f - std::pow(1.f - tfCol[3], scale);
+                    for (int c = 0; c < 3; ++c)
+                        color[c] += (1.f - color[3]) * tfCol[3] * tfCol[c];
+                    color[3] += (1.f - color[3]) * tfCol[3];
+
+                    t += FineStep * scale;
+                    ++sampleNum;
+                }
+            }
+            return sampleNum;
+        };
+        auto meanErr = [&](const std::vector<std::array<float, 4>> &colors,
+                           const std::vector<std::array<float, 4>> &refs) {
+            double errSum = 0.;
+            for (int r = 0; r < RayNum; ++r)
+                for (int c = 0; c < 4; ++c)
+                    errSum += std::abs(colors[r][c] - refs[r][c]);
+            return errSum / (RayNum * 4);
+        };
+
+        std::vector<std::array<float, 4>> refs, adaptives, uniforms;
+        auto refNum = march([](const std::array<float, 3> &) { return 1.f; }, refs);
+        auto adaptiveNum = march(
+            [&](const std::array<float, 3> &p) {
+                std::array<size_t, 3> cell;
+                for (int a = 0; a < 3; ++a)
+                    cell[a] = std::min(static_cast<uint32_t>(std::max(p[a] - .5f, 0.f)) /
+                                           cells.GetCellSize(),
+                                       cellPerVol[a] - 1);
+                return scales[(cell[2] * cellPerVol[1] + cell[1]) * cellPerVol[0] + cell[0]];
+            },
+            adaptives);
+        auto uniformScale = static_cast<float>(refNum) / adaptiveNum;
+        march([&](const std::array<float, 3> &) { return uniformScale; }, uniforms);
+
+        std::cout << "  fine step: " << refNum << " samples" << std::endl;
+        std::cout << "  adaptive: " << adaptiveNum << " samples (" << 100. * adaptiveNum / refNum
+                  << "%), mean RGBA error " << meanErr(adaptives, refs) << std::endl;
+        std::cout << "  uniform " << uniformScale << "x step: mean RGBA error "
+                  << meanErr(uniforms, refs) << std::endl;
+    }
+}
+
+/*
+ * 函数: benchCPUDirectVolumeRender
+ * 功能: 统计 CPU 直接体绘制的耗时，并以图像比较验证：写入 PAM 后读回应在量化误差内一致，
+ *       按不同分块绘制应逐像素相同，改变步长应被检出。
+ *       与本文件同目录下提交的基准图像 dvr_cpu_golden.pam 比较，生成它的参数记录在
+ *       dvr_cpu_golden.txt 中。二者缺失或参数不一致时验证失败，
+ *       以 --update-golden 运行时才重新生成
+ */
+static void benchCPUDirectVolumeRender() {
+    using Renderer = VIS4Earth::CPUDirectVolumeRenderer;
+    static const float Tolerance = 2.f / 255.f;
+
+    std::string goldenDir = __FILE__;
+    auto sepPos = goldenDir.find_last_of("/\\");
+    goldenDir = sepPos == std::string::npos ? "" : goldenDir.substr(0, sepPos + 1);
+    auto goldenPath = goldenDir + "dvr_cpu_golden.pam";
+    auto goldenParamPath = goldenDir + "dvr_cpu_golden.txt";
+
+    VIS4Earth::TransferFunctionData tf;
+    tf.ReplaceOrSetPoint(0, 0, {0.f, 0.f, 0.f, 0.f});
+    tf.ReplaceOrSetPoint(100, 100, {.2f, .4f, 1.f, 0.f});
+    tf.ReplaceOrSetPoint(160, 160, {.2f, .4f, 1.f, .05f});
+    tf.ReplaceOrSetPoint(204, 204, {1.f, 0.f, 0.f, .6f});
+    tf.ReplaceOrSetPoint(255, 255, {1.f, 1.f, 0.f, .9f});
+
+    std::array<uint32_t, 3> voxPerVol = {128, 128, 64};
+    auto vol = genVolume(voxPerVol);
+
+    // 体覆盖东经 100 至 130 度、北纬 20 至 50 度、地表以上 1000 km，步长同 DVR 的默认设置
+    auto toRadian = [](float deg) { return deg * 3.14159265f / 180.f; };
+    auto earthR = static_cast<float>(osg::WGS_84_RADIUS_POLAR);
+    Renderer::Parameters param;
+    param.lonMin = toRadian(100.f);
+    param.lonMax = toRadian(130.f);
+    param.latMin = toRadian(20.f);
+    param.latMax = toRadian(50.f);
+    param.heightMin = earthR;
+    param.heightMax = earthR + 1e6f;
+    param.step = .8f * 1e6f / voxPerVol[2];
+    param.maxStepCnt = 1000;
+    param.useTFPreInt = param.useShading = param.useAO = true;
+
+    // 从体的中心上空 2 倍地球半径处俯视
+    auto lon = toRadian(115.f), lat = toRadian(35.f);
+    Renderer::Vec3 dir = {std::cos(lat) * std::cos(lon), std::cos(lat) * std::sin(lon),
+                          std::sin(lat)};
+    Renderer::Camera cam;
+    cam.eyePos = {3.f * earthR * dir[0], 3.f * earthR * dir[1], 3.f * earthR * dir[2]};
+    cam.center = {earthR * dir[0], earthR * dir[1], earthR * dir[2]};
+    cam.up = {0.f, 0.f, 1.f};
+    cam.fovY = 20.f;
+    cam.width = cam.height = 256;
+    param.lightPos = cam.eyePos;
+
+    auto start = Clock::now();
+    auto img = Renderer::Render(vol, tf, param, cam);
+    auto seconds = secondsSince(start);
+    if (!img.ok) {
+        check(false);
+        std::cout << "CPU DVR failed: " << img.result.errMsg << std::endl;
+        return;
+    }
+    auto &pixels = img.result.dat.pixels;
+    auto coveredNum = std::count_if(pixels.begin(), pixels.end(),
+                                    [](const std::array<float, 4> &pix) { return pix[3] > 0.f; });
+    std::cout << "CPU DVR " << cam.width << 'x' << cam.height << ": " << seconds * 1e3 << " ms, "
+              << pixels.size() / (seconds * 1e6) << " Mray/s, " << coveredNum
+              << " covered pixels" << std::endl;
+
+    auto report = [&](const char *name, const Renderer::DiffStatistics &diff, bool expectEqual) {
+        auto pass = (diff.exceedNum == 0) == expectEqual;
+        std::cout << "  " << name << ": max " << diff.maxDiff << ", mean " << diff.meanDiff
+                  << ", " << diff.exceedNum << " pixels exceed " << Tolerance << " -> "
+                  << passOrFail(pass) << std::endl;
+    };
+
+    auto tmpPath = "dvr_cpu_result.pam";
+    auto errMsg = Renderer::SavePAM(img.result.dat, tmpPath);
+    auto reloaded = Renderer::LoadPAM(tmpPath);
+    if (!errMsg.empty() || !reloaded.ok) {
+        check(false);
+        std::cout << "  PAM round trip failed: "
+                  << (errMsg.empty() ? reloaded.result.errMsg : errMsg) << std::endl;
+        return;
+    }
+    report("PAM round trip", Renderer::Diff(img.result.dat, reloaded.result.dat, Tolerance),
+           true);
+
+    auto retiledParam = param;
+    retiledParam.tileSize = 7;
+    auto retiled = Renderer::Render(vol, tf, retiledParam, cam).result.dat;
+    report("retiled", Renderer::Diff(img.result.dat, retiled, 0.f), true);
+
+    auto perturbedParam = param;
+    perturbedParam.step *= 1.5f;
+    auto perturbed = Renderer::Render(vol, tf, perturbedParam, cam).result.dat;
+    report("1.5x step (expect differences)",
+           Renderer::Diff(img.result.dat, perturbed, Tolerance), false);
+
+    // 影响图像的全部输入，随基准图像一同提交
+    std::ostringstream paramStrm;
+    paramStrm << "volume " << voxPerVol[0] << ' ' << voxPerVol[1] << ' ' << voxPerVol[2]
+              << "\ntf";
+    for (auto &pnt : tf.GetPoints())
+        paramStrm << ' ' << static_cast<int>(pnt.first) << ' ' << pnt.second[0] << ' '
+                  << pnt.second[1] << ' ' << pnt.second[2] << ' ' << pnt.second[3];
+    paramStrm << "\nlon " << param.lonMin << ' ' << param.lonMax << "\nlat " << param.latMin
+              << ' ' << param.latMax << "\nheight " << param.heightMin << ' '
+              << param.heightMax << "\nstep " << param.step << ' ' << param.maxStepCnt
+              << "\nflags " << param.useTFPreInt << ' ' << param.useShading << ' '
+              << param.useAO << "\nphong " << param.ka << ' ' << param.kd << ' ' << param.ks
+              << ' ' << param.shininess << "\nlight " << param.lightPos[0] << ' '
+              << param.lightPos[1] << ' ' << param.lightPos[2] << "\neye " << cam.eyePos[0]
+              << ' ' << cam.eyePos[1] << ' ' << cam.eyePos[2] << "\ncenter " << cam.center[0]
+              << ' ' << cam.center[1] << ' ' << cam.center[2] << "\nup " << cam.up[0] << ' '
+              << cam.up[1] << ' ' << cam.up[2] << "\nfovY " << cam.fovY << "\nsize "
+              << cam.width << ' ' << cam.height << '\n';
+    auto paramTxt = paramStrm.str();
+
+    if (updateGolden) {
+        std::ofstream os(goldenParamPath, std::ios::binary);
+        os << paramTxt;
+        auto errMsg = Renderer::SavePAM(img.result.dat, goldenPath);
+        if (check(os.good() && errMsg.empty()))
+            std::cout << "  golden image written to " << goldenPath << std::endl;
+        else
+            std::cout << "  failed to write golden image " << goldenPath << ' ' << errMsg
+                      << std::endl;
+        return;
+    }
+
+    std::ifstream is(goldenParamPath, std::ios::binary);
+    std::string goldenParamTxt((std::istreambuf_iterator<char>(is)),
+                               std::istreambuf_iterator<char>());
+    auto golden = Renderer::LoadPAM(goldenPath);
+    if (!golden.ok || !is.is_open())
+        std::cout << "  golden: cannot read " << goldenPath << " or " << goldenParamPath
+                  << ", run with --update-golden to create them -> " << passOrFail(false)
+                  << std::endl;
+    else if (goldenParamTxt != paramTxt)
+        std::cout << "  golden: parameters differ from " << goldenParamPath
+                  << ", run with --update-golden after checking the new image -> "
+                  << passOrFail(false) << std::endl;
+    else
+        report("golden", Renderer::Diff(reloaded.result.dat, golden.result.dat, Tolerance),
+               true);
+}
+
+/*
+ * 函数: benchTimeInterp
+ * 功能: 验证两个时间步合并后的宏单元网格覆盖其间任意插值权重的体，
+ *       并比较合并前后非空单元的比例，即插值播放时空区域跳过的损失
+ */
+static void benchTimeInterp() {
+    std::array<uint32_t, 3> voxPerVol = {256, 256, 128};
+    auto vol0 = genVolume(voxPerVol);
+    // 下一时间步：结构沿 x 平移 6 个体素
+    std::vector<uint8_t> dat1(vol0.GetDataSize());
+    for (size_t i = 0; i < dat1.size(); ++i) {
+        auto x = static_cast<uint32_t>(i % voxPerVol[0]);
+        dat1[i] = vol0.GetData()[i - x + (x + 6) % voxPerVol[0]];
+    }
+    auto vol1 = VIS4Earth::RAWVolumeData::CreateFromData(
+                    voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, std::move(dat1))
+                    .result.dat;
+
+    VIS4Earth::TransferFunctionData tf;
+    tf.ReplaceOrSetPoint(0, 0, {0.f, 0.f, 0.f, 0.f});
+    tf.ReplaceOrSetPoint(199, 199, {1.f, 1.f, 1.f, 0.f});
+    tf.ReplaceOrSetPoint(200, 200, {1.f, 1.f, 1.f, .8f});
+    tf.ReplaceOrSetPoint(255, 255, {1.f, 1.f, 1.f, .8f});
+    auto occupiedRatio = [&](const VIS4Earth::MacroCellGrid &grid) {
+        auto occupancy = grid.ComputeOccupancy(tf);
+        return 1. * std::count(occupancy.begin(), occupancy.end(), 255) / occupancy.size();
+    };
+
+    auto start = Clock::now();
+    auto grid0 = VIS4Earth::MacroCellGrid::Build(vol0).result.dat;
+    auto grid1 = VIS4Earth::MacroCellGrid::Build(vol1).result.dat;
+    auto merged = grid0.GetMerged(grid1).result.dat;
+    std::cout << "Time interpolation " << voxPerVol[0] << 'x' << voxPerVol[1] << 'x'
+              << voxPerVol[2] << ": build and merge " << secondsSince(start) * 1e3 << " ms"
+              << std::endl;
+    std::cout << "  occupied cells: step 0 " << 100. * occupiedRatio(grid0) << "%, step 1 "
+              << 100. * occupiedRatio(grid1) << "%, merged " << 100. * occupiedRatio(merged)
+              << '%' << std::endl;
+
+    for (auto frac : {.25f, .5f, .75f}) {
+        std::vector<uint8_t> blended(vol0.GetDataSize());
+        for (size_t i = 0; i < blended.size(); ++i)
+            blended[i] = static_cast<uint8_t>(
+                std::round((1.f - frac) * vol0.GetData()[i] + frac * vol1.GetData()[i]));
+        auto volBlended = VIS4Earth::RAWVolumeData::CreateFromData(
+                              voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, std::move(blended))
+                              .result.dat;
+        auto grid = VIS4Earth::MacroCellGrid::Build(volBlended).result.dat;
+
+        uint32_t uncoveredNum = 0;
+        for (uint32_t i = 0; i < grid.GetCellNumber(); ++i) {
+            auto &rng = grid.GetTFIndexRange(i);
+            auto &mergedRng = merged.GetTFIndexRange(i);
+            if (rng[0] < mergedRng[0] || rng[1] > mergedRng[1])
+                ++uncoveredNum;
+        }
+        std::cout << "  frac " << frac << ": occupied " << 100. * occupiedRatio(grid) << "%, "
+                  << uncoveredNum << " cells outside merged range -> "
+                  << passOrFail(uncoveredNum == 0) << std::endl;
+    }
+}
+
+/*
+ * 函数: benchPackedVolumes
+ * 功能: 统计 2 至 4 个变量打包的吞吐量，并在随机采样点上按着色器的方式比较
+ *       分别采样各个体（每点 N 次纹理读取）与采样打包的体（每点 1 次）的 CPU 开销与结果
+ */
+static void benchPackedVolumes() {
+    std::array<uint32_t, 3> voxPerVol = {256, 256, 128};
+    std::vector<VIS4Earth::RAWVolumeData> vars;
+    vars.emplace_back(genVolume(voxPerVol));
+    // 其余变量：结构沿 x 平移并取反，与变量 0 不相关
+    for (uint32_t v = 1; v < VIS4Earth::PackedVolumeData::MaxVariableNumber(); ++v) {
+        std::vector<uint8_t> dat(vars[0].GetDataSize());
+        for (size_t i = 0; i < dat.size(); ++i) {
+            auto x = static_cast<uint32_t>(i % voxPerVol[0]);
+            dat[i] = 255 - vars[0].GetData()[i - x + (x + 17 * v) % voxPerVol[0]];
+        }
+        vars.emplace_back(VIS4Earth::RAWVolumeData::CreateFromData(
+                              voxPerVol, VIS4Earth::ESupportedVoxelType::UInt8, std::move(dat))
+                              .result.dat);
+    }
+
+    constexpr size_t SampleNum = 1 << 22;
+    std::vector<std::array<float, 3>> poss(SampleNum);
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    for (auto &p : poss)
+        p = {dist(rng), dist(rng), dist(rng)};
+
+    for (uint32_t varNum = 2; varNum <= VIS4Earth::PackedVolumeData::MaxVariableNumber();
+         ++varNum) {
+        std::vector<const VIS4Earth::RAWVolumeData *> vols;
+        for (uint32_t v = 0; v < varNum; ++v)
+            vols.emplace_back(&vars[v]);
+
+        auto start = Clock::now();
+        auto packedOrErr = VIS4Earth::PackedVolumeData::Pack(vols);
+        auto packSecs = secondsSince(start);
+        if (!packedOrErr.ok) {
+            check(false);
+            std::cout << "Pack failed: " << packedOrErr.result.errMsg << std::endl;
+            return;
+        }
+        auto &packed = packedOrErr.result.dat;
+        auto chNum = static_cast<int>(packed.GetChannelNumber());
+
+        std::vector<float> separated(SampleNum * varNum);
+        start = Clock::now();
+        for (size_t i = 0; i < SampleNum; ++i)
+            for (uint32_t v = 0; v < varNum; ++v)
+                sampleTrilinear(vols[v]->GetData(), voxPerVol, 1, poss[i],
+                                &separated[i * varNum + v]);
+        auto separatedSecs = secondsSince(start);
+
+        std::vector<float> packedVals(SampleNum * chNum);
+        start = Clock::now();
+        for (size_t i = 0; i < SampleNum; ++i)
+            sampleTrilinear(packed.GetData(), voxPerVol, chNum, poss[i], &packedVals[i * chNum]);
+        auto packedSecs = secondsSince(start);
+
+        size_t mismatchNum = 0;
+        for (size_t i = 0; i < SampleNum; ++i)
+            for (uint32_t v = 0; v < varNum; ++v)
+                if (separated[i * varNum + v] != packedVals[i * chNum + v])
+                    ++mismatchNum;
+
+        std::cout << "Packed " << varNum << " variables " << voxPerVol[0] << 'x' << voxPerVol[1]
+                  << 'x' << voxPerVol[2] << " into " << chNum << " channels: pack "
+                  << packSecs * 1e3 << " ms, " << (packed.GetDataSize() >> 20) << " MB"
+                  << std::endl;
+        std::cout << "  " << SampleNum << " samples: separated " << separatedSecs * 1e3
+                  << " ms, packed " << packedSecs * 1e3 << " ms, speedup "
+                  << separatedSecs / packedSecs << "x, " << mismatchNum << " mismatches -> "
+                  << passOrFail(mismatchNum == 0) << std::endl;
+    }
+}
+
+/*
+ * 函数: benchTFDrag
+ * 功能: 模拟以 500 Hz 的鼠标事件拖动传输函数控制点 1 秒、每秒绘制 45 帧，比较每个事件重建纹理
+ *       与每帧至多一次原地更新（采样结果不变时跳过）的分配次数、耗时与更新后的纹理内容
+ */
+static void benchTFDrag() {
+    constexpr int EventNum = 500;
+    constexpr int FrameNum = 45;
+    struct Drag {
+        const char *name;
+        std::function<void(VIS4Earth::TransferFunctionData &, int)> move;
+    };
+    // 竖直拖动每个事件都改变不透明度，水平拖动每 16 个事件移动 1 个标量
+    std::array<Drag, 2> drags = {
+        Drag{"vertical",
+             [](VIS4Earth::TransferFunctionData &tf, int k) {
+                 tf.ReplaceOrSetPoint(128, 128, {1.f, .5f, 0.f, 1.f * k / EventNum});
+             }},
+        Drag{"horizontal", [](VIS4Earth::TransferFunctionData &tf, int k) {
+                 auto prev = static_cast<uint8_t>(100 + (k == 0 ? 0 : (k - 1) / 16));
+                 auto curr = static_cast<uint8_t>(100 + k / 16);
+                 tf.ReplaceOrSetPoint(prev, curr, {1.f, .5f, 0.f, .5f});
+             }}};
+
+    auto initTF = [&]() {
+        VIS4Earth::TransferFunctionData tf;
+        tf.ReplaceOrSetPoint(0, 0, {0.f, 0.f, 0.f, 0.f});
+        tf.ReplaceOrSetPoint(100, 100, {1.f, .5f, 0.f, .5f});
+        tf.ReplaceOrSetPoint(128, 128, {1.f, .5f, 0.f, 0.f});
+        tf.ReplaceOrSetPoint(255, 255, {1.f, 1.f, 1.f, 1.f});
+        return tf;
+    };
+
+    for (auto &drag : drags) {
+        std::cout << "TF drag (" << drag.name << ", " << EventNum << " events, " << FrameNum
+                  << " frames)" << std::endl;
+
+        auto tf = initTF();
+        osg::ref_ptr<osg::Texture1D> tex;
+        osg::ref_ptr<osg::Texture2D> texPreInt;
+        auto num = allocNum.load();
+        auto bytes = allocBytes.load();
+        auto start = Clock::now();
+        for (int k = 0; k < EventNum; ++k) {
+            drag.move(tf, k);
+            tex = tf.ToOSGTexture();
+            texPreInt = tf.ToPreIntegratedOSGTexture();
+        }
+        auto secs = secondsSince(start);
+        std::cout << "  rebuild per event: " << EventNum << " tables, " << allocNum.load() - num
+                  << " allocations, " << ((allocBytes.load() - bytes) >> 20) << " MB, "
+                  << secs * 1e3 << " ms" << std::endl;
+
+        tf = initTF();
+        auto texInPlace = tf.ToOSGTexture();
+        auto texPreIntInPlace = tf.ToPreIntegratedOSGTexture();
+        auto sampled = tf.GetFlatData();
+        auto dirty = false;
+        auto tableNum = 0;
+        auto maxFrameSecs = 0.;
+        num = allocNum.load();
+        bytes = allocBytes.load();
+        start = Clock::now();
+        for (int k = 0, frame = 0; frame < FrameNum; ++frame) {
+            for (; k < EventNum * (frame + 1) / FrameNum; ++k) {
+                drag.move(tf, k);
+                dirty = true;
+            }
+
+            auto frameStart = Clock::now();
+            if (dirty && tf.GetFlatData() != sampled) {
+                sampled = tf.GetFlatData();
+                tf.UpdateOSGTexture(*texInPlace);
+                tf.UpdatePreIntegratedOSGTexture(*texPreIntInPlace);
+                ++tableNum;
+            }
+            dirty = false;
+            maxFrameSecs = std::max(maxFrameSecs, secondsSince(frameStart));
+        }
+        secs = secondsSince(start);
+        std::cout << "  in place per frame: " << tableNum << " tables, " << allocNum.load() - num
+                  << " allocations, " << ((allocBytes.load() - bytes) >> 20) << " MB, "
+                  << secs * 1e3 << " ms (max " << maxFrameSecs * 1e3 << " ms per frame)"
+                  << std::endl;
+
+        auto same =
+            std::memcmp(tex->getImage()->data(), texInPlace->getImage()->data(),
+                        sizeof(float) * 4 * 256) == 0 &&
+            std::memcmp(texPreInt->getImage()->data(), texPreIntInPlace->getImage()->data(),
+                        sizeof(float) * 4 * 256 * 256) == 0;
+        std::cout << "  final textures " << (same ? "identical -> " : "differ -> ")
+                  << passOrFail(same) << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::function<void()>> benches = {{"resize", benchResize},
+                                                            {"smooth", benchSmooth},
+                                                            {"upload", benchUpload},
+                                                            {"brick", benchBrick},
+                                                            {"compress", benchCompress},
+                                                            {"pyramid", benchPyramid},
+                                                            {"alloc", benchAlloc},
+                                                            {"voxtype", benchVoxelTypes},
+                                                            {"txt", benchLabeledTXT},
+                                                            {"grid", benchGridding},
+                                                            {"points", benchPointTXT},
+                                                            {"gradient", benchGradient},
+                                                            {"ao", benchAmbientOcclusion},
+                                                            {"adaptive", benchAdaptiveStep},
+                                                            {"dvrcpu", benchCPUDirectVolumeRender},
+                                                            {"timeinterp", benchTimeInterp},
+                                                            {"packed", benchPackedVolumes},
+                                                            {"tfdrag", benchTFDrag}};
+
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) == "--update-golden")
+            updateGolden = true;
+        else
+            names.emplace_back(argv[i]);
+
+    if (names.empty())
+        for (auto &name_bench : benches)
+            name_bench.second();
+    for (auto &name : names) {
+        auto itr = benches.find(name);
+        if (itr == benches.end()) {
+            std::cerr << "Unknown benchmark: " << name << std::endl;
+            return 1;
+        }
+        itr->second();
+    }
+
+    if (failNum != 0) {
+        std::cerr << failNum << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <vector>
+
+#include <vis4earth/data/vol_container.h>
+#include <vis4earth/data/vol_pyramid.h>
+
+static void printUsage() {
+    std::cerr << "Usage: VCV -o <out.v4e> -dim <x> <y> <z> [-type u8|u16|f32] [-lon <min> <max>]"
+                 " [-lat <min> <max>] [-height <min> <max>] [-chunk <slices>] [-rle]"
+                 " <in0.raw> [<in1.raw> ...]\n"
+                 "       VCV -o <out.v4p> -dim <x> <y> <z> [-type u8|u16|f32] [-lon <min> <max>]"
+                 " [-lat <min> <max>] [-height <min> <max>] -pyramid <brickSize> <in.raw>\n"
+                 "       f32 voxels are expected to be normalized to [0, 1]"
+              << std::endl;
+}
+
+/*
+ * 函数: main
+ * 功能: 将按时间顺序排列的 RAW 文件序列转换为 VolumeContainer（*.v4e），
+ *       或将单个 RAW 文件构建为 VolumePyramid（*.v4p）
+ */
+int main(int argc, char **argv) {
+    std::string outPath;
+    std::vector<std::string> rawFilePaths;
+    VIS4Earth::VolumeContainer::Info info;
+    info.voxPerVol = {0, 0, 0};
+    info.voxTy = VIS4Earth::ESupportedVoxelType::UInt8;
+    info.slicePerChunk = 8;
+    info.lonRange = {0.f, 0.f};
+    info.latRange = {0.f, 0.f};
+    info.heightRange = {0.f, 0.f};
+    auto compress = false;
+    uint32_t brickSize = 0;
+
+    auto readFloats = [&](int &i, float *dst, int num) {
+        if (i + num >= argc)
+            return false;
+        for (int j = 0; j < num; ++j)
+            dst[j] = static_cast<float>(std::atof(argv[++i]));
+        return true;
+    };
+    for (int i = 1; i < argc; ++i) {
+        auto ok = true;
+        if (std::strcmp(argv[i], "-o") == 0) {
+            ok = i + 1 < argc;
+            if (ok)
+                outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "-dim") == 0) {
+            float dim[3];
+            ok = readFloats(i, dim, 3);
+            for (int j = 0; ok && j < 3; ++j)
+                info.voxPerVol[j] = static_cast<uint32_t>(dim[j]);
+        } else if (std::strcmp(argv[i], "-type") == 0) {
+            ok = i + 1 < argc;
+            if (ok) {
+                ++i;
+                if (std::strcmp(argv[i], "u8") == 0)
+                    info.voxTy = VIS4Earth::ESupportedVoxelType::UInt8;
+                else if (std::strcmp(argv[i], "u16") == 0)
+                    info.voxTy = VIS4Earth::ESupportedVoxelType::UInt16;
+                else if (std::strcmp(argv[i], "f32") == 0)
+                    info.voxTy = VIS4Earth::ESupportedVoxelType::Float32;
+                else
+                    ok = false;
+            }
+        } else if (std::strcmp(argv[i], "-lon") == 0)
+            ok = readFloats(i, info.lonRange.data(), 2);
+        else if (std::strcmp(argv[i], "-lat") == 0)
+            ok = readFloats(i, info.latRange.data(), 2);
+        else if (std::strcmp(argv[i], "-height") == 0)
+            ok = readFloats(i, info.heightRange.data(), 2);
+        else if (std::strcmp(argv[i], "-chunk") == 0) {
+            float slicePerChunk;
+            ok = readFloats(i, &slicePerChunk, 1);
+            info.slicePerChunk = static_cast<uint32_t>(slicePerChunk);
+        } else if (std::strcmp(argv[i], "-pyramid") == 0) {
+            float bs;
+            ok = readFloats(i, &bs, 1) && bs >= 1.f;
+            brickSize = static_cast<uint32_t>(bs);
+        } else if (std::strcmp(argv[i], "-rle") == 0)
+            compress = true;
+        else
+            rawFilePaths.emplace_back(argv[i]);
+
+        if (!ok) {
+            printUsage();
+            return 1;
+        }
+    }
+    if (outPath.empty() || rawFilePaths.empty() || info.voxPerVol[0] == 0 ||
+        info.voxPerVol[1] == 0 || info.voxPerVol[2] == 0 || info.slicePerChunk == 0) {
+        printUsage();
+        return 1;
+    }
+
+    if (brickSize != 0) {
+        if (rawFilePaths.size() != 1) {
+            printUsage();
+            return 1;
+        }
+
+        // 按内存映射读取，体数据可大于内存。各层砖块跨越多个切片，按常规方式预读
+        auto vol = VIS4Earth::RAWVolumeData::LoadFromFile(
+            VIS4Earth::RAWVolumeData::FromFileParameters{
+                info.voxPerVol, info.voxTy, rawFilePaths.front(),
+                VIS4Earth::RAWVolumeData::EStorageMode::MemoryMapped,
+                VIS4Earth::MappedFile::EAccessHint::Normal});
+        if (!vol.ok) {
+            std::cerr << vol.result.errMsg << std::endl;
+            return 1;
+        }
+
+        VIS4Earth::VolumePyramid::Info pyramidInfo;
+        pyramidInfo.brickSize = brickSize;
+        pyramidInfo.lonRange = info.lonRange;
+        pyramidInfo.latRange = info.latRange;
+        pyramidInfo.heightRange = info.heightRange;
+        auto errMsg =
+            VIS4Earth::VolumePyramidWriter::Build(outPath, vol.result.dat, pyramidInfo);
+        if (!errMsg.empty()) {
+            std::cerr << errMsg << std::endl;
+            return 1;
+        }
+
+        std::cout << "Built " << outPath << " from " << rawFilePaths.front() << std::endl;
+        return 0;
+    }
+
+    auto errMsg =
+        VIS4Earth::VolumeContainerWriter::ConvertFromRAWFiles(outPath, rawFilePaths, info, compress);
+    if (!errMsg.empty()) {
+        std::cerr << errMsg << std::endl;
+        return 1;
+    }
+
+    std::cout << "Converted " << rawFilePaths.size() << " files into " << outPath << std::endl;
+    return 0;
+}
@@ -7,6 +7,8 @@ SUBDIRS += $$PWD/app/isosurface_rendering/ISS.pro
 SUBDIRS += $$PWD/app/isopleth_rendering/ISP.pro
 SUBDIRS += $$PWD/app/multi_isosurfaces/MIS.pro
 SUBDIRS += $$PWD/app/graph_layout/GRL.pro
+SUBDIRS += $$PWD/app/volume_benchmark/VBM.pro
+SUBDIRS += $$PWD/app/volume_converter/VCV.pro
 
 
 SUBDIRS += $$PWD/app/pie_chart/PIE.pro
@@ -0,0 +1,234 @@
+#ifndef VIS4EARTH_DATA_BRICKED_VOL_H
+#define VIS4EARTH_DATA_BRICKED_VOL_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+#include <array>
+#include <vector>
+
+#include <vis4earth/data/tf_data.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: BrickedVolume
+ * 功能: 将体数据划分为边长为 brickSize 的砖块，并行统计每个砖块的最小值、最大值与粗粒度
+ *       直方图，砖块按 Morton 顺序排列。用于 marching cube 等算法跳过不含等值面或在传输函数下
+ *       完全透明的区域。每个砖块的统计范围额外包含与下一砖块相邻的一层体素，
+ *       使跨越砖块边界的单元也能被正确判断。体素数据不复制，与源体数据共享
+ */
+class BrickedVolume {
+  public:
+    static constexpr uint32_t HistogramBinNum = 16;
+
+    struct Brick {
+        std::array<uint32_t, 3> brickPos; // 砖块坐标，体素坐标为 brickPos * brickSize
+        float minVal;
+        float maxVal;
+        std::array<uint32_t, HistogramBinNum> histogram; // 按体素类型的取值范围等分
+    };
+
+    static ReteurnOrError<BrickedVolume> Build(const RAWVolumeData &vol, uint32_t brickSize = 16) {
+        if (brickSize < 2)
+            return "Invalid brickSize.";
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+
+        BrickedVolume bricked;
+        bricked.vol = vol;
+        bricked.brickSize = brickSize;
+        auto voxPerVol = vol.GetVoxelPerVolume();
+        for (int i = 0; i < 3; ++i)
+            bricked.brickPerVol[i] = (voxPerVol[i] + brickSize - 1) / brickSize;
+
+        bricked.bricks.resize(static_cast<size_t>(bricked.brickPerVol[0]) *
+                              bricked.brickPerVol[1] * bricked.brickPerVol[2]);
+        {
+            std::vector<std::pair<uint64_t, std::array<uint32_t, 3>>> codes;
+            codes.reserve(bricked.bricks.size());
+            std::array<uint32_t, 3> brickPos;
+            for (brickPos[2] = 0; brickPos[2] < bricked.brickPerVol[2]; ++brickPos[2])
+                for (brickPos[1] = 0; brickPos[1] < bricked.brickPerVol[1]; ++brickPos[1])
+                    for (brickPos[0] = 0; brickPos[0] < bricked.brickPerVol[0]; ++brickPos[0])
+                        codes.emplace_back(toMorton(brickPos), brickPos);
+            std::sort(codes.begin(), codes.end(),
+                      [](const std::pair<uint64_t, std::array<uint32_t, 3>> &a,
+                         const std::pair<uint64_t, std::array<uint32_t, 3>> &b) {
+                          return a.first < b.first;
+                      });
+
+            bricked.pos2BrickIDs.resize(bricked.bricks.size());
+            for (uint32_t id = 0; id < codes.size(); ++id) {
+                bricked.bricks[id].brickPos = codes[id].second;
+                bricked.pos2BrickIDs[bricked.toLinear(codes[id].second)] = id;
+            }
+        }
+
+        switch (vol.GetVoxelType()) {
+        case ESupportedVoxelType::UInt8:
+            bricked.buildMetadata<uint8_t>();
+            break;
+        case ESupportedVoxelType::UInt16:
+            bricked.buildMetadata<uint16_t>();
+            break;
+        case ESupportedVoxelType::Float32:
+            bricked.buildMetadata<float>();
+            break;
+        default:
+            assert(false);
+        }
+
+        return bricked;
+    }
+
+    const RAWVolumeData &GetVolume() const { return vol; }
+    uint32_t GetBrickSize() const { return brickSize; }
+    const std::array<uint32_t, 3> &GetBrickPerVolume() const { return brickPerVol; }
+    uint32_t GetBrickNumber() const { return static_cast<uint32_t>(bricks.size()); }
+    // 砖块 ID 即其在 Morton 顺序中的序号
+    const Brick &GetBrick(uint32_t brickID) const { return bricks[brickID]; }
+    uint32_t GetBrickID(uint32_t x, uint32_t y, uint32_t z) const {
+        return pos2BrickIDs[toLinear({x / brickSize, y / brickSize, z / brickSize})];
+    }
+    /*
+     * 函数: IsBuiltFrom
+     * 功能: 判断是否由 vol 构建。持有源数据的引用，因此缓冲地址相同即为同一份数据
+     */
+    bool IsBuiltFrom(const RAWVolumeData &vol) const {
+        return !bricks.empty() && this->vol.GetData() == vol.GetData() &&
+               this->vol.GetVoxelPerVolume() == vol.GetVoxelPerVolume();
+    }
+
+    /*
+     * 函数: QueryIsovalue
+     * 功能: 返回可能与等值面 isoval 相交的砖块 ID（Morton 顺序）。
+     *       与 marching cube 的判断（标量 >= isoval 视为在内）一致，即 minVal < isoval <= maxVal
+     */
+    std::vector<uint32_t> QueryIsovalue(float isoval) const {
+        std::vector<uint32_t> brickIDs;
+        for (uint32_t id = 0; id < bricks.size(); ++id)
+            if (bricks[id].minVal < isoval && isoval <= bricks[id].maxVal)
+                brickIDs.emplace_back(id);
+        return brickIDs;
+    }
+
+    /*
+     * 函数: QueryTransferFunction
+     * 功能: 返回在传输函数 tf 下存在不透明度大于 alphaThreshold 的体素的砖块 ID
+     *       （Morton 顺序）。以直方图非空的区间与 [minVal, maxVal] 的交集查询传输函数，结果偏保守
+     */
+    std::vector<uint32_t> QueryTransferFunction(const TransferFunctionData &tf,
+                                                float alphaThreshold = 0.f) const {
+        auto &flatDat = tf.GetFlatData();
+        // opaquePrefixes[i]: 传输函数前 i 个采样点中不透明的个数
+        std::array<uint32_t, 257> opaquePrefixes;
+        opaquePrefixes[0] = 0;
+        for (uint32_t i = 0; i < 256; ++i)
+            opaquePrefixes[i + 1] = opaquePrefixes[i] + (flatDat[i][3] > alphaThreshold ? 1 : 0);
+
+        float voxMin, voxMax, voxExtent;
+        std::tie(voxMin, voxMax, voxExtent) =
+            RAWVolumeData::GetVoxelMinMaxExtent(vol.GetVoxelType());
+        auto toTFIdx = [&](float scalar) {
+            return std::min(255.f, std::max(0.f, 255.f * (scalar - voxMin) / voxExtent));
+        };
+
+        std::vector<uint32_t> brickIDs;
+        for (uint32_t id = 0; id < bricks.size(); ++id) {
+            auto &brick = bricks[id];
+            auto brickBeg = static_cast<uint32_t>(std::floor(toTFIdx(brick.minVal)));
+            auto brickEnd = static_cast<uint32_t>(std::ceil(toTFIdx(brick.maxVal))) + 1;
+            for (uint32_t bin = 0; bin < HistogramBinNum; ++bin) {
+                if (brick.histogram[bin] == 0)
+                    continue;
+
+                // 区间 [bin, bin + 1) / HistogramBinNum 覆盖的传输函数采样点，两端向外取整
+                auto beg = std::max(brickBeg, bin * 255 / HistogramBinNum);
+                auto binEnd = ((bin + 1) * 255 + HistogramBinNum - 1) / HistogramBinNum + 1;
+                auto end = std::min(brickEnd, binEnd);
+                if (beg < end && opaquePrefixes[end] != opaquePrefixes[beg]) {
+                    brickIDs.emplace_back(id);
+                    break;
+                }
+            }
+        }
+        return brickIDs;
+    }
+
+    /*
+     * 函数: GetBrickMask
+     * 功能: 将查询结果转为按砖块 ID 索引的掩码，便于逐单元判断
+     */
+    std::vector<uint8_t> GetBrickMask(const std::vector<uint32_t> &brickIDs) const {
+        std::vector<uint8_t> mask(bricks.size(), 0);
+        for (auto id : brickIDs)
+            mask[id] = 1;
+        return mask;
+    }
+
+  private:
+    RAWVolumeData vol;
+    uint32_t brickSize = 0;
+    std::array<uint32_t, 3> brickPerVol = {0, 0, 0};
+    std::vector<Brick> bricks;
+    std::vector<uint32_t> pos2BrickIDs; // 按砖块坐标线性索引
+
+    size_t toLinear(const std::array<uint32_t, 3> &brickPos) const {
+        return (static_cast<size_t>(brickPos[2]) * brickPerVol[1] + brickPos[1]) * brickPerVol[0] +
+               brickPos[0];
+    }
+    static uint64_t toMorton(const std::array<uint32_t, 3> &brickPos) {
+        uint64_t code = 0;
+        for (uint32_t b = 0; b < 21; ++b)
+            for (uint32_t i = 0; i < 3; ++i)
+                code |= static_cast<uint64_t>((brickPos[i] >> b) & 1) << (3 * b + i);
+        return code;
+    }
+
+    template <typename T> void buildMetadata() {
+        float voxMin, voxMax, voxExtent;
+        std::tie(voxMin, voxMax, voxExtent) =
+            RAWVolumeData::GetVoxelMinMaxExtent(vol.GetVoxelType());
+        auto binScale = HistogramBinNum / voxExtent;
+        auto voxPerVol = vol.GetVoxelPerVolume();
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        auto dat = reinterpret_cast<const T *>(vol.GetData());
+
+        ThreadPool::Global().ParallelFor(0, GetBrickNumber(), [&](uint32_t id) {
+            auto &brick = bricks[id];
+            std::array<uint32_t, 3> beg, end;
+            for (int i = 0; i < 3; ++i) {
+                beg[i] = brick.brickPos[i] * brickSize;
+                end[i] = std::min(beg[i] + brickSize + 1, voxPerVol[i]); // 多统计一层相邻体素
+            }
+
+            auto minVal = std::numeric_limits<T>::max();
+            auto maxVal = std::numeric_limits<T>::lowest();
+            brick.histogram.fill(0);
+            for (auto z = beg[2]; z < end[2]; ++z)
+                for (auto y = beg[1]; y < end[1]; ++y) {
+                    auto row = dat + z * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0];
+                    for (auto x = beg[0]; x < end[0]; ++x) {
+                        auto v = row[x];
+                        minVal = std::min(minVal, v);
+                        maxVal = std::max(maxVal, v);
+                        // Float32 的值可能略超出 [0, 1]，先钳制再转为区间下标
+                        auto bin = static_cast<uint32_t>(
+                            std::max(0.f, (static_cast<float>(v) - voxMin) * binScale));
+                        ++brick.histogram[std::min(bin, HistogramBinNum - 1)];
+                    }
+                }
+            brick.minVal = static_cast<float>(minVal);
+            brick.maxVal = static_cast<float>(maxVal);
+        });
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_BRICKED_VOL_H
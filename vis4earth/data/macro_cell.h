@@ -0,0 +1,219 @@
+#ifndef VIS4EARTH_DATA_MACRO_CELL_H
+#define VIS4EARTH_DATA_MACRO_CELL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <array>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/tf_data.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: MacroCellGrid
+ * 功能: 体数据的低分辨率最小/最大值网格，每个宏单元覆盖边长为 cellSize 的体素块，
+ *       并向各方向外扩一层体素，使落在单元内的采样点的三线性插值范围也被包含。
+ *       取值以传输函数下标（0 至 255）存放，不持有体素数据。按传输函数求出各单元是否可能不透明，
+ *       生成占据纹理，供光线投射跳过空区域
+ */
+class MacroCellGrid {
+  public:
+    static ReteurnOrError<MacroCellGrid> Build(const RAWVolumeData &vol, uint32_t cellSize = 8) {
+        if (cellSize == 0)
+            return "Invalid cellSize.";
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+
+        MacroCellGrid grid;
+        grid.cellSize = cellSize;
+        grid.voxPerVol = vol.GetVoxelPerVolume();
+        for (int i = 0; i < 3; ++i)
+            grid.cellPerVol[i] = (grid.voxPerVol[i] + cellSize - 1) / cellSize;
+        grid.tfIdxRngs.resize(static_cast<size_t>(grid.cellPerVol[0]) * grid.cellPerVol[1] *
+                              grid.cellPerVol[2]);
+
+        switch (vol.GetVoxelType()) {
+        case ESupportedVoxelType::UInt8:
+            grid.build<uint8_t>(vol);
+            break;
+        case ESupportedVoxelType::UInt16:
+            grid.build<uint16_t>(vol);
+            break;
+        case ESupportedVoxelType::Float32:
+            grid.build<float>(vol);
+            break;
+        default:
+            assert(false);
+        }
+
+        return grid;
+    }
+
+    uint32_t GetCellSize() const { return cellSize; }
+    const std::array<uint32_t, 3> &GetCellPerVolume() const { return cellPerVol; }
+    const std::array<uint32_t, 3> &GetVoxelPerVolume() const { return voxPerVol; }
+    uint32_t GetCellNumber() const { return static_cast<uint32_t>(tfIdxRngs.size()); }
+    // 单元内体素的传输函数下标范围 [最小, 最大]
+    const std::array<uint8_t, 2> &GetTFIndexRange(uint32_t cellID) const {
+        return tfIdxRngs[cellID];
+    }
+
+    /*
+     * 函数: GetMerged
+     * 功能: 返回各单元下标范围取两者并集外包的网格，覆盖两个体按任意权重线性插值后的取值，
+     *       用于时间步间插值。两者的体素数或单元边长不同时返回错误
+     */
+    ReteurnOrError<MacroCellGrid> GetMerged(const MacroCellGrid &other) const {
+        if (other.cellSize != cellSize || other.voxPerVol != voxPerVol)
+            return "Mismatched macro cell grids.";
+
+        auto merged = *this;
+        for (size_t i = 0; i < merged.tfIdxRngs.size(); ++i) {
+            merged.tfIdxRngs[i][0] = std::min(tfIdxRngs[i][0], other.tfIdxRngs[i][0]);
+            merged.tfIdxRngs[i][1] = std::max(tfIdxRngs[i][1], other.tfIdxRngs[i][1]);
+        }
+        return merged;
+    }
+
+    /*
+     * 函数: ComputeOccupancy
+     * 功能: 返回各单元在传输函数 tf 下是否可能存在不透明度大于 alphaThreshold 的采样，按 x、y、z
+     *       线性排列。传输函数纹理按线性过滤读取，因此查询范围向两侧各扩一个采样点
+     */
+    std::vector<uint8_t> ComputeOccupancy(const TransferFunctionData &tf,
+                                          float alphaThreshold = 0.f) const {
+        auto &flatDat = tf.GetFlatData();
+        // opaquePrefixes[i]: 传输函数前 i 个采样点中不透明的个数
+        std::array<uint32_t, 257> opaquePrefixes;
+        opaquePrefixes[0] = 0;
+        for (uint32_t i = 0; i < 256; ++i)
+            opaquePrefixes[i + 1] = opaquePrefixes[i] + (flatDat[i][3] > alphaThreshold ? 1 : 0);
+
+        std::vector<uint8_t> occupancy(tfIdxRngs.size());
+        for (size_t i = 0; i < tfIdxRngs.size(); ++i) {
+            auto beg = std::max(1u, static_cast<uint32_t>(tfIdxRngs[i][0])) - 1;
+            auto end = std::min(256u, static_cast<uint32_t>(tfIdxRngs[i][1]) + 2);
+            occupancy[i] = opaquePrefixes[end] != opaquePrefixes[beg] ? 255 : 0;
+        }
+        return occupancy;
+    }
+
+    /*
+     * 函数: ComputeStepScales
+     * 功能: 返回各单元内可用的采样步长倍数（1 至 maxStepScale），按 x、y、z 线性排列。
+     *       以传输函数在单元下标范围内相邻采样点间的最大变化（颜色按不透明度加权）乘以单元的下标跨度，
+     *       估计按基准步长沿光线采样时相邻采样点间传输函数的变化，使其不超过 tolerance。
+     *       传输函数平缓或单元内取值范围窄的单元可取较大步长
+     * 参数:
+     * -- tolerance: 相邻采样点间允许的传输函数变化，基准步长按约 1 个体素估计
+     */
+    std::vector<float> ComputeStepScales(const TransferFunctionData &tf, float maxStepScale,
+                                         float tolerance = 1.f / 32.f) const {
+        auto &flatDat = tf.GetFlatData();
+        // variations[i]: 第 i 与 i + 1 个采样点间的变化
+        std::array<float, 255> variations;
+        for (uint32_t i = 0; i < 255; ++i) {
+            auto &c0 = flatDat[i];
+            auto &c1 = flatDat[i + 1];
+            auto rgbVar = std::max(std::abs(c1[0] - c0[0]),
+                                   std::max(std::abs(c1[1] - c0[1]), std::abs(c1[2] - c0[2])));
+            variations[i] = std::max(std::abs(c1[3] - c0[3]), std::max(c0[3], c1[3]) * rgbVar);
+        }
+
+        std::vector<float> scales(tfIdxRngs.size());
+        for (size_t i = 0; i < tfIdxRngs.size(); ++i) {
+            // 与 ComputeOccupancy 一致，向两侧各扩一个采样点
+            auto beg = std::max(1u, static_cast<uint32_t>(tfIdxRngs[i][0])) - 1;
+            auto end = std::min(255u, static_cast<uint32_t>(tfIdxRngs[i][1]) + 1);
+            auto maxVar = 0.f;
+            for (auto j = beg; j < end; ++j)
+                maxVar = std::max(maxVar, variations[j]);
+
+            auto varPerSample = maxVar * (end - beg) / cellSize;
+            scales[i] = varPerSample * maxStepScale <= tolerance
+                            ? maxStepScale
+                            : std::max(1.f, tolerance / varPerSample);
+        }
+        return scales;
+    }
+
+    /*
+     * 函数: ToOccupancyTexture
+     * 功能: 将 ComputeOccupancy 的结果转为逐单元取值（最近邻过滤）的 R8 纹理。
+     *       着色器仅区分取值是否为 0，非空单元的取值可另行编码，如 ComputeStepScales 的结果
+     */
+    osg::ref_ptr<osg::Texture3D> ToOccupancyTexture(const std::vector<uint8_t> &occupancy) const {
+        osg::ref_ptr<osg::Image> img = new osg::Image;
+        img->allocateImage(cellPerVol[0], cellPerVol[1], cellPerVol[2], GL_RED, GL_UNSIGNED_BYTE);
+        img->setInternalTextureFormat(GL_R8);
+        std::memcpy(img->data(), occupancy.data(), occupancy.size());
+
+        osg::ref_ptr<osg::Texture3D> tex = new osg::Texture3D;
+        tex->setResizeNonPowerOfTwoHint(false);
+        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::NEAREST);
+        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::NEAREST);
+        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        tex->setImage(img);
+
+        return tex;
+    }
+
+  private:
+    uint32_t cellSize = 0;
+    std::array<uint32_t, 3> voxPerVol = {0, 0, 0};
+    std::array<uint32_t, 3> cellPerVol = {0, 0, 0};
+    std::vector<std::array<uint8_t, 2>> tfIdxRngs;
+
+    /*
+     * 函数: build
+     * 功能: 按 z 方向的单元层并行统计。相邻单元共享外扩的体素，各单元独立遍历其范围，
+     *       单元边长为 8 时约多读取一倍体素，换取无需合并的并行
+     */
+    template <typename T> void build(const RAWVolumeData &vol) {
+        auto dat = reinterpret_cast<const T *>(vol.GetData());
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        auto cellRange = [&](uint32_t cell, int axis) {
+            auto beg = cell * cellSize;
+            return std::array<uint32_t, 2>{beg == 0 ? 0 : beg - 1,
+                                           std::min(voxPerVol[axis], beg + cellSize + 1)};
+        };
+
+        ThreadPool::Global().ParallelFor(0, cellPerVol[2], [&](uint32_t cz) {
+            auto zRng = cellRange(cz, 2);
+            for (uint32_t cy = 0; cy < cellPerVol[1]; ++cy) {
+                auto yRng = cellRange(cy, 1);
+                for (uint32_t cx = 0; cx < cellPerVol[0]; ++cx) {
+                    auto xRng = cellRange(cx, 0);
+                    uint8_t minIdx = 255, maxIdx = 0;
+                    for (auto z = zRng[0]; z < zRng[1]; ++z)
+                        for (auto y = yRng[0]; y < yRng[1]; ++y) {
+                            auto row =
+                                dat + z * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0];
+                            for (auto x = xRng[0]; x < xRng[1]; ++x) {
+                                auto idx = VoxelTypeTraits<T>::ToTFIndex(row[x]);
+                                minIdx = std::min(minIdx, idx);
+                                maxIdx = std::max(maxIdx, idx);
+                            }
+                        }
+
+                    tfIdxRngs[(static_cast<size_t>(cz) * cellPerVol[1] + cy) * cellPerVol[0] + cx] =
+                        {minIdx, maxIdx};
+                }
+            }
+        });
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_MACRO_CELL_H
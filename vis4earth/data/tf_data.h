@@ -106,12 +106,66 @@ class TransferFunctionData {
         return tex;
     }
 
-    osg::ref_ptr<osg::Texture2D> ToPreIntegratedOSGTexture() const {
+    /*
+     * 函数: UpdateOSGTexture
+     * 功能: 将采样结果写入由 ToOSGTexture 创建的纹理的图像并标记为脏，
+     *       绘制时 OSG 在原纹理对象上重新上传，不重新分配图像、纹理
+     */
+    void UpdateOSGTexture(osg::Texture1D &tex) const {
         fromPointsToFlatData();
 
+        auto img = tex.getImage();
+        memcpy(img->data(), flatDat.data(), sizeof(flatDat[0]) * flatDat.size());
+        img->dirty();
+    }
+
+    /*
+     * 函数: GetPreIntegratedFlatData
+     * 功能: 返回 256x256 的预积分表，第 sf 行第 sb 列为标量从 sf 线性变化到 sb 的一个采样段的
+     *       不透明度加权颜色与不透明度，与 ToPreIntegratedOSGTexture 的纹理内容一致
+     */
+    std::vector<std::array<float, 4>> GetPreIntegratedFlatData() const {
+        std::vector<std::array<float, 4>> preIntDat(256 * 256);
+        fillPreIntegratedFlatData(preIntDat.data());
+
+        return preIntDat;
+    }
+
+    osg::ref_ptr<osg::Texture2D> ToPreIntegratedOSGTexture() const {
         osg::ref_ptr<osg::Image> img = new osg::Image;
         img->allocateImage(256, 256, 1, GL_RGBA, GL_FLOAT);
         img->setInternalTextureFormat(GL_RGBA);
+        fillPreIntegratedFlatData(reinterpret_cast<std::array<float, 4> *>(img->data()));
+
+        osg::ref_ptr<osg::Texture2D> tex = new osg::Texture2D;
+        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        tex->setImage(img);
+
+        return tex;
+    }
+
+    /*
+     * 函数: UpdatePreIntegratedOSGTexture
+     * 功能: 将预积分表直接写入由 ToPreIntegratedOSGTexture 创建的纹理的图像并标记为脏，
+     *       绘制时 OSG 以子区域上传更新原纹理对象，不分配临时的表
+     */
+    void UpdatePreIntegratedOSGTexture(osg::Texture2D &tex) const {
+        auto img = tex.getImage();
+        fillPreIntegratedFlatData(reinterpret_cast<std::array<float, 4> *>(img->data()));
+        img->dirty();
+    }
+
+  private:
+    EFilterType filterTy;
+    mutable bool needUpdateFlatData = false;
+    std::map<uint8_t, std::array<float, 4>> pnts;
+    mutable std::array<std::array<float, 4>, 256> flatDat;
+
+    void fillPreIntegratedFlatData(std::array<float, 4> *tfPreIntDatPtr) const {
+        fromPointsToFlatData();
 
         decltype(flatDat) flatDatInt;
         flatDatInt[0][0] = flatDat[0][0];
@@ -130,7 +184,6 @@ class TransferFunctionData {
             flatDatInt[i][3] = flatDatInt[i - 1][3] + a;
         }
 
-        auto tfPreIntDatPtr = reinterpret_cast<std::array<float, 4> *>(img->data());
         for (int sf = 0; sf < 256; ++sf)
             for (int sb = 0; sb < 256; ++sb) {
                 auto sMin = sf;
@@ -155,23 +208,8 @@ class TransferFunctionData {
 
                 ++tfPreIntDatPtr;
             }
-
-        osg::ref_ptr<osg::Texture2D> tex = new osg::Texture2D;
-        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
-        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
-        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
-        tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
-        tex->setImage(img);
-
-        return tex;
     }
 
-  private:
-    EFilterType filterTy;
-    mutable bool needUpdateFlatData = false;
-    std::map<uint8_t, std::array<float, 4>> pnts;
-    mutable std::array<std::array<float, 4>, 256> flatDat;
-
     void fromPointsToFlatData() const {
         if (!needUpdateFlatData)
             return;
@@ -0,0 +1,308 @@
+#ifndef VIS4EARTH_DATA_VOL_AO_H
+#define VIS4EARTH_DATA_VOL_AO_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <tuple>
+
+#include <array>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/macro_cell.h>
+#include <vis4earth/data/tf_data.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/lru_cache.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: AmbientOcclusionVolume
+ * 功能: 按传输函数预先计算的环境光遮蔽体。体素 v 的遮蔽为
+ *       clamp(1 - strength * (邻域平均不透明度 - v 的不透明度), 0, 1)，邻域为以 v 为中心、
+ *       边长 2 * radius + 1 的立方体（越出体数据的部分不计），与逐采样以六邻域求差的做法一致：
+ *       平面上不遮蔽，凹处变暗。以 R8 纹理存放，光线投射时一次纹理读取即可。
+ *       传输函数变化时，由宏单元网格找出不透明度发生变化的体素所在单元，
+ *       仅重新计算这些单元及其相邻单元
+ */
+class AmbientOcclusionVolume {
+  public:
+    // 邻域半径不超过宏单元边长，使受影响的体素不越出相邻单元。
+    // strength 取 6 时，与着色器中六邻域差之和的量级相当
+    static uint32_t CellSize() { return 8; }
+
+    struct Parameters {
+        uint32_t radius = 2;
+        float strength = 6.f;
+    };
+    struct Statistics {
+        uint32_t updatedCellNum;
+        uint32_t cellNum;
+        double milliseconds;
+    };
+
+    static ReteurnOrError<AmbientOcclusionVolume> Compute(const RAWVolumeData &vol,
+                                                          const TransferFunctionData &tf,
+                                                          const Parameters &param,
+                                                          Statistics *stats = nullptr) {
+        if (param.radius == 0 || param.radius > CellSize())
+            return "Invalid param.radius.";
+        auto cells = MacroCellGrid::Build(vol, CellSize());
+        if (!cells.ok)
+            return cells.result.errMsg.c_str();
+
+        AmbientOcclusionVolume ao;
+        ao.param = param;
+        ao.cells = std::move(cells.result.dat);
+        // 以负值标记尚未计算，首次更新时全部单元均视为变化
+        ao.alphas.fill(-1.f);
+
+        auto &voxPerVol = vol.GetVoxelPerVolume();
+        ao.img = new osg::Image;
+        ao.img->allocateImage(voxPerVol[0], voxPerVol[1], voxPerVol[2], GL_RED,
+                              GL_UNSIGNED_BYTE);
+        ao.img->setInternalTextureFormat(GL_R8);
+
+        ao.tex = new osg::Texture3D;
+        ao.tex->setResizeNonPowerOfTwoHint(false);
+        ao.tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
+        ao.tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
+        ao.tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        ao.tex->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        ao.tex->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        ao.tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        ao.tex->setImage(ao.img);
+
+        auto s = ao.Update(vol, tf);
+        if (stats)
+            *stats = s;
+        return ao;
+    }
+
+    /*
+     * 函数: Update
+     * 功能: 按新的传输函数增量更新，并标记纹理需重新上传
+     * 参数:
+     * -- vol: 与 Compute 时相同的体数据
+     * -- tf: 新的传输函数
+     */
+    Statistics Update(const RAWVolumeData &vol, const TransferFunctionData &tf) {
+        auto start = std::chrono::steady_clock::now();
+        Statistics stats = {0, cells.GetCellNumber(), 0.};
+
+        auto &flatDat = tf.GetFlatData();
+        // changedPrefixes[i]: 前 i 个传输函数下标中不透明度发生变化的个数
+        std::array<uint32_t, 257> changedPrefixes;
+        changedPrefixes[0] = 0;
+        for (uint32_t i = 0; i < 256; ++i) {
+            changedPrefixes[i + 1] = changedPrefixes[i] + (flatDat[i][3] != alphas[i] ? 1 : 0);
+            alphas[i] = flatDat[i][3];
+        }
+        if (changedPrefixes[256] == 0)
+            return stats;
+
+        auto &cellPerVol = cells.GetCellPerVolume();
+        auto cellIdx = [&](uint32_t cx, uint32_t cy, uint32_t cz) {
+            return (static_cast<size_t>(cz) * cellPerVol[1] + cy) * cellPerVol[0] + cx;
+        };
+        std::vector<uint8_t> dirties(cells.GetCellNumber(), 0);
+        for (uint32_t cz = 0; cz < cellPerVol[2]; ++cz)
+            for (uint32_t cy = 0; cy < cellPerVol[1]; ++cy)
+                for (uint32_t cx = 0; cx < cellPerVol[0]; ++cx) {
+                    auto &rng = cells.GetTFIndexRange(static_cast<uint32_t>(cellIdx(cx, cy, cz)));
+                    if (changedPrefixes[rng[1] + 1] == changedPrefixes[rng[0]])
+                        continue;
+
+                    for (auto z = cz == 0 ? 0 : cz - 1; z <= std::min(cz + 1, cellPerVol[2] - 1);
+                         ++z)
+                        for (auto y = cy == 0 ? 0 : cy - 1;
+                             y <= std::min(cy + 1, cellPerVol[1] - 1); ++y)
+                            for (auto x = cx == 0 ? 0 : cx - 1;
+                                 x <= std::min(cx + 1, cellPerVol[0] - 1); ++x)
+                                dirties[cellIdx(x, y, z)] = 1;
+                }
+        std::vector<uint32_t> dirtyCellIDs;
+        for (size_t i = 0; i < dirties.size(); ++i)
+            if (dirties[i] != 0)
+                dirtyCellIDs.emplace_back(static_cast<uint32_t>(i));
+
+        switch (vol.GetVoxelType()) {
+        case ESupportedVoxelType::UInt8:
+            updateCells<uint8_t>(vol, dirtyCellIDs);
+            break;
+        case ESupportedVoxelType::UInt16:
+            updateCells<uint16_t>(vol, dirtyCellIDs);
+            break;
+        case ESupportedVoxelType::Float32:
+            updateCells<float>(vol, dirtyCellIDs);
+            break;
+        default:
+            assert(false);
+        }
+        img->dirty();
+
+        stats.updatedCellNum = static_cast<uint32_t>(dirtyCellIDs.size());
+        stats.milliseconds = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+        return stats;
+    }
+
+    const Parameters &GetParameters() const { return param; }
+    // 按 x、y、z 线性排列，255 表示无遮蔽
+    const uint8_t *GetData() const { return img->data(); }
+    size_t GetByteSize() const { return img->getTotalSizeInBytes(); }
+    osg::ref_ptr<osg::Texture3D> GetTexture() const { return tex; }
+
+  private:
+    Parameters param;
+    MacroCellGrid cells;
+    std::array<float, 256> alphas;
+    osg::ref_ptr<osg::Image> img;
+    osg::ref_ptr<osg::Texture3D> tex;
+
+    /*
+     * 函数: updateCells
+     * 功能: 按单元并行重新计算遮蔽。各单元取出其外扩 radius 的不透明度块，
+     *       沿 x、y、z 依次求窗口和，只写入单元内的体素
+     */
+    template <typename T>
+    void updateCells(const RAWVolumeData &vol, const std::vector<uint32_t> &cellIDs) {
+        auto dat = reinterpret_cast<const T *>(vol.GetData());
+        auto &voxPerVol = vol.GetVoxelPerVolume();
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        auto &cellPerVol = cells.GetCellPerVolume();
+        auto cellSize = cells.GetCellSize();
+        auto r = param.radius;
+        auto out = img->data();
+
+        ThreadPool::Global().ParallelFor(0, static_cast<uint32_t>(cellIDs.size()), [&](uint32_t i) {
+            auto id = cellIDs[i];
+            std::array<uint32_t, 3> cell = {id % cellPerVol[0], id / cellPerVol[0] % cellPerVol[1],
+                                            id / (cellPerVol[0] * cellPerVol[1])};
+            // 单元 [beg, end) 与外扩后的 [extBeg, extEnd)，均以体素计
+            std::array<uint32_t, 3> beg, end, extBeg, n, coreN;
+            for (int a = 0; a < 3; ++a) {
+                beg[a] = cell[a] * cellSize;
+                end[a] = std::min(beg[a] + cellSize, voxPerVol[a]);
+                extBeg[a] = beg[a] > r ? beg[a] - r : 0;
+                n[a] = std::min(end[a] + r, voxPerVol[a]) - extBeg[a];
+                coreN[a] = end[a] - beg[a];
+            }
+
+            std::vector<float> blk(static_cast<size_t>(n[0]) * n[1] * n[2]);
+            for (uint32_t z = 0; z < n[2]; ++z)
+                for (uint32_t y = 0; y < n[1]; ++y) {
+                    auto src = dat + (extBeg[2] + z) * voxPerVolYxX +
+                               static_cast<size_t>(extBeg[1] + y) * voxPerVol[0] + extBeg[0];
+                    auto dst = blk.data() + (static_cast<size_t>(z) * n[1] + y) * n[0];
+                    for (uint32_t x = 0; x < n[0]; ++x)
+                        dst[x] = alphas[VoxelTypeTraits<T>::ToTFIndex(src[x])];
+                }
+
+            // 块内坐标 c 处窗口 [c - r, c + r] 与块的交集
+            auto window = [&](int a, uint32_t c) {
+                auto g = extBeg[a] + c;
+                return std::array<uint32_t, 2>{(g > r ? g - r : 0) - extBeg[a],
+                                               std::min(g + r + 1, voxPerVol[a]) - extBeg[a]};
+            };
+            auto offs = [&](int a) { return beg[a] - extBeg[a]; };
+
+            // sumX: [n[2]][n[1]][coreN[0]]
+            std::vector<float> sumX(static_cast<size_t>(n[2]) * n[1] * coreN[0]);
+            for (uint32_t z = 0; z < n[2]; ++z)
+                for (uint32_t y = 0; y < n[1]; ++y) {
+                    auto row = blk.data() + (static_cast<size_t>(z) * n[1] + y) * n[0];
+                    auto dst = sumX.data() + (static_cast<size_t>(z) * n[1] + y) * coreN[0];
+                    for (uint32_t x = 0; x < coreN[0]; ++x) {
+                        auto w = window(0, offs(0) + x);
+                        float sum = 0.f;
+                        for (auto xx = w[0]; xx < w[1]; ++xx)
+                            sum += row[xx];
+                        dst[x] = sum;
+                    }
+                }
+            // sumXY: [n[2]][coreN[1]][coreN[0]]
+            std::vector<float> sumXY(static_cast<size_t>(n[2]) * coreN[1] * coreN[0]);
+            for (uint32_t z = 0; z < n[2]; ++z)
+                for (uint32_t y = 0; y < coreN[1]; ++y) {
+                    auto w = window(1, offs(1) + y);
+                    auto dst = sumXY.data() + (static_cast<size_t>(z) * coreN[1] + y) * coreN[0];
+                    for (uint32_t x = 0; x < coreN[0]; ++x)
+                        dst[x] = 0.f;
+                    for (auto yy = w[0]; yy < w[1]; ++yy) {
+                        auto src = sumX.data() + (static_cast<size_t>(z) * n[1] + yy) * coreN[0];
+                        for (uint32_t x = 0; x < coreN[0]; ++x)
+                            dst[x] += src[x];
+                    }
+                }
+
+            std::vector<float> sumXYZ(coreN[0]);
+            for (uint32_t z = 0; z < coreN[2]; ++z) {
+                auto wz = window(2, offs(2) + z);
+                for (uint32_t y = 0; y < coreN[1]; ++y) {
+                    auto wy = window(1, offs(1) + y);
+                    std::fill(sumXYZ.begin(), sumXYZ.end(), 0.f);
+                    for (auto zz = wz[0]; zz < wz[1]; ++zz) {
+                        auto src =
+                            sumXY.data() + (static_cast<size_t>(zz) * coreN[1] + y) * coreN[0];
+                        for (uint32_t x = 0; x < coreN[0]; ++x)
+                            sumXYZ[x] += src[x];
+                    }
+
+                    auto blkRow = blk.data() +
+                                  (static_cast<size_t>(offs(2) + z) * n[1] + offs(1) + y) * n[0] +
+                                  offs(0);
+                    auto dst = out + (beg[2] + z) * voxPerVolYxX +
+                               static_cast<size_t>(beg[1] + y) * voxPerVol[0] + beg[0];
+                    auto cntYZ = static_cast<float>((wy[1] - wy[0]) * (wz[1] - wz[0]));
+                    for (uint32_t x = 0; x < coreN[0]; ++x) {
+                        auto wx = window(0, offs(0) + x);
+                        auto mean = sumXYZ[x] / (cntYZ * (wx[1] - wx[0]));
+                        auto ao = 1.f - param.strength * (mean - blkRow[x]);
+                        dst[x] = static_cast<uint8_t>(
+                            std::round(std::min(1.f, std::max(0.f, ao)) * 255.f));
+                    }
+                }
+            }
+        });
+    }
+};
+
+/*
+ * 结构体: AmbientOcclusionEntry
+ * 功能: 环境光遮蔽体及计算它时所用传输函数的版本
+ */
+struct AmbientOcclusionEntry {
+    std::shared_ptr<AmbientOcclusionVolume> ao;
+    uint64_t tfRevision;
+};
+
+struct AmbientOcclusionEntryByteSize {
+    size_t operator()(const AmbientOcclusionEntry &entry) const { return entry.ao->GetByteSize(); }
+};
+
+/*
+ * 类: AmbientOcclusionCache
+ * 功能: 按 (体 ID, 时间步 ID) 缓存环境光遮蔽体。
+ *       版本落后时由调用方增量更新后重新插入，总字节数超出预算时按 LRU 淘汰
+ */
+class AmbientOcclusionCache
+    : public LRUCache<std::tuple<uint32_t, uint32_t>, AmbientOcclusionEntry,
+                      AmbientOcclusionEntryByteSize> {
+  public:
+    using LRUCache::LRUCache;
+
+    // 移除某个体的全部缓存项，在该体被重新加载时调用
+    void Erase(uint32_t volID) {
+        EraseIf([&](const Key &key) { return std::get<0>(key) == volID; });
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_AO_H
@@ -0,0 +1,60 @@
+#ifndef VIS4EARTH_DATA_VOL_CACHE_H
+#define VIS4EARTH_DATA_VOL_CACHE_H
+
+#include <tuple>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/lru_cache.h>
+
+namespace VIS4Earth {
+
+/*
+ * 结构体: SmoothedVolumeEntry
+ * 功能: 光滑后的 CPU 体数据（未保留时为空）与纹理
+ */
+struct SmoothedVolumeEntry {
+    RAWVolumeData volCPU;
+    osg::ref_ptr<osg::Texture3D> vol;
+};
+
+struct SmoothedVolumeEntryByteSize {
+    size_t operator()(const SmoothedVolumeEntry &entry) const {
+        size_t sz = entry.volCPU.GetResidentBytes();
+        // NPOT 纹理的图像与 CPU 体数据共享同一缓冲，不重复计算
+        if (entry.vol.valid() && entry.vol->getImage() &&
+            entry.vol->getImage()->data() != entry.volCPU.GetData())
+            sz += entry.vol->getImage()->getTotalSizeInBytes();
+        return sz;
+    }
+};
+
+/*
+ * 类: SmoothedVolumeCache
+ * 功能: 按 (体 ID, 时间步 ID, 光滑类型, 光滑维度, 光滑半径, 纹理尺寸模式) 缓存光滑后的
+ *       CPU 体数据与纹理，总字节数超出预算时按 LRU 淘汰。
+ *       纹理尺寸模式决定纹理是否重采样为 2 的幂，切换后不命中另一模式下创建的纹理
+ */
+class SmoothedVolumeCache
+    : public LRUCache<std::tuple<uint32_t, uint32_t, RAWVolumeData::ESmoothType,
+                                 RAWVolumeData::ESmoothDimension, uint32_t,
+                                 RAWVolumeData::ETextureSizeMode>,
+                      SmoothedVolumeEntry, SmoothedVolumeEntryByteSize> {
+  public:
+    using LRUCache::LRUCache;
+
+    /*
+     * 函数: Erase
+     * 功能: 移除某个体的全部缓存项，在该体被重新加载时调用
+     */
+    void Erase(uint32_t volID) {
+        EraseIf([&](const Key &key) { return std::get<0>(key) == volID; });
+    }
+
+    void LogStatistics() const { LRUCache::LogStatistics("SmoothedVolumeCache"); }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_CACHE_H
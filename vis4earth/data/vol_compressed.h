@@ -0,0 +1,349 @@
+#ifndef VIS4EARTH_DATA_VOL_COMPRESSED_H
+#define VIS4EARTH_DATA_VOL_COMPRESSED_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string>
+
+#include <array>
+#include <vector>
+
+#include <QDebug>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/io/rle_codec.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: CompressedVolumeSeries
+ * 功能: 在内存中无损压缩存放时变体数据。每 keyframeInterval 个时间步取一个关键帧，
+ *       其余时间步存放与前一时间步的逐字节差（模 256），差值经 ZigZag 变换后按块内所需的
+ *       最少位数紧凑排列，最后进行游程编码，编码后不更小时跳过游程编码。
+ *       相邻时间步高度相关时差值多为 0 或很小，压缩率远高于直接编码。
+ *       编码与解码均按块并行；解码须从关键帧（或最近一次解码的同组时间步）逐步累加差值，
+ *       因此顺序播放时每步只需解码一个差值
+ */
+class CompressedVolumeSeries {
+  public:
+    struct Statistics {
+        uint32_t timeNum;
+        uint32_t keyframeNum;
+        size_t rawBytes;        // 未压缩的总字节数
+        size_t compressedBytes; // 压缩后的总字节数
+        uint64_t decodedNum;    // 已解码的时间步数
+        size_t decodedBytes;    // 已解码的总字节数
+        double decodeMilliseconds;
+    };
+
+    explicit CompressedVolumeSeries(uint32_t keyframeInterval = 8,
+                                    size_t chunkByteSize = size_t(1) << 20)
+        : keyframeInterval(std::max(1u, keyframeInterval)),
+          chunkByteSize(std::max(size_t(1), chunkByteSize)) {}
+
+    CompressedVolumeSeries(const CompressedVolumeSeries &) = delete;
+    CompressedVolumeSeries &operator=(const CompressedVolumeSeries &) = delete;
+
+    uint32_t GetTimeNumber() const { return static_cast<uint32_t>(steps.size()); }
+    uint32_t GetKeyframeInterval() const { return keyframeInterval; }
+    /*
+     * 函数: SetKeyframeInterval
+     * 功能: 设置关键帧间隔，仅在序列为空时生效
+     */
+    void SetKeyframeInterval(uint32_t keyframeInterval) {
+        if (steps.empty())
+            this->keyframeInterval = std::max(1u, keyframeInterval);
+    }
+
+    /*
+     * 函数: Clear
+     * 功能: 清空序列与统计信息
+     */
+    void Clear() {
+        std::lock_guard<std::mutex> lk(mtx);
+        steps.clear();
+        lastVol = RAWVolumeData();
+        rawBytes = compressedBytes = 0;
+        decodedNum = decodedBytes = 0;
+        decodeMilliseconds = 0.;
+        cachedTimeID = std::numeric_limits<uint32_t>::max();
+        cachedVol = RAWVolumeData();
+    }
+
+    /*
+     * 函数: Append
+     * 功能: 编码 vol 并追加为最后一个时间步。体素类型或尺寸与前一时间步不同时另起关键帧
+     * 返回: 错误信息，为空表示成功
+     * 注意: 保留最后一个时间步的未压缩数据（与其来源共享缓冲），用于计算下一时间步的差值
+     */
+    std::string Append(const RAWVolumeData &vol) {
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+
+        Step step;
+        step.voxPerVol = vol.GetVoxelPerVolume();
+        step.voxTy = vol.GetVoxelType();
+        auto isKeyframe = steps.empty() ||
+                          steps.size() - steps.back().keyTimeID >= keyframeInterval ||
+                          step.voxPerVol != lastVol.GetVoxelPerVolume() ||
+                          step.voxTy != lastVol.GetVoxelType();
+        step.keyTimeID = isKeyframe ? GetTimeNumber() : steps.back().keyTimeID;
+
+        auto datSz = vol.GetDataSize();
+        auto chunkNum = static_cast<uint32_t>((datSz + chunkByteSize - 1) / chunkByteSize);
+        std::vector<std::vector<uint8_t>> encodeds(chunkNum);
+        step.chunks.resize(chunkNum);
+        auto dat = vol.GetData();
+        auto prevDat = isKeyframe ? nullptr : lastVol.GetData();
+        ThreadPool::Global().ParallelFor(0, chunkNum, [&](uint32_t ci) {
+            auto offs = ci * chunkByteSize;
+            auto sz = std::min(chunkByteSize, datSz - offs);
+            auto &chunk = step.chunks[ci];
+            chunk.bitNum = 8;
+
+            std::vector<uint8_t> packed;
+            auto src = dat + offs;
+            if (prevDat) {
+                uint8_t maxZigZag = 0;
+                packed.resize(sz);
+                for (size_t i = 0; i < sz; ++i) {
+                    packed[i] = toZigZag(static_cast<uint8_t>(src[i] - prevDat[offs + i]));
+                    maxZigZag = std::max(maxZigZag, packed[i]);
+                }
+                while (chunk.bitNum > 0 && (maxZigZag >> (chunk.bitNum - 1)) == 0)
+                    --chunk.bitNum;
+                if (chunk.bitNum < 8)
+                    pack(packed, chunk.bitNum);
+                src = packed.data();
+                sz = packed.size();
+            }
+
+            auto &encoded = encodeds[ci];
+            RLECodec::Encode(src, sz, encoded);
+            chunk.rle = encoded.size() < sz;
+            if (!chunk.rle)
+                encoded.assign(src, src + sz);
+        });
+
+        size_t totSz = 0;
+        for (uint32_t ci = 0; ci < chunkNum; ++ci) {
+            step.chunks[ci].offset = totSz;
+            step.chunks[ci].byteSize = encodeds[ci].size();
+            totSz += encodeds[ci].size();
+        }
+        step.dat.reserve(totSz);
+        for (auto &encoded : encodeds)
+            step.dat.insert(step.dat.end(), encoded.begin(), encoded.end());
+
+        lastVol = vol;
+        rawBytes += datSz;
+        compressedBytes += totSz;
+        steps.emplace_back(std::move(step));
+        return "";
+    }
+
+    /*
+     * 函数: Decode
+     * 功能: 并行解码第 timeID 个时间步
+     */
+    ReteurnOrError<RAWVolumeData> Decode(uint32_t timeID) const {
+        if (timeID >= steps.size())
+            return "Invalid timeID.";
+
+        auto start = std::chrono::steady_clock::now();
+        auto &step = steps[timeID];
+        auto datSz = RAWVolumeData::GetVoxelSize(step.voxTy) * step.voxPerVol[0] *
+                     step.voxPerVol[1] * step.voxPerVol[2];
+        std::vector<uint8_t> dat(datSz);
+
+        // 最近一次解码的时间步与 timeID 同属一个关键帧且更早时，从它开始累加差值
+        RAWVolumeData baseVol;
+        auto baseTimeID = step.keyTimeID;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (cachedTimeID < steps.size() && steps[cachedTimeID].keyTimeID == step.keyTimeID &&
+                cachedTimeID <= timeID) {
+                baseTimeID = cachedTimeID;
+                baseVol = cachedVol;
+            }
+        }
+
+        std::atomic<bool> ok(true);
+        auto chunkNum = static_cast<uint32_t>(step.chunks.size());
+        ThreadPool::Global().ParallelFor(0, chunkNum, [&](uint32_t ci) {
+            auto offs = ci * chunkByteSize;
+            auto sz = std::min(chunkByteSize, datSz - offs);
+            auto out = dat.data() + offs;
+            if (baseVol.GetDataSize() != 0)
+                std::memcpy(out, baseVol.GetData() + offs, sz);
+            else if (!decodeChunk(steps[baseTimeID].chunks[ci], steps[baseTimeID], out, sz)) {
+                ok = false;
+                return;
+            }
+
+            std::vector<uint8_t> delta(sz);
+            for (auto t = baseTimeID + 1; t <= timeID; ++t) {
+                if (!decodeChunk(steps[t].chunks[ci], steps[t], delta.data(), sz)) {
+                    ok = false;
+                    return;
+                }
+                for (size_t i = 0; i < sz; ++i)
+                    out[i] += fromZigZag(delta[i]);
+            }
+        });
+        if (!ok)
+            return "Broken compressed data.";
+
+        auto vol = RAWVolumeData::CreateFromData(step.voxPerVol, step.voxTy, std::move(dat));
+        auto ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                .count();
+        std::lock_guard<std::mutex> lk(mtx);
+        cachedTimeID = timeID;
+        cachedVol = vol.result.dat;
+        ++decodedNum;
+        decodedBytes += datSz;
+        decodeMilliseconds += ms;
+        return vol;
+    }
+
+    Statistics GetStatistics() const {
+        std::lock_guard<std::mutex> lk(mtx);
+        Statistics stats;
+        stats.timeNum = GetTimeNumber();
+        stats.keyframeNum = 0;
+        for (uint32_t t = 0; t < steps.size(); ++t)
+            if (steps[t].keyTimeID == t)
+                ++stats.keyframeNum;
+        stats.rawBytes = rawBytes;
+        stats.compressedBytes = compressedBytes;
+        stats.decodedNum = decodedNum;
+        stats.decodedBytes = decodedBytes;
+        stats.decodeMilliseconds = decodeMilliseconds;
+        return stats;
+    }
+    // 未压缩字节数与压缩后字节数之比
+    double GetCompressionRatio() const {
+        return compressedBytes == 0 ? 1. : static_cast<double>(rawBytes) / compressedBytes;
+    }
+    // 解码吞吐量，单位为 MB/s（按解码后的字节数计）
+    double GetDecodeThroughput() const {
+        auto stats = GetStatistics();
+        return stats.decodeMilliseconds == 0.
+                   ? 0.
+                   : stats.decodedBytes / (1000. * stats.decodeMilliseconds);
+    }
+
+    void LogStatistics() const {
+        auto stats = GetStatistics();
+        qDebug() << "CompressedVolumeSeries:" << stats.timeNum << "time steps,"
+                 << stats.keyframeNum << "keyframes," << stats.rawBytes << "->"
+                 << stats.compressedBytes << "bytes, ratio" << GetCompressionRatio() << ","
+                 << stats.decodedNum << "decoded at" << GetDecodeThroughput() << "MB/s";
+    }
+
+  private:
+    struct Chunk {
+        size_t offset;
+        size_t byteSize;
+        uint8_t bitNum; // 差值的位数，8 时不紧凑排列，关键帧恒为 8 且不做 ZigZag 变换
+        bool rle;       // 为 false 时不经游程编码
+    };
+    struct Step {
+        uint32_t keyTimeID; // 所属关键帧，等于自身序号时即为关键帧
+        std::array<uint32_t, 3> voxPerVol;
+        ESupportedVoxelType voxTy;
+        std::vector<Chunk> chunks;
+        std::vector<uint8_t> dat;
+    };
+
+    uint32_t keyframeInterval;
+    size_t chunkByteSize;
+    std::vector<Step> steps;
+    RAWVolumeData lastVol;
+    size_t rawBytes = 0;
+    size_t compressedBytes = 0;
+
+    mutable std::mutex mtx; // 保护以下解码缓存与统计
+    mutable uint32_t cachedTimeID = std::numeric_limits<uint32_t>::max();
+    mutable RAWVolumeData cachedVol;
+    mutable uint64_t decodedNum = 0;
+    mutable size_t decodedBytes = 0;
+    mutable double decodeMilliseconds = 0.;
+
+    // 将 -1, 1, -2, ... 映射为 1, 2, 3, ...，使小幅度的负差值也只占低位
+    static uint8_t toZigZag(uint8_t delta) {
+        return static_cast<uint8_t>((delta << 1) ^ ((delta & 0x80) ? 0xff : 0x00));
+    }
+    static uint8_t fromZigZag(uint8_t zigZag) {
+        return static_cast<uint8_t>((zigZag >> 1) ^ (0 - (zigZag & 1)));
+    }
+    // 将每个值的低 bitNum 位按顺序紧凑排列，结果覆盖 vals
+    static void pack(std::vector<uint8_t> &vals, uint8_t bitNum) {
+        size_t o = 0;
+        uint32_t acc = 0, accBitNum = 0;
+        for (auto v : vals) {
+            acc |= static_cast<uint32_t>(v) << accBitNum;
+            accBitNum += bitNum;
+            if (accBitNum >= 8) {
+                vals[o++] = static_cast<uint8_t>(acc);
+                acc >>= 8;
+                accBitNum -= 8;
+            }
+        }
+        if (accBitNum != 0)
+            vals[o++] = static_cast<uint8_t>(acc);
+        vals.resize(o);
+    }
+    static size_t getPackedByteSize(size_t valNum, uint8_t bitNum) {
+        return (valNum * bitNum + 7) / 8;
+    }
+
+    /*
+     * 函数: decodeChunk
+     * 功能: 将块解码为 dstSize 个字节。差值块输出 ZigZag 变换后的差值
+     */
+    static bool decodeChunk(const Chunk &chunk, const Step &step, uint8_t *dst, size_t dstSize) {
+        auto src = step.dat.data() + chunk.offset;
+        auto packedSz = getPackedByteSize(dstSize, chunk.bitNum);
+        std::vector<uint8_t> packed;
+        auto packedDst = dst;
+        if (chunk.bitNum < 8) {
+            packed.resize(packedSz);
+            packedDst = packed.data();
+        }
+
+        if (chunk.rle) {
+            if (!RLECodec::Decode(src, chunk.byteSize, packedDst, packedSz))
+                return false;
+        } else if (chunk.byteSize != packedSz)
+            return false;
+        else if (packedSz != 0)
+            std::memcpy(packedDst, src, packedSz);
+        if (chunk.bitNum == 8)
+            return true;
+
+        uint32_t acc = 0, accBitNum = 0;
+        uint8_t mask = static_cast<uint8_t>((1u << chunk.bitNum) - 1);
+        size_t i = 0;
+        for (size_t o = 0; o < dstSize; ++o) {
+            if (accBitNum < chunk.bitNum) {
+                acc |= static_cast<uint32_t>(packed[i++]) << accBitNum;
+                accBitNum += 8;
+            }
+            dst[o] = static_cast<uint8_t>(acc) & mask;
+            acc >>= chunk.bitNum;
+            accBitNum -= chunk.bitNum;
+        }
+        return true;
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_COMPRESSED_H
@@ -0,0 +1,445 @@
+#ifndef VIS4EARTH_DATA_VOL_CONTAINER_H
+#define VIS4EARTH_DATA_VOL_CONTAINER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <array>
+#include <vector>
+
+#include <QDebug>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/io/mapped_file.h>
+#include <vis4earth/io/rle_codec.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: VolumeContainer
+ * 功能: 自描述的时变体数据容器（*.v4e）。头部记录尺寸、体素类型、地理范围与各时间步的时间戳，
+ *       体数据按 z 方向每 slicePerChunk 个切片分块存放，块可单独压缩，并由块索引定位。
+ *       读取时只读映射整个文件，打开仅解析头部与索引，可随机读取任意时间步或子区域；
+ *       未压缩的时间步直接引用映射，不复制
+ * 文件布局（小端）:
+ * -- Header
+ * -- double timeStamps[timeNum]
+ * -- 各时间步的块数据，按时间步、z 顺序存放，每个时间步的起始处按页对齐
+ * -- ChunkEntry chunks[timeNum * chunkPerVol]，位于 Header::indexOffset 处
+ */
+class VolumeContainer {
+  public:
+    enum class ECodec : uint32_t { None = 0, RLE };
+    struct Info {
+        std::array<uint32_t, 3> voxPerVol;
+        ESupportedVoxelType voxTy;
+        uint32_t slicePerChunk;
+        std::array<float, 2> lonRange;    // 单位为度
+        std::array<float, 2> latRange;    // 单位为度
+        std::array<float, 2> heightRange; // 距地表高度，单位为米
+        std::vector<double> timeStamps;   // 长度即时间步数
+    };
+
+    static ReteurnOrError<std::shared_ptr<VolumeContainer>>
+    Open(const std::string &filePath,
+         MappedFile::EAccessHint hint = MappedFile::EAccessHint::Random) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::shared_ptr<VolumeContainer> container(new VolumeContainer);
+        container->mapped = MappedFile::Open(filePath, hint);
+        if (!container->mapped)
+            return "Invalid filePath.";
+
+        auto fileSz = container->mapped->GetSize();
+        auto fileDat = container->mapped->GetData();
+        Header header;
+        if (fileSz < sizeof(header))
+            return "Invalid file content, which is not a volume container.";
+        std::memcpy(&header, fileDat, sizeof(header));
+        if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0)
+            return "Invalid file content, which is not a volume container.";
+        if (header.version != Version)
+            return "Unsupported volume container version.";
+        if (header.voxTy > static_cast<uint32_t>(ESupportedVoxelType::Float32))
+            return "Unsupported voxel type.";
+        if (header.voxPerVol[0] == 0 || header.voxPerVol[1] == 0 || header.voxPerVol[2] == 0 ||
+            header.slicePerChunk == 0 || header.timeNum == 0)
+            return "Invalid file content, which has an empty volume.";
+
+        auto &info = container->info;
+        for (int i = 0; i < 3; ++i)
+            info.voxPerVol[i] = header.voxPerVol[i];
+        info.voxTy = static_cast<ESupportedVoxelType>(header.voxTy);
+        info.slicePerChunk = header.slicePerChunk;
+        info.lonRange = {header.lonRange[0], header.lonRange[1]};
+        info.latRange = {header.latRange[0], header.latRange[1]};
+        info.heightRange = {header.heightRange[0], header.heightRange[1]};
+
+        auto timeStampsSz = sizeof(double) * header.timeNum;
+        if (fileSz - sizeof(header) < timeStampsSz)
+            return "Invalid file content, which is truncated.";
+        info.timeStamps.resize(header.timeNum);
+        std::memcpy(info.timeStamps.data(), fileDat + sizeof(header), timeStampsSz);
+
+        auto chunkNum = static_cast<size_t>(header.timeNum) * container->GetChunkPerVolume();
+        if (header.indexOffset > fileSz ||
+            (fileSz - header.indexOffset) / sizeof(ChunkEntry) < chunkNum)
+            return "Invalid file content, which is truncated.";
+        container->chunks.resize(chunkNum);
+        std::memcpy(container->chunks.data(), fileDat + header.indexOffset,
+                    sizeof(ChunkEntry) * chunkNum);
+        for (size_t i = 0; i < chunkNum; ++i) {
+            auto &chunk = container->chunks[i];
+            if (chunk.offset > fileSz || fileSz - chunk.offset < chunk.byteSize ||
+                chunk.codec > static_cast<uint32_t>(ECodec::RLE) ||
+                (chunk.codec == static_cast<uint32_t>(ECodec::None) &&
+                 chunk.byteSize != container->getChunkByteSize(i % container->GetChunkPerVolume())))
+                return "Invalid file content, which has a broken chunk index.";
+        }
+
+        qDebug() << "Opened" << filePath.c_str() << "with" << header.timeNum << "time steps in"
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              start)
+                        .count()
+                 << "ms";
+        return container;
+    }
+
+    VolumeContainer(const VolumeContainer &) = delete;
+    VolumeContainer &operator=(const VolumeContainer &) = delete;
+
+    const Info &GetInfo() const { return info; }
+    uint32_t GetTimeNumber() const { return static_cast<uint32_t>(info.timeStamps.size()); }
+    uint32_t GetChunkPerVolume() const {
+        return (info.voxPerVol[2] + info.slicePerChunk - 1) / info.slicePerChunk;
+    }
+
+    /*
+     * 函数: ReadTimeStep
+     * 功能: 读取第 timeID 个时间步。各块均未压缩时直接引用映射，否则多线程解码到新缓冲
+     */
+    ReteurnOrError<RAWVolumeData> ReadTimeStep(uint32_t timeID) const {
+        if (timeID >= GetTimeNumber())
+            return "Invalid timeID.";
+
+        auto chunkPerVol = GetChunkPerVolume();
+        auto chunkItr = chunks.begin() + static_cast<size_t>(timeID) * chunkPerVol;
+        auto contiguous = true;
+        for (uint32_t ci = 0; ci < chunkPerVol && contiguous; ++ci)
+            contiguous = chunkItr[ci].codec == static_cast<uint32_t>(ECodec::None) &&
+                         chunkItr[ci].offset == chunkItr[0].offset + ci * getChunkByteSize(0);
+        if (contiguous)
+            return RAWVolumeData::CreateFromMappedFile(info.voxPerVol, info.voxTy, mapped,
+                                                       chunkItr[0].offset);
+
+        std::vector<uint8_t> dat(RAWVolumeData::GetVoxelSize(info.voxTy) * info.voxPerVol[0] *
+                                 info.voxPerVol[1] * info.voxPerVol[2]);
+        std::atomic<bool> ok(true);
+        ThreadPool::Global().ParallelFor(0, chunkPerVol, [&](uint32_t ci) {
+            if (!decodeChunk(chunkItr[ci], dat.data() + ci * getChunkByteSize(0),
+                             getChunkByteSize(ci)))
+                ok = false;
+        });
+        if (!ok)
+            return "Invalid file content, which has a broken chunk.";
+
+        return RAWVolumeData::CreateFromData(info.voxPerVol, info.voxTy, std::move(dat));
+    }
+
+    /*
+     * 函数: ReadRegion
+     * 功能: 读取第 timeID 个时间步中以 beg 为起点、尺寸为 voxPerRegion 的子区域，
+     *       仅访问（解码）与之相交的块
+     */
+    ReteurnOrError<RAWVolumeData> ReadRegion(uint32_t timeID, const std::array<uint32_t, 3> &beg,
+                                             const std::array<uint32_t, 3> &voxPerRegion) const {
+        if (timeID >= GetTimeNumber())
+            return "Invalid timeID.";
+        for (int i = 0; i < 3; ++i)
+            if (voxPerRegion[i] == 0 || beg[i] >= info.voxPerVol[i] ||
+                info.voxPerVol[i] - beg[i] < voxPerRegion[i])
+                return "Invalid region, which is out of the volume.";
+
+        auto voxSz = RAWVolumeData::GetVoxelSize(info.voxTy);
+        auto rowSz = voxSz * voxPerRegion[0];
+        auto sliceSz = voxSz * info.voxPerVol[0] * info.voxPerVol[1];
+        std::vector<uint8_t> dat(rowSz * voxPerRegion[1] * voxPerRegion[2]);
+
+        auto chunkBeg = beg[2] / info.slicePerChunk;
+        auto chunkEnd = (beg[2] + voxPerRegion[2] - 1) / info.slicePerChunk + 1;
+        auto chunkItr = chunks.begin() + static_cast<size_t>(timeID) * GetChunkPerVolume();
+        std::atomic<bool> ok(true);
+        ThreadPool::Global().ParallelFor(chunkBeg, chunkEnd, [&](uint32_t ci) {
+            auto &chunk = chunkItr[ci];
+            const uint8_t *chunkDat = mapped->GetData() + chunk.offset;
+            std::vector<uint8_t> decoded;
+            if (chunk.codec != static_cast<uint32_t>(ECodec::None)) {
+                decoded.resize(getChunkByteSize(ci));
+                if (!decodeChunk(chunk, decoded.data(), decoded.size())) {
+                    ok = false;
+                    return;
+                }
+                chunkDat = decoded.data();
+            }
+
+            auto zBeg = std::max(beg[2], ci * info.slicePerChunk);
+            auto zEnd = std::min(beg[2] + voxPerRegion[2], (ci + 1) * info.slicePerChunk);
+            for (auto z = zBeg; z < zEnd; ++z)
+                for (uint32_t y = 0; y < voxPerRegion[1]; ++y)
+                    std::memcpy(dat.data() + ((z - beg[2]) * voxPerRegion[1] + y) * rowSz,
+                                chunkDat + (z - ci * info.slicePerChunk) * sliceSz +
+                                    voxSz * (static_cast<size_t>(beg[1] + y) * info.voxPerVol[0] +
+                                             beg[0]),
+                                rowSz);
+        });
+        if (!ok)
+            return "Invalid file content, which has a broken chunk.";
+
+        return RAWVolumeData::CreateFromData(voxPerRegion, info.voxTy, std::move(dat));
+    }
+
+  private:
+    friend class VolumeContainerWriter;
+
+    static constexpr uint32_t Version = 1;
+    static constexpr uint64_t PageSize = 4096;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t voxTy;
+        uint32_t voxPerVol[3];
+        uint32_t slicePerChunk;
+        uint32_t timeNum;
+        uint32_t reserved;
+        float lonRange[2];
+        float latRange[2];
+        float heightRange[2];
+        uint64_t indexOffset;
+    };
+    struct ChunkEntry {
+        uint64_t offset;
+        uint64_t byteSize; // 压缩后的字节数
+        uint32_t codec;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 72, "Header layout must not depend on the compiler.");
+    static_assert(sizeof(ChunkEntry) == 24, "ChunkEntry layout must not depend on the compiler.");
+
+    Info info;
+    std::shared_ptr<const MappedFile> mapped;
+    std::vector<ChunkEntry> chunks;
+
+    VolumeContainer() {}
+
+    static const char *magic() { return "V4EVOL\0"; } // 连同结尾的 '\0' 共 8 字节
+
+    // 第 chunkID 个块解码后的字节数，最后一块可能不足 slicePerChunk 个切片
+    size_t getChunkByteSize(uint32_t chunkID) const {
+        auto zBeg = chunkID * info.slicePerChunk;
+        auto zEnd = std::min(zBeg + info.slicePerChunk, info.voxPerVol[2]);
+        return RAWVolumeData::GetVoxelSize(info.voxTy) * info.voxPerVol[0] * info.voxPerVol[1] *
+               (zEnd - zBeg);
+    }
+    bool decodeChunk(const ChunkEntry &chunk, uint8_t *dst, size_t dstSize) const {
+        auto src = mapped->GetData() + chunk.offset;
+        switch (static_cast<ECodec>(chunk.codec)) {
+        case ECodec::None:
+            if (chunk.byteSize != dstSize)
+                return false;
+            std::memcpy(dst, src, dstSize);
+            return true;
+        case ECodec::RLE:
+            return RLECodec::Decode(src, chunk.byteSize, dst, dstSize);
+        default:
+            return false;
+        }
+    }
+};
+
+/*
+ * 类: VolumeContainerWriter
+ * 功能: 按时间顺序逐个追加时间步以写出 VolumeContainer，内存中只保留当前时间步
+ */
+class VolumeContainerWriter {
+  public:
+    /*
+     * 函数: Create
+     * 功能: 创建容器文件并写入头部，info.timeStamps 的长度决定应追加的时间步数
+     * 参数:
+     * -- compress: 为 true 时逐块尝试 RLE 压缩，仅保留变小的结果
+     */
+    static ReteurnOrError<std::shared_ptr<VolumeContainerWriter>>
+    Create(const std::string &filePath, const VolumeContainer::Info &info, bool compress) {
+        if (info.voxPerVol[0] == 0 || info.voxPerVol[1] == 0 || info.voxPerVol[2] == 0 ||
+            info.slicePerChunk == 0 || info.timeStamps.empty())
+            return "Invalid info.";
+
+        std::shared_ptr<VolumeContainerWriter> writer(new VolumeContainerWriter);
+        writer->info = info;
+        writer->compress = compress;
+        writer->os.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!writer->os.is_open())
+            return "Invalid filePath.";
+
+        writer->writeHeader(0);
+        writer->os.write(reinterpret_cast<const char *>(info.timeStamps.data()),
+                         sizeof(double) * info.timeStamps.size());
+        if (!writer->os)
+            return "Failed to write file.";
+        return writer;
+    }
+
+    /*
+     * 函数: ConvertFromRAWFiles
+     * 功能: 将按时间顺序排列的 RAW 文件序列转换为容器，逐个映射读取，内存中只保留一个时间步
+     * 参数:
+     * -- info: 容器信息，info.timeStamps 为空时以文件序号作为时间戳
+     * 返回: 错误信息，成功时为空
+     */
+    static std::string ConvertFromRAWFiles(const std::string &filePath,
+                                           const std::vector<std::string> &rawFilePaths,
+                                           VolumeContainer::Info info, bool compress) {
+        if (rawFilePaths.empty())
+            return "Empty rawFilePaths.";
+        if (info.timeStamps.empty())
+            for (size_t i = 0; i < rawFilePaths.size(); ++i)
+                info.timeStamps.emplace_back(static_cast<double>(i));
+        if (info.timeStamps.size() != rawFilePaths.size())
+            return "timeStamps does not match rawFilePaths.";
+
+        auto writer = Create(filePath, info, compress);
+        if (!writer.ok)
+            return writer.result.errMsg;
+
+        for (auto &rawFilePath : rawFilePaths) {
+            auto vol = RAWVolumeData::LoadFromFile(RAWVolumeData::FromFileParameters{
+                info.voxPerVol, info.voxTy, rawFilePath, RAWVolumeData::EStorageMode::MemoryMapped,
+                MappedFile::EAccessHint::Sequential});
+            if (!vol.ok)
+                return rawFilePath + ": " + vol.result.errMsg;
+
+            auto errMsg = writer.result.dat->Append(vol.result.dat);
+            if (!errMsg.empty())
+                return errMsg;
+        }
+        return writer.result.dat->Finish();
+    }
+
+    VolumeContainerWriter(const VolumeContainerWriter &) = delete;
+    VolumeContainerWriter &operator=(const VolumeContainerWriter &) = delete;
+
+    /*
+     * 函数: Append
+     * 功能: 追加下一个时间步
+     * 返回: 错误信息，成功时为空
+     */
+    std::string Append(const RAWVolumeData &vol) {
+        if (chunks.size() >= info.timeStamps.size() * getChunkPerVolume())
+            return "Too many time steps.";
+        if (vol.GetVoxelPerVolume() != info.voxPerVol || vol.GetVoxelType() != info.voxTy)
+            return "Volume does not match the container.";
+
+        // 时间步起始处按页对齐，使未压缩的时间步映射后满足任意体素类型的对齐要求
+        auto pageSz = VolumeContainer::PageSize;
+        auto offs = static_cast<uint64_t>(os.tellp());
+        std::vector<uint8_t> buf((pageSz - offs % pageSz) % pageSz, 0);
+        os.write(reinterpret_cast<const char *>(buf.data()), buf.size());
+        offs += buf.size();
+
+        auto sliceSz = vol.GetDataSize() / info.voxPerVol[2];
+        for (uint32_t ci = 0; ci < getChunkPerVolume(); ++ci) {
+            auto zBeg = ci * info.slicePerChunk;
+            auto zEnd = std::min(zBeg + info.slicePerChunk, info.voxPerVol[2]);
+            auto src = vol.GetData() + zBeg * sliceSz;
+            auto srcSz = (zEnd - zBeg) * sliceSz;
+
+            ChunkEntry chunk = {offs, srcSz, static_cast<uint32_t>(ECodec::None), 0};
+            if (compress) {
+                buf.clear();
+                RLECodec::Encode(src, srcSz, buf);
+                if (buf.size() < srcSz) {
+                    chunk.byteSize = buf.size();
+                    chunk.codec = static_cast<uint32_t>(ECodec::RLE);
+                    src = buf.data();
+                }
+            }
+            os.write(reinterpret_cast<const char *>(src), chunk.byteSize);
+            offs += chunk.byteSize;
+            rawByteSize += srcSz;
+            chunks.emplace_back(chunk);
+        }
+
+        if (!os)
+            return "Failed to write file.";
+        return "";
+    }
+
+    /*
+     * 函数: Finish
+     * 功能: 写入块索引并回填头部，须在追加完全部时间步后调用
+     * 返回: 错误信息，成功时为空
+     */
+    std::string Finish() {
+        if (chunks.size() != info.timeStamps.size() * getChunkPerVolume())
+            return "Too few time steps.";
+
+        auto indexOffset = static_cast<uint64_t>(os.tellp());
+        os.write(reinterpret_cast<const char *>(chunks.data()), sizeof(ChunkEntry) * chunks.size());
+        auto fileSz = static_cast<uint64_t>(os.tellp());
+        os.seekp(0);
+        writeHeader(indexOffset);
+        os.close();
+        if (!os)
+            return "Failed to write file.";
+
+        qDebug() << "Wrote volume container with" << info.timeStamps.size() << "time steps,"
+                 << fileSz << "/" << rawByteSize << "bytes";
+        return "";
+    }
+
+  private:
+    using ECodec = VolumeContainer::ECodec;
+    using Header = VolumeContainer::Header;
+    using ChunkEntry = VolumeContainer::ChunkEntry;
+
+    VolumeContainer::Info info;
+    bool compress;
+    std::ofstream os;
+    std::vector<ChunkEntry> chunks;
+    uint64_t rawByteSize = 0; // 压缩前的体素字节数
+
+    VolumeContainerWriter() {}
+
+    uint32_t getChunkPerVolume() const {
+        return (info.voxPerVol[2] + info.slicePerChunk - 1) / info.slicePerChunk;
+    }
+    void writeHeader(uint64_t indexOffset) {
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, VolumeContainer::magic(), sizeof(header.magic));
+        header.version = VolumeContainer::Version;
+        header.voxTy = static_cast<uint32_t>(info.voxTy);
+        for (int i = 0; i < 3; ++i)
+            header.voxPerVol[i] = info.voxPerVol[i];
+        header.slicePerChunk = info.slicePerChunk;
+        header.timeNum = static_cast<uint32_t>(info.timeStamps.size());
+        for (int i = 0; i < 2; ++i) {
+            header.lonRange[i] = info.lonRange[i];
+            header.latRange[i] = info.latRange[i];
+            header.heightRange[i] = info.heightRange[i];
+        }
+        header.indexOffset = indexOffset;
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_CONTAINER_H
@@ -2,8 +2,12 @@
 #define VIS4EARTH_DATA_VOL_DATA_H
 
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <limits>
+#include <memory>
 #include <string>
 
 #include <array>
@@ -14,17 +18,57 @@
 
 #include <osg/Texture3D>
 
+#include <vis4earth/io/mapped_file.h>
+#include <vis4earth/thread_pool.h>
 #include <vis4earth/util.h>
 
 namespace VIS4Earth {
-enum class ESupportedVoxelType { UInt8 = 0 };
+enum class ESupportedVoxelType { UInt8 = 0, UInt16, Float32 };
+
+/*
+ * 结构体: VoxelTypeTraits
+ * 功能: 体素类型的编译期属性，各处理核按体素类型特化，逐体素计算中不做类型分支。
+ *       整数类型以 [0, Max()] 表示归一化的 [0, 1]，Float32 约定已归一化到 [0, 1]。
+ *       ToTFIndex 将体素值映射为 256 个采样点的传输函数下标
+ */
+template <typename T> struct VoxelTypeTraits;
+template <> struct VoxelTypeTraits<uint8_t> {
+    static ESupportedVoxelType Type() { return ESupportedVoxelType::UInt8; }
+    static GLenum PixelType() { return GL_UNSIGNED_BYTE; }
+    static GLint InternalFormat() { return GL_R8; }
+    static float Max() { return 255.f; }
+    static uint8_t FromFloat(float v) { return static_cast<uint8_t>(std::round(v)); }
+    static uint8_t ToTFIndex(uint8_t v) { return v; }
+};
+template <> struct VoxelTypeTraits<uint16_t> {
+    static ESupportedVoxelType Type() { return ESupportedVoxelType::UInt16; }
+    static GLenum PixelType() { return GL_UNSIGNED_SHORT; }
+    static GLint InternalFormat() { return GL_R16; }
+    static float Max() { return 65535.f; }
+    static uint16_t FromFloat(float v) { return static_cast<uint16_t>(std::round(v)); }
+    static uint8_t ToTFIndex(uint16_t v) { return static_cast<uint8_t>((v + 128u) / 257u); }
+};
+template <> struct VoxelTypeTraits<float> {
+    static ESupportedVoxelType Type() { return ESupportedVoxelType::Float32; }
+    static GLenum PixelType() { return GL_FLOAT; }
+    static GLint InternalFormat() { return GL_R32F; }
+    static float Max() { return 1.f; }
+    static float FromFloat(float v) { return v; }
+    static uint8_t ToTFIndex(float v) {
+        return static_cast<uint8_t>(std::round(std::min(1.f, std::max(0.f, v)) * 255.f));
+    }
+};
 
 class RAWVolumeData {
   public:
+    // InMemory: 将文件完整读入 std::vector；MemoryMapped: 只读映射文件，按需换页，不复制
+    enum class EStorageMode { InMemory = 0, MemoryMapped };
     struct FromFileParameters {
         std::array<uint32_t, 3> voxPerVol;
         ESupportedVoxelType voxTy;
         std::string filePath;
+        EStorageMode storageMode;
+        MappedFile::EAccessHint accessHint; // 仅 MemoryMapped 时有效
     };
     static ReteurnOrError<RAWVolumeData> LoadFromFile(const FromFileParameters &param) {
         if (param.voxPerVol[0] == 0 || param.voxPerVol[1] == 0 || param.voxPerVol[2] == 0)
@@ -35,21 +79,100 @@ class RAWVolumeData {
         vol.voxPerVolYxX =
             static_cast<decltype(vol.voxPerVolYxX)>(vol.voxPerVol[0]) * vol.voxPerVol[1];
 
-        std::ifstream is(param.filePath, std::ios::binary | std::ios::in | std::ios::ate);
-        if (!is.is_open())
-            return "Invalid filePath.";
-        auto readSz =
-            GetVoxelSize(vol.voxTy) * vol.voxPerVol[0] * vol.voxPerVol[1] * vol.voxPerVol[2];
-        {
-            auto pos = is.tellg();
-            is.seekg(0, std::ios::beg);
-            if (pos - is.tellg() < readSz)
-                return "Invalid file content, which is not enough for voxPerVol.";
+        auto start = std::chrono::steady_clock::now();
+        auto readSz = GetVoxelSize(vol.voxTy) * vol.voxPerVolYxX * vol.voxPerVol[2];
+        std::string mapErrMsg;
+        if (param.storageMode == EStorageMode::MemoryMapped) {
+            auto mapped = MappedFile::Open(param.filePath, param.accessHint, &mapErrMsg);
+            if (mapped) {
+                if (mapped->GetSize() < readSz)
+                    return "Invalid file content, which is not enough for voxPerVol.";
+                vol.mappedDat = mapped;
+            } else
+                // 无法映射时（如地址空间不足、文件系统不支持映射）退回完整读入
+                qDebug() << "Map" << param.filePath.c_str() << "failed:" << mapErrMsg.c_str()
+                         << ", fall back to reading into memory";
         }
+        if (!vol.mappedDat) {
+            std::ifstream is(param.filePath, std::ios::binary | std::ios::in | std::ios::ate);
+            if (!is.is_open())
+                return mapErrMsg.empty()
+                           ? "Invalid filePath."
+                           : ("Invalid filePath (mapping: " + mapErrMsg + ").").c_str();
+            {
+                auto pos = is.tellg();
+                is.seekg(0, std::ios::beg);
+                if (pos - is.tellg() < readSz)
+                    return "Invalid file content, which is not enough for voxPerVol.";
+            }
 
-        vol.dat.resize(readSz);
-        is.read(reinterpret_cast<char *>(vol.dat.data()), readSz);
+            is.read(reinterpret_cast<char *>(vol.allocate(readSz)), readSz);
+        }
 
+        qDebug() << "Loaded" << param.filePath.c_str()
+                 << (vol.IsMemoryMapped() ? "(mapped)" : "(copied)") << "in"
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              start)
+                        .count()
+                 << "ms, resident" << vol.GetResidentBytes() << "bytes";
+        return vol;
+    }
+
+    /*
+     * 函数: CreateFromMappedFile
+     * 功能: 由只读映射中从 offs 起的体素数据构造体数据，不复制，体数据持有映射的引用
+     */
+    static ReteurnOrError<RAWVolumeData>
+    CreateFromMappedFile(const std::array<uint32_t, 3> &voxPerVol, ESupportedVoxelType voxTy,
+                         std::shared_ptr<const MappedFile> mapped, size_t offs) {
+        RAWVolumeData vol;
+        vol.voxTy = voxTy;
+        vol.voxPerVol = voxPerVol;
+        vol.voxPerVolYxX =
+            static_cast<decltype(vol.voxPerVolYxX)>(vol.voxPerVol[0]) * vol.voxPerVol[1];
+        if (!mapped || vol.GetDataSize() == 0 || offs > mapped->GetSize() ||
+            mapped->GetSize() - offs < vol.GetDataSize())
+            return "Invalid mapped, which is not enough for voxPerVol.";
+
+        vol.mappedDat = std::move(mapped);
+        vol.mappedOffs = offs;
+        return vol;
+    }
+
+    /*
+     * 函数: CreateFromData
+     * 功能: 由内存中的体素数据构造体数据，dat 的大小应与 voxPerVol、voxTy 相符
+     */
+    static ReteurnOrError<RAWVolumeData> CreateFromData(const std::array<uint32_t, 3> &voxPerVol,
+                                                        ESupportedVoxelType voxTy,
+                                                        std::vector<uint8_t> dat) {
+        RAWVolumeData vol;
+        vol.voxTy = voxTy;
+        vol.voxPerVol = voxPerVol;
+        vol.voxPerVolYxX =
+            static_cast<decltype(vol.voxPerVolYxX)>(vol.voxPerVol[0]) * vol.voxPerVol[1];
+        if (vol.GetDataSize() == 0 || dat.size() != vol.GetDataSize())
+            return "Invalid dat, which does not match voxPerVol.";
+
+        vol.adopt(std::move(dat));
+        return vol;
+    }
+    /*
+     * 函数: CreateFromVoxels
+     * 功能: 接管类型为 T 的体素数组构造体数据，不复制，体素类型由 T 确定
+     */
+    template <typename T>
+    static ReteurnOrError<RAWVolumeData> CreateFromVoxels(const std::array<uint32_t, 3> &voxPerVol,
+                                                          std::vector<T> dat) {
+        RAWVolumeData vol;
+        vol.voxTy = VoxelTypeTraits<T>::Type();
+        vol.voxPerVol = voxPerVol;
+        vol.voxPerVolYxX =
+            static_cast<decltype(vol.voxPerVolYxX)>(vol.voxPerVol[0]) * vol.voxPerVol[1];
+        if (vol.GetDataSize() == 0 || dat.size() * sizeof(T) != vol.GetDataSize())
+            return "Invalid dat, which does not match voxPerVol.";
+
+        vol.adopt(std::move(dat));
         return vol;
     }
 
@@ -59,7 +182,7 @@ class RAWVolumeData {
         std::array<uint32_t, 3> targetVoxPerVol;
     };
     ReteurnOrError<RAWVolumeData> GetResized(const ResizeParameters &param) const {
-        if (dat.empty())
+        if (GetDataSize() == 0)
             return "Invalid vol.";
         if (param.targetVoxPerVol[0] == 0 || param.targetVoxPerVol[1] == 0 ||
             param.targetVoxPerVol[2] == 0 || param.targetVoxPerVol[0] > 2 * voxPerVol[0] ||
@@ -74,135 +197,21 @@ class RAWVolumeData {
         volOut.voxPerVol = param.targetVoxPerVol;
         volOut.voxPerVolYxX =
             static_cast<decltype(volOut.voxPerVolYxX)>(volOut.voxPerVol[0]) * volOut.voxPerVol[1];
+        volOut.allocate(volOut.GetDataSize());
 
-        std::array<float, 3> scale = {1.f * voxPerVol[0] / volOut.voxPerVol[0],
-                                      1.f * voxPerVol[1] / volOut.voxPerVol[1],
-                                      1.f * voxPerVol[2] / volOut.voxPerVol[2]};
-
-        volOut.dat.resize(volOut.GetVoxelSize() * volOut.voxPerVolYxX * volOut.voxPerVol[2]);
-        auto append = [&](uint32_t x, uint32_t y, uint32_t z) {
-            auto offsOut = z * volOut.voxPerVolYxX + y * volOut.voxPerVol[0] + x;
-            std::array<float, 3> posIn = {scale[0] * x, scale[1] * y, scale[2] * z};
-
-            std::array<std::array<uint32_t, 2>, 3> posInRng = {
-                std::array<uint32_t, 2>{static_cast<uint32_t>(floorf(posIn[0])),
-                                        static_cast<uint32_t>(ceilf(posIn[0]))},
-                std::array<uint32_t, 2>{static_cast<uint32_t>(floorf(posIn[1])),
-                                        static_cast<uint32_t>(ceilf(posIn[1]))},
-                std::array<uint32_t, 2>{static_cast<uint32_t>(floorf(posIn[2])),
-                                        static_cast<uint32_t>(ceilf(posIn[2]))}};
-
-            auto valIn = 0.f;
-
-            // 使用 switch 语句来选择插值方法
-            switch (param.filterType) {
-            case EFilterType::Linear: {
-                // 线性插值
-                std::array<float, 3> omegas = {posInRng[0][1] - posInRng[0][0],
-                                               posInRng[1][1] - posInRng[1][0],
-                                               posInRng[2][1] - posInRng[2][0]};
-                omegas[0] = omegas[0] == 0.f ? 0.f : (posIn[0] - posInRng[0][0]) / omegas[0];
-                omegas[1] = omegas[1] == 0.f ? 0.f : (posIn[1] - posInRng[1][0]) / omegas[1];
-                omegas[2] = omegas[2] == 0.f ? 0.f : (posIn[2] - posInRng[2][0]) / omegas[2];
-
-                for (uint8_t zi = 0; zi < 2; ++zi)
-                    for (uint8_t yi = 0; yi < 2; ++yi)
-                        for (uint8_t xi = 0; xi < 2; ++xi) {
-                            auto omega = (zi == 0 ? 1.f - omegas[2] : omegas[2]) *
-                                         (yi == 0 ? 1.f - omegas[1] : omegas[1]) *
-                                         (xi == 0 ? 1.f - omegas[0] : omegas[0]);
-                            valIn += omega * Sample<uint8_t>(posInRng[0][xi], posInRng[1][yi],
-                                                             posInRng[2][zi]);
-                        }
-                break;
-            }
-
-            case EFilterType::Kriging: {
-                // 克里金插值相关的 Lambda 表达式
-                auto variogram = [](double h, double sill = 1.0, double nugget = 0.0,
-                                    double rangeParam = 1.0) {
-                    return nugget + sill * (1 - std::exp(-h / rangeParam));
-                };
-
-                auto euclideanDistance = [](const std::array<float, 3> &p1,
-                                            const std::array<float, 3> &p2) {
-                    double sum = 0.0;
-                    for (int i = 0; i < 3; ++i) {
-                        sum += (p1[i] - p2[i]) * (p1[i] - p2[i]);
-                    }
-                    return std::sqrt(sum);
-                };
-
-                auto computeKrigingWeights =
-                    [&](const std::array<std::array<uint32_t, 2>, 3> &posInRng,
-                        const std::array<float, 3> &posIn) {
-                        const int numPoints = 8; // 周围8个相邻点
-                        std::array<std::array<float, 3>, 8> points;
-                        std::array<double, 9> variogramValues;
-
-                        // 获取相邻点坐标
-                        int index = 0;
-                        for (int zi = 0; zi < 2; ++zi) {
-                            for (int yi = 0; yi < 2; ++yi) {
-                                for (int xi = 0; xi < 2; ++xi) {
-                                    points[index] = {static_cast<float>(posInRng[0][xi]),
-                                                     static_cast<float>(posInRng[1][yi]),
-                                                     static_cast<float>(posInRng[2][zi])};
-                                    ++index;
-                                }
-                            }
-                        }
-
-                        // 计算相邻点的变异函数矩阵
-                        std::array<std::array<double, 8>, 8> matrix;
-                        for (int i = 0; i < numPoints; ++i) {
-                            for (int j = 0; j < numPoints; ++j) {
-                                matrix[i][j] = variogram(euclideanDistance(points[i], points[j]));
-                            }
-                        }
-
-                        // 计算目标点与相邻点的变异函数向量
-                        for (int i = 0; i < numPoints; ++i) {
-                            variogramValues[i] = variogram(euclideanDistance(points[i], posIn));
-                        }
-
-                        // 求解克里金权重 (这里使用简单的伪逆法)
-                        std::array<double, 8> weights;
-                        double sumVariogramValues = 0.0;
-                        for (int i = 0; i < numPoints; ++i) {
-                            sumVariogramValues += variogramValues[i];
-                        }
-                        for (int i = 0; i < numPoints; ++i) {
-                            weights[i] = variogramValues[i] / sumVariogramValues;
-                        }
-
-                        return weights;
-                    };
-
-                auto weights = computeKrigingWeights(posInRng, posIn);
-                int index = 0;
-                for (uint8_t zi = 0; zi < 2; ++zi)
-                    for (uint8_t yi = 0; yi < 2; ++yi)
-                        for (uint8_t xi = 0; xi < 2; ++xi) {
-                            valIn +=
-                                weights[index] *
-                                Sample<uint8_t>(posInRng[0][xi], posInRng[1][yi], posInRng[2][zi]);
-                            ++index;
-                        }
-                break;
-            }
-
-            default:
-                assert(false); // 未知的插值类型
-            }
-
-            volOut.dat[offsOut] = static_cast<uint8_t>(std::round(valIn));
-        };
-
-        for (uint32_t z = 0; z < volOut.voxPerVol[2]; ++z)
-            for (uint32_t y = 0; y < volOut.voxPerVol[1]; ++y)
-                for (uint32_t x = 0; x < volOut.voxPerVol[0]; ++x)
-                    append(x, y, z);
+        switch (voxTy) {
+        case ESupportedVoxelType::UInt8:
+            resize<uint8_t>(volOut, param.filterType);
+            break;
+        case ESupportedVoxelType::UInt16:
+            resize<uint16_t>(volOut, param.filterType);
+            break;
+        case ESupportedVoxelType::Float32:
+            resize<float>(volOut, param.filterType);
+            break;
+        default:
+            assert(false);
+        }
 
         qDebug() << "End GetResized";
         return volOut;
@@ -210,20 +219,63 @@ class RAWVolumeData {
 
     enum class ESmoothType { Max = 0, Avg };
     enum class ESmoothDimension { XYZ = 0, XY };
+    // XYZ: 在 X、Y、Z 三个方向上光滑；XY: 仅在切片内光滑。
+    // 窗口为 [p - radius, p + radius]，越界部分不参与计算，radius 为 0 时按 1 处理
     struct SmoothParameters {
         ESmoothType smoothType;
         ESmoothDimension smoothDim;
+        uint32_t radius;
     };
     RAWVolumeData GetSmoothed(const SmoothParameters &param) const {
         switch (voxTy) {
         case ESupportedVoxelType::UInt8:
             return getSmoothed<uint8_t>(param);
+        case ESupportedVoxelType::UInt16:
+            return getSmoothed<uint16_t>(param);
+        case ESupportedVoxelType::Float32:
+            return getSmoothed<float>(param);
         default:
             assert(false);
         }
+        return *this;
     }
 
-    const std::vector<uint8_t> &GetData() const { return dat; }
+    const uint8_t *GetData() const {
+        return mappedDat ? mappedDat->GetData() + mappedOffs : dat.get();
+    }
+    /*
+     * 函数: GetMutableData
+     * 功能: 返回可写的体素指针。缓冲与其他体数据、纹理图像共享或位于只读映射中时，
+     *       先复制出独占的缓冲（写时复制），其余持有者看到的数据不变
+     */
+    uint8_t *GetMutableData() {
+        auto sz = GetDataSize();
+        if (sz == 0)
+            return nullptr;
+        if (!mappedDat && dat && dat.use_count() == 1)
+            return dat.get();
+
+        auto owner = getDataOwner(); // 复制完成前保持旧缓冲有效
+        auto src = GetData();
+        auto dst = allocate(sz);
+        std::memcpy(dst, src, sz);
+        return dst;
+    }
+    size_t GetDataSize() const { return GetVoxelSize() * voxPerVolYxX * voxPerVol[2]; }
+    bool IsMemoryMapped() const { return static_cast<bool>(mappedDat); }
+    void AdviseAccess(MappedFile::EAccessHint hint) const {
+        if (mappedDat)
+            mappedDat->Advise(hint);
+    }
+    /*
+     * 函数: GetResidentBytes
+     * 功能: 返回体素数据当前占用的物理内存字节数，映射模式下仅统计已换入的页
+     */
+    size_t GetResidentBytes() const {
+        return mappedDat ? mappedDat->GetResidentBytes(mappedOffs, GetDataSize())
+               : dat     ? GetDataSize()
+                         : 0;
+    }
     const std::array<uint32_t, 3> GetVoxelPerVolume() const { return voxPerVol; }
     ESupportedVoxelType GetVoxelType() const { return voxTy; }
     size_t GetVoxelSize() const { return GetVoxelSize(voxTy); }
@@ -231,7 +283,7 @@ class RAWVolumeData {
         x = std::min(x, voxPerVol[0] - 1);
         y = std::min(y, voxPerVol[1] - 1);
         z = std::min(z, voxPerVol[2] - 1);
-        return *(reinterpret_cast<const VoxTy *>(dat.data()) + z * voxPerVolYxX + y * voxPerVol[0] +
+        return *(reinterpret_cast<const VoxTy *>(GetData()) + z * voxPerVolYxX + y * voxPerVol[0] +
                  x);
     }
 
@@ -239,6 +291,10 @@ class RAWVolumeData {
         switch (Type) {
         case ESupportedVoxelType::UInt8:
             return sizeof(uint8_t);
+        case ESupportedVoxelType::UInt16:
+            return sizeof(uint16_t);
+        case ESupportedVoxelType::Float32:
+            return sizeof(float);
         default:
             assert(false);
         }
@@ -246,38 +302,82 @@ class RAWVolumeData {
     }
 
     static std::tuple<float, float, float> GetVoxelMinMaxExtent(ESupportedVoxelType Type) {
+        // 与 VoxelTypeTraits::Max 一致：Float32 约定已归一化到 [0, 1]
         switch (Type) {
         case ESupportedVoxelType::UInt8:
             return std::make_tuple(0.f, static_cast<float>(std::numeric_limits<uint8_t>::max()),
                                    static_cast<float>(std::numeric_limits<uint8_t>::max()));
+        case ESupportedVoxelType::UInt16:
+            return std::make_tuple(0.f, static_cast<float>(std::numeric_limits<uint16_t>::max()),
+                                   static_cast<float>(std::numeric_limits<uint16_t>::max()));
+        case ESupportedVoxelType::Float32:
+            return std::make_tuple(0.f, 1.f, 1.f);
         default:
             assert(false);
         }
         return std::make_tuple(0.f, 0.f, 1.f);
     }
 
-    osg::ref_ptr<osg::Texture3D> ToOSGTexture() const {
-        std::array<uint32_t, 3> targetVoxPerVol = {1, 1, 1};
+    // NonPowerOfTwo: 直接以原始尺寸上传，不重采样、不复制；
+    // PowerOfTwo: 先重采样到 2 的幂尺寸，供不支持 NPOT 纹理的设备使用
+    enum class ETextureSizeMode { NonPowerOfTwo = 0, PowerOfTwo };
+    // 各维不小于 voxPerVol 的 2 的幂尺寸，PowerOfTwo 模式下纹理重采样到此尺寸
+    static std::array<uint32_t, 3>
+    GetPowerOfTwoVoxelPerVolume(const std::array<uint32_t, 3> &voxPerVol) {
+        std::array<uint32_t, 3> potVoxPerVol = {1, 1, 1};
         for (int i = 0; i < 3; ++i)
-            while (targetVoxPerVol[i] < voxPerVol[i])
-                targetVoxPerVol[i] *= 2;
-
-        auto volResized = GetResized(ResizeParameters{EFilterType::Linear, targetVoxPerVol});
-
-        osg::ref_ptr<osg::Image> img = new osg::Image;
+            while (potVoxPerVol[i] < voxPerVol[i])
+                potVoxPerVol[i] *= 2;
+        return potVoxPerVol;
+    }
+    osg::ref_ptr<osg::Texture3D>
+    ToOSGTexture(ETextureSizeMode sizeMode = ETextureSizeMode::NonPowerOfTwo) const {
+        GLenum pixFmt = GL_RED;
+        GLenum pixTy = GL_UNSIGNED_BYTE;
+        GLint internalFmt = GL_R8;
         switch (voxTy) {
         case VIS4Earth::ESupportedVoxelType::UInt8:
-            img->allocateImage(targetVoxPerVol[0], targetVoxPerVol[1], targetVoxPerVol[2], GL_RED,
-                               GL_UNSIGNED_BYTE);
+            break;
+        case VIS4Earth::ESupportedVoxelType::UInt16:
+            pixTy = VoxelTypeTraits<uint16_t>::PixelType();
+            internalFmt = VoxelTypeTraits<uint16_t>::InternalFormat();
+            break;
+        case VIS4Earth::ESupportedVoxelType::Float32:
+            pixTy = VoxelTypeTraits<float>::PixelType();
+            internalFmt = VoxelTypeTraits<float>::InternalFormat();
             break;
         default:
             assert(false);
         }
-        img->setInternalTextureFormat(GL_RED);
-        memcpy(img->data(), volResized.result.dat.GetData().data(),
-                    GetVoxelSize() * targetVoxPerVol[2] * targetVoxPerVol[1] * targetVoxPerVol[0]);
+
+        auto potVoxPerVol = GetPowerOfTwoVoxelPerVolume(voxPerVol);
+        auto potDataSize = GetVoxelSize() * potVoxPerVol[0] * potVoxPerVol[1] * potVoxPerVol[2];
+
+        auto start = std::chrono::steady_clock::now();
+        osg::ref_ptr<osg::Image> img = new osg::Image;
+        if (sizeMode == ETextureSizeMode::PowerOfTwo) {
+            auto volResized = GetResized(ResizeParameters{EFilterType::Linear, potVoxPerVol});
+            img->allocateImage(potVoxPerVol[0], potVoxPerVol[1], potVoxPerVol[2], pixFmt, pixTy);
+            memcpy(img->data(), volResized.result.dat.GetData(), potDataSize);
+        } else {
+            // osg::Image 不接管内存，由 ImageDataOwner 持有体素缓冲（或文件映射）的引用，
+            // 保证纹理上传前数据有效
+            img->setImage(voxPerVol[0], voxPerVol[1], voxPerVol[2], pixFmt, pixFmt, pixTy,
+                          const_cast<uint8_t *>(GetData()), osg::Image::NO_DELETE, 1);
+            img->setUserData(new ImageDataOwner(getDataOwner()));
+        }
+        img->setInternalTextureFormat(internalFmt);
+
+        qDebug() << "ToOSGTexture"
+                 << (sizeMode == ETextureSizeMode::PowerOfTwo ? "(POT)" : "(NPOT)") << "in"
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              start)
+                        .count()
+                 << "ms, texture" << img->getTotalSizeInBytes() << "bytes, POT"
+                 << potDataSize << "bytes";
 
         osg::ref_ptr<osg::Texture3D> tex = new osg::Texture3D;
+        tex->setResizeNonPowerOfTwoHint(false);
         tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
         tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
         tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
@@ -290,65 +390,296 @@ class RAWVolumeData {
     }
 
   private:
-    std::array<uint32_t, 3> voxPerVol;
-    size_t voxPerVolYxX;
-    ESupportedVoxelType voxTy;
-    std::vector<uint8_t> dat;
+    std::array<uint32_t, 3> voxPerVol = {0, 0, 0};
+    size_t voxPerVolYxX = 0;
+    ESupportedVoxelType voxTy = ESupportedVoxelType::UInt8;
+    // 拷贝的体数据与导出的纹理图像共享同一份缓冲，共享期间不修改，写入经 GetMutableData 复制。
+    // 指向缓冲首字节，同时持有实际存储体素的 std::vector<T>（别名构造），可接管任意体素类型的数组
+    std::shared_ptr<uint8_t> dat;
+    std::shared_ptr<const MappedFile> mappedDat; // 非空时体素数据位于只读映射中，dat 为空
+    size_t mappedOffs = 0; // 体素数据在映射中的起始偏移
+
+    /*
+     * 类: ImageDataOwner
+     * 功能: 挂在 osg::Image 的 UserData 上，延长零拷贝图像所引用的体素数据的生命周期
+     */
+    struct ImageDataOwner : osg::Referenced {
+        std::shared_ptr<const void> owner;
+
+        explicit ImageDataOwner(std::shared_ptr<const void> owner) : owner(std::move(owner)) {}
+    };
 
-    template <typename T>
-    T smoothKernelMax(const T *dat, const std::array<int32_t, 3> &pos,
-                      ESmoothDimension smoothDim) const {
-        auto scalar = std::numeric_limits<T>::min();
-        std::array<int32_t, 3> dPos = {pos[0] == 0 ? 0 : -1, pos[1] == 0 ? 0 : -1,
-                                       smoothDim != ESmoothDimension::XY || pos[2] == 0 ? 0 : -1};
-        for (; dPos[2] < (smoothDim != ESmoothDimension::XY || pos[2] == voxPerVol[2] - 1 ? 1 : 2);
-             ++dPos[2])
-            for (; dPos[1] < (pos[1] == voxPerVol[1] - 1 ? 1 : 2); ++dPos[1])
-                for (; dPos[0] < (pos[0] == voxPerVol[0] - 1 ? 1 : 2); ++dPos[0]) {
-                    std::array<int32_t, 3> newPos = {pos[0] + dPos[0], pos[1] + dPos[1],
-                                                     pos[2] + dPos[2]};
-                    scalar = std::max(
-                        scalar,
-                        dat[newPos[2] * voxPerVolYxX + newPos[1] * voxPerVol[0] + newPos[0]]);
+    /*
+     * 函数: allocate
+     * 功能: 为本体数据分配新的体素缓冲（不影响与之共享旧缓冲的其他对象），返回可写指针
+     */
+    uint8_t *allocate(size_t sz) {
+        adopt(std::vector<uint8_t>(sz));
+        return dat.get();
+    }
+    /*
+     * 函数: adopt
+     * 功能: 接管 buf 作为本体数据的体素缓冲，不复制
+     */
+    template <typename T> void adopt(std::vector<T> &&buf) {
+        mappedDat.reset();
+        mappedOffs = 0;
+        auto owner = std::make_shared<std::vector<T>>(std::move(buf));
+        dat = std::shared_ptr<uint8_t>(owner, reinterpret_cast<uint8_t *>(owner->data()));
+    }
+    std::shared_ptr<const void> getDataOwner() const {
+        if (mappedDat)
+            return mappedDat;
+        return dat;
+    }
+
+    /*
+     * 结构体: ResampleAxis
+     * 功能: 重采样时单个轴上的查找表，记录每个输出坐标对应的输入坐标、
+     *       相邻两个输入体素的下标（原始与钳制后）及线性插值权重
+     */
+    struct ResampleAxis {
+        std::vector<float> posIns;
+        std::vector<std::array<uint32_t, 2>> rngs;
+        std::vector<std::array<uint32_t, 2>> clampedRngs;
+        std::vector<std::array<float, 2>> omegas;
+
+        ResampleAxis(uint32_t voxNumIn, uint32_t voxNumOut)
+            : posIns(voxNumOut), rngs(voxNumOut), clampedRngs(voxNumOut), omegas(voxNumOut) {
+            auto scale = 1.f * voxNumIn / voxNumOut;
+            for (uint32_t i = 0; i < voxNumOut; ++i) {
+                auto posIn = scale * i;
+                std::array<uint32_t, 2> rng = {static_cast<uint32_t>(floorf(posIn)),
+                                               static_cast<uint32_t>(ceilf(posIn))};
+                float omega = rng[1] - rng[0];
+                omega = omega == 0.f ? 0.f : (posIn - rng[0]) / omega;
+
+                posIns[i] = posIn;
+                rngs[i] = rng;
+                clampedRngs[i] = {std::min(rng[0], voxNumIn - 1), std::min(rng[1], voxNumIn - 1)};
+                omegas[i] = {1.f - omega, omega};
+            }
+        }
+    };
+
+    template <typename T> void resize(RAWVolumeData &volOut, EFilterType filterType) const {
+        std::array<ResampleAxis, 3> axes = {ResampleAxis(voxPerVol[0], volOut.voxPerVol[0]),
+                                            ResampleAxis(voxPerVol[1], volOut.voxPerVol[1]),
+                                            ResampleAxis(voxPerVol[2], volOut.voxPerVol[2])};
+        auto datIn = reinterpret_cast<const T *>(GetData());
+        auto datOut = reinterpret_cast<T *>(volOut.dat.get());
+
+        // 各轴权重可分离：(z, y) 权重之积按行提前算好，x 权重查表，
+        // 8 个采样点的累加顺序与逐体素计算时一致，保证结果逐位相同
+        auto linear = [&](uint32_t z) {
+            std::array<const T *, 2> slices = {
+                datIn + axes[2].clampedRngs[z][0] * voxPerVolYxX,
+                datIn + axes[2].clampedRngs[z][1] * voxPerVolYxX};
+            auto &omegaZ = axes[2].omegas[z];
+            auto out = datOut + z * volOut.voxPerVolYxX;
+
+            for (uint32_t y = 0; y < volOut.voxPerVol[1]; ++y) {
+                std::array<std::array<const T *, 2>, 2> rows;
+                std::array<std::array<float, 2>, 2> omegaZYs;
+                for (uint8_t zi = 0; zi < 2; ++zi)
+                    for (uint8_t yi = 0; yi < 2; ++yi) {
+                        rows[zi][yi] = slices[zi] + axes[1].clampedRngs[y][yi] * voxPerVol[0];
+                        omegaZYs[zi][yi] = omegaZ[zi] * axes[1].omegas[y][yi];
+                    }
+
+                for (uint32_t x = 0; x < volOut.voxPerVol[0]; ++x) {
+                    auto &rngX = axes[0].clampedRngs[x];
+                    auto &omegaX = axes[0].omegas[x];
+
+                    auto valIn = 0.f;
+                    for (uint8_t zi = 0; zi < 2; ++zi)
+                        for (uint8_t yi = 0; yi < 2; ++yi)
+                            for (uint8_t xi = 0; xi < 2; ++xi)
+                                valIn += omegaZYs[zi][yi] * omegaX[xi] * rows[zi][yi][rngX[xi]];
+
+                    *out = VoxelTypeTraits<T>::FromFloat(valIn);
+                    ++out;
                 }
+            }
+        };
+
+        auto kriging = [&](uint32_t z) {
+            auto variogram = [](double h, double sill = 1.0, double nugget = 0.0,
+                                double rangeParam = 1.0) {
+                return nugget + sill * (1 - std::exp(-h / rangeParam));
+            };
+            auto out = datOut + z * volOut.voxPerVolYxX;
+
+            for (uint32_t y = 0; y < volOut.voxPerVol[1]; ++y)
+                for (uint32_t x = 0; x < volOut.voxPerVol[0]; ++x) {
+                    std::array<float, 3> posIn = {axes[0].posIns[x], axes[1].posIns[y],
+                                                  axes[2].posIns[z]};
+                    std::array<const std::array<uint32_t, 2> *, 3> posInRng = {
+                        &axes[0].rngs[x], &axes[1].rngs[y], &axes[2].rngs[z]};
+
+                    // 以相邻 8 个体素到目标点的变异函数值归一化作为权重
+                    std::array<double, 8> weights;
+                    double sumVariogramValues = 0.0;
+                    int index = 0;
+                    for (int zi = 0; zi < 2; ++zi)
+                        for (int yi = 0; yi < 2; ++yi)
+                            for (int xi = 0; xi < 2; ++xi) {
+                                std::array<float, 3> pnt = {static_cast<float>((*posInRng[0])[xi]),
+                                                            static_cast<float>((*posInRng[1])[yi]),
+                                                            static_cast<float>((*posInRng[2])[zi])};
+                                double sum = 0.0;
+                                for (int i = 0; i < 3; ++i)
+                                    sum += (pnt[i] - posIn[i]) * (pnt[i] - posIn[i]);
+                                weights[index] = variogram(std::sqrt(sum));
+                                sumVariogramValues += weights[index];
+                                ++index;
+                            }
 
-        return scalar;
+                    auto valIn = 0.f;
+                    index = 0;
+                    for (uint8_t zi = 0; zi < 2; ++zi)
+                        for (uint8_t yi = 0; yi < 2; ++yi)
+                            for (uint8_t xi = 0; xi < 2; ++xi) {
+                                valIn += weights[index] / sumVariogramValues *
+                                         Sample<T>((*posInRng[0])[xi], (*posInRng[1])[yi],
+                                                   (*posInRng[2])[zi]);
+                                ++index;
+                            }
+
+                    *out = VoxelTypeTraits<T>::FromFloat(valIn);
+                    ++out;
+                }
+        };
+
+        switch (filterType) {
+        case EFilterType::Linear:
+            ThreadPool::Global().ParallelFor(0, volOut.voxPerVol[2], linear);
+            break;
+        case EFilterType::Kriging:
+            ThreadPool::Global().ParallelFor(0, volOut.voxPerVol[2], kriging);
+            break;
+        default:
+            assert(false); // 未知的插值类型
+        }
+    }
+
+    /*
+     * 函数: forEachLine
+     * 功能: 对沿 axis 方向的每条扫描线，将其拷贝为连续数组后调用 lineFn(lineIn, lineOut, n)，
+     *       再写回 dst；src 与 dst 可以相同。沿 X、Y 方向按 Z 切片并行，沿 Z 方向按 Y 行并行
+     */
+    template <typename SrcTy, typename DstTy, typename LineFuncTy>
+    void forEachLine(const SrcTy *src, DstTy *dst, uint8_t axis, LineFuncTy lineFn) const {
+        auto n = voxPerVol[axis];
+        size_t stride = axis == 0 ? 1 : axis == 1 ? voxPerVol[0] : voxPerVolYxX;
+
+        auto slab = [&](uint32_t slabIdx) {
+            std::vector<SrcTy> lineIn(n);
+            std::vector<DstTy> lineOut(n);
+            auto filter = [&](size_t offs) {
+                for (uint32_t i = 0; i < n; ++i)
+                    lineIn[i] = src[offs + i * stride];
+                lineFn(lineIn.data(), lineOut.data(), n);
+                for (uint32_t i = 0; i < n; ++i)
+                    dst[offs + i * stride] = lineOut[i];
+            };
+
+            if (axis == 2)
+                for (uint32_t x = 0; x < voxPerVol[0]; ++x)
+                    filter(slabIdx * voxPerVol[0] + x);
+            else
+                for (uint32_t l = 0; l < voxPerVol[axis == 0 ? 1 : 0]; ++l)
+                    filter(slabIdx * voxPerVolYxX + (axis == 0 ? l * voxPerVol[0] : l));
+        };
+
+        ThreadPool::Global().ParallelFor(0, voxPerVol[axis == 2 ? 1 : 2], slab);
+    }
+
+    /*
+     * 函数: boxLine
+     * 功能: 滑动窗口求和，计算半径 radius 内（越界部分不计）的平均值，每个体素 O(1)
+     */
+    template <typename T>
+    static void boxLine(const T *in, float *out, uint32_t n, uint32_t radius) {
+        double sum = 0.0;
+        uint32_t num = 0;
+        for (uint32_t i = 0; i < std::min(n, radius + 1); ++i, ++num)
+            sum += in[i];
+
+        for (uint32_t i = 0; i < n; ++i) {
+            out[i] = static_cast<float>(sum / num);
+            if (i + radius + 1 < n) {
+                sum += in[i + radius + 1];
+                ++num;
+            }
+            if (i >= radius) {
+                sum -= in[i - radius];
+                --num;
+            }
+        }
     }
+
+    /*
+     * 函数: maxLine
+     * 功能: van Herk/Gil-Werman 算法计算半径 radius 内的最大值，每个体素 O(1)。
+     *       两端各填充 radius 个最小值，使每个窗口恰好跨越至多两个长度为 2*radius+1 的块，
+     *       窗口最大值即左块后缀最大值与右块前缀最大值中的较大者
+     */
     template <typename T>
-    T smoothKernelAvg(const T *dat, const std::array<int32_t, 3> &pos,
-                      ESmoothDimension smoothDim) const {
-        float scalar = 0.f;
-        uint32_t num = 0.f;
-        std::array<int32_t, 3> dPos = {pos[0] == 0 ? 0 : -1, pos[1] == 0 ? 0 : -1,
-                                       smoothDim != ESmoothDimension::XY || pos[2] == 0 ? 0 : -1};
-        for (; dPos[2] < (smoothDim != ESmoothDimension::XY || pos[2] == voxPerVol[2] - 1 ? 1 : 2);
-             ++dPos[2])
-            for (; dPos[1] < (pos[1] == voxPerVol[1] - 1 ? 1 : 2); ++dPos[1])
-                for (; dPos[0] < (pos[0] == voxPerVol[0] - 1 ? 1 : 2); ++dPos[0]) {
-                    std::array<int32_t, 3> newPos = {pos[0] + dPos[0], pos[1] + dPos[1],
-                                                     pos[2] + dPos[2]};
-                    scalar += dat[newPos[2] * voxPerVolYxX + newPos[1] * voxPerVol[0] + newPos[0]];
-                    ++num;
-                }
-        return static_cast<T>(std::roundf(1.f * scalar / num));
+    static void maxLine(const T *in, T *out, uint32_t n, uint32_t radius, std::vector<T> &prefixes,
+                        std::vector<T> &suffixes) {
+        auto w = 2 * radius + 1;
+        auto m = n + 2 * radius;
+        prefixes.resize(m);
+        suffixes.resize(m);
+        auto padded = [&](uint32_t j) {
+            return j < radius || j >= radius + n ? std::numeric_limits<T>::lowest()
+                                                 : in[j - radius];
+        };
+
+        for (uint32_t j = 0; j < m; ++j)
+            prefixes[j] = j % w == 0 ? padded(j) : std::max(prefixes[j - 1], padded(j));
+        for (uint32_t j = m; j > 0; --j)
+            suffixes[j - 1] = j == m || j % w == 0 ? padded(j - 1)
+                                                   : std::max(suffixes[j], padded(j - 1));
+
+        for (uint32_t i = 0; i < n; ++i)
+            out[i] = std::max(suffixes[i], prefixes[i + w - 1]);
     }
+
     template <typename T> RAWVolumeData getSmoothed(const SmoothParameters &param) const {
         qDebug() << "Start getSmoothed";
         RAWVolumeData ret = *this;
-
-        auto oldDat = reinterpret_cast<const T *>(dat.data());
-        auto newDat = reinterpret_cast<T *>(ret.dat.data());
-
-        size_t idx = 0;
-        std::array<int32_t, 3> pos;
-        for (pos[2] = 0; pos[2] < voxPerVol[2]; ++pos[2])
-            for (pos[1] = 0; pos[1] < voxPerVol[1]; ++pos[1])
-                for (pos[0] = 0; pos[0] < voxPerVol[0]; ++pos[0]) {
-                    newDat[idx] = param.smoothType == ESmoothType::Avg
-                                      ? smoothKernelAvg(oldDat, pos, param.smoothDim)
-                                      : smoothKernelMax(oldDat, pos, param.smoothDim);
-                    ++idx;
-                }
+        auto oldDat = reinterpret_cast<const T *>(GetData());
+        auto newDat = reinterpret_cast<T *>(ret.allocate(GetDataSize()));
+
+        // 各轴依次做一维滤波，盒式均值与最大值均可分离
+        auto radius = std::max(param.radius, 1u);
+        uint8_t axisNum = param.smoothDim == ESmoothDimension::XY ? 2 : 3;
+        if (param.smoothType == ESmoothType::Avg) {
+            // 中间结果以 float 保存，最后一次取整（整数类型），避免逐轴取整带来的误差累积
+            std::vector<float> tmp(voxPerVolYxX * voxPerVol[2]);
+            forEachLine(oldDat, tmp.data(), 0, [&](const T *in, float *out, uint32_t n) {
+                boxLine(in, out, n, radius);
+            });
+            for (uint8_t axis = 1; axis < axisNum; ++axis)
+                forEachLine(tmp.data(), tmp.data(), axis,
+                            [&](const float *in, float *out, uint32_t n) {
+                                boxLine(in, out, n, radius);
+                            });
+            ThreadPool::Global().ParallelFor(0, voxPerVol[2], [&](uint32_t z) {
+                for (size_t i = z * voxPerVolYxX; i < (z + 1) * voxPerVolYxX; ++i)
+                    newDat[i] = VoxelTypeTraits<T>::FromFloat(tmp[i]);
+            });
+        } else {
+            auto filter = [&](const T *in, T *out, uint32_t n) {
+                thread_local std::vector<T> prefixes, suffixes;
+                maxLine(in, out, n, radius, prefixes, suffixes);
+            };
+            forEachLine(oldDat, newDat, 0, filter);
+            for (uint8_t axis = 1; axis < axisNum; ++axis)
+                forEachLine(newDat, newDat, axis, filter);
+        }
 
         qDebug() << "End getSmoothed";
         return ret;
@@ -0,0 +1,180 @@
+#ifndef VIS4EARTH_DATA_VOL_GRADIENT_H
+#define VIS4EARTH_DATA_VOL_GRADIENT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <array>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: GradientVolume
+ * 功能: 按体素以中心差分（边界处取边界体素）预先计算的梯度，打包为 RGB10_A2：
+ *       RGB 为梯度除以各分量绝对值的最大值后映射到 [0, 1]，A 不使用。
+ *       梯度按线性编码，三线性插值的结果与着色器中按一个体素的偏移采样体纹理求差一致，
+ *       仅相差量化误差。光线投射着色时以一次纹理读取代替六次体数据读取
+ */
+class GradientVolume {
+  public:
+    static ReteurnOrError<GradientVolume> Compute(const RAWVolumeData &vol) {
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+
+        GradientVolume grad;
+        grad.voxPerVol = vol.GetVoxelPerVolume();
+        switch (vol.GetVoxelType()) {
+        case ESupportedVoxelType::UInt8:
+            grad.compute(reinterpret_cast<const uint8_t *>(vol.GetData()),
+                         1.f / VoxelTypeTraits<uint8_t>::Max());
+            break;
+        case ESupportedVoxelType::UInt16:
+            grad.compute(reinterpret_cast<const uint16_t *>(vol.GetData()),
+                         1.f / VoxelTypeTraits<uint16_t>::Max());
+            break;
+        case ESupportedVoxelType::Float32:
+            grad.compute(reinterpret_cast<const float *>(vol.GetData()),
+                         1.f / VoxelTypeTraits<float>::Max());
+            break;
+        default:
+            assert(false);
+        }
+
+        return grad;
+    }
+    /*
+     * 函数: ComputeFromNormalizedFloat
+     * 功能: 由已归一化到 [0, 1] 的体素数组计算梯度
+     */
+    static ReteurnOrError<GradientVolume>
+    ComputeFromNormalizedFloat(const std::vector<float> &dat,
+                               const std::array<uint32_t, 3> &voxPerVol) {
+        if (dat.empty() ||
+            dat.size() != static_cast<size_t>(voxPerVol[0]) * voxPerVol[1] * voxPerVol[2])
+            return "Invalid dat, which does not match voxPerVol.";
+
+        GradientVolume grad;
+        grad.voxPerVol = voxPerVol;
+        grad.compute(dat.data(), 1.f);
+        return grad;
+    }
+
+    const std::array<uint32_t, 3> &GetVoxelPerVolume() const { return voxPerVol; }
+    // 按 x、y、z 线性排列，每个体素一个 GL_UNSIGNED_INT_2_10_10_10_REV 格式的 uint32_t
+    const std::vector<uint32_t> &GetData() const { return packed; }
+    size_t GetByteSize() const { return packed.size() * sizeof(uint32_t); }
+    // 编码前梯度各分量绝对值的最大值（归一化体素值每体素），解码时乘回
+    float GetMaxComponent() const { return maxCmpt; }
+
+    osg::ref_ptr<osg::Texture3D> ToOSGTexture() const {
+        osg::ref_ptr<osg::Image> img = new osg::Image;
+        img->allocateImage(voxPerVol[0], voxPerVol[1], voxPerVol[2], GL_RGBA,
+                           GL_UNSIGNED_INT_2_10_10_10_REV);
+        img->setInternalTextureFormat(GL_RGB10_A2);
+        std::memcpy(img->data(), packed.data(), GetByteSize());
+
+        osg::ref_ptr<osg::Texture3D> tex = new osg::Texture3D;
+        tex->setResizeNonPowerOfTwoHint(false);
+        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        tex->setImage(img);
+
+        return tex;
+    }
+
+    /*
+     * 函数: Decode
+     * 功能: 解码一个体素的梯度（归一化体素值每体素）
+     */
+    std::array<float, 3> Decode(uint32_t texel) const {
+        std::array<float, 3> g;
+        for (int i = 0; i < 3; ++i)
+            g[i] = (((texel >> (10 * i)) & 1023u) / 511.5f - 1.f) * maxCmpt;
+        return g;
+    }
+
+  private:
+    std::array<uint32_t, 3> voxPerVol = {0, 0, 0};
+    float maxCmpt = 0.f;
+    std::vector<uint32_t> packed;
+
+    /*
+     * 函数: forEachGradient
+     * 功能: 以中心差分（边界处为单侧差分）逐体素求第 z 层切片的梯度，
+     *       对每个体素调用 f(体素下标, 乘以 halfScale 后的梯度)
+     */
+    template <typename T, typename F>
+    void forEachGradient(const T *dat, float halfScale, uint32_t z, F &&f) const {
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        auto z0 = z == 0 ? 0 : z - 1;
+        auto z1 = std::min(z + 1, voxPerVol[2] - 1);
+        for (uint32_t y = 0; y < voxPerVol[1]; ++y) {
+            auto y0 = y == 0 ? 0 : y - 1;
+            auto y1 = std::min(y + 1, voxPerVol[1] - 1);
+            auto rowOffs = z * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0];
+            auto row = dat + rowOffs;
+            auto rowY0 = dat + z * voxPerVolYxX + static_cast<size_t>(y0) * voxPerVol[0];
+            auto rowY1 = dat + z * voxPerVolYxX + static_cast<size_t>(y1) * voxPerVol[0];
+            auto rowZ0 = dat + z0 * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0];
+            auto rowZ1 = dat + z1 * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0];
+
+            for (uint32_t x = 0; x < voxPerVol[0]; ++x) {
+                auto x0 = x == 0 ? 0 : x - 1;
+                auto x1 = std::min(x + 1, voxPerVol[0] - 1);
+                f(rowOffs + x,
+                  {halfScale * (static_cast<float>(row[x1]) - static_cast<float>(row[x0])),
+                   halfScale * (static_cast<float>(rowY1[x]) - static_cast<float>(rowY0[x])),
+                   halfScale * (static_cast<float>(rowZ1[x]) - static_cast<float>(rowZ0[x]))});
+            }
+        }
+    }
+
+    /*
+     * 函数: compute
+     * 功能: 按 z 方向的切片并行，先求梯度分量绝对值的最大值，再以其缩放编码，
+     *       使平缓的体数据也能用满 10 位精度
+     */
+    template <typename T> void compute(const T *dat, float scale) {
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        packed.resize(voxPerVolYxX * voxPerVol[2]);
+        // 中心差分的分母 2 并入缩放
+        auto halfScale = .5f * scale;
+
+        std::vector<float> sliceMaxCmpts(voxPerVol[2], 0.f);
+        ThreadPool::Global().ParallelFor(0, voxPerVol[2], [&](uint32_t z) {
+            auto &sliceMax = sliceMaxCmpts[z];
+            forEachGradient(dat, halfScale, z, [&](size_t, const std::array<float, 3> &g) {
+                sliceMax = std::max(sliceMax, std::max(std::abs(g[0]),
+                                                       std::max(std::abs(g[1]), std::abs(g[2]))));
+            });
+        });
+        maxCmpt = *std::max_element(sliceMaxCmpts.begin(), sliceMaxCmpts.end());
+
+        // 梯度处处为 0 时各分量均编码为中值，解码为 0
+        auto encScale = maxCmpt == 0.f ? 0.f : 511.5f / maxCmpt;
+        ThreadPool::Global().ParallelFor(0, voxPerVol[2], [&](uint32_t z) {
+            forEachGradient(dat, halfScale, z, [&](size_t idx, const std::array<float, 3> &g) {
+                uint32_t texel = 3u << 30;
+                for (int i = 0; i < 3; ++i)
+                    texel |= static_cast<uint32_t>(std::round(g[i] * encScale + 511.5f))
+                             << (10 * i);
+                packed[idx] = texel;
+            });
+        });
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_GRADIENT_H
@@ -0,0 +1,438 @@
+#ifndef VIS4EARTH_DATA_VOL_GRIDDING_H
+#define VIS4EARTH_DATA_VOL_GRIDDING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: PointKDTree
+ * 功能: 三维散点的静态 k-d 树。采用隐式布局：点按树序重排后连续存放，
+ *       区间 [lo, hi) 的中点即子树根，不存储子节点指针，只为每个节点记录划分轴
+ */
+class PointKDTree {
+  public:
+    struct Neighbor {
+        float sqrDist;
+        uint32_t id; // 树序下标，见 GetPosition、GetSourceIndex
+    };
+
+    /*
+     * 函数: Build
+     * 功能: 由 poss 构建 k-d 树。各节点沿包围盒最长的轴取中位数划分；
+     *       上层串行划分出数倍于线程数的子树后，各子树并行构建
+     */
+    static PointKDTree Build(const std::vector<std::array<float, 3>> &poss) {
+        PointKDTree tree;
+        tree.pnts.resize(poss.size());
+        tree.axes.assign(poss.size(), 0);
+        for (uint32_t i = 0; i < poss.size(); ++i)
+            tree.pnts[i] = Point{poss[i], i};
+
+        std::vector<std::array<uint32_t, 2>> subtrees;
+        tree.split(0, static_cast<uint32_t>(poss.size()),
+                   4 * ThreadPool::Global().GetThreadNumber(), subtrees);
+        ThreadPool::Global().ParallelFor(0, static_cast<uint32_t>(subtrees.size()),
+                                         [&](uint32_t i) {
+                                             tree.split(subtrees[i][0], subtrees[i][1], 0,
+                                                        subtrees);
+                                         });
+
+        return tree;
+    }
+
+    uint32_t GetPointNumber() const { return static_cast<uint32_t>(pnts.size()); }
+    const std::array<float, 3> &GetPosition(uint32_t id) const { return pnts[id].pos; }
+    uint32_t GetSourceIndex(uint32_t id) const { return pnts[id].srcIdx; }
+
+    /*
+     * 函数: KNearest
+     * 功能: 查找距 pos 最近的 k 个点，按距离升序写入 nbrs（点数不足时少于 k 个）
+     */
+    void KNearest(const std::array<float, 3> &pos, uint32_t k,
+                  std::vector<Neighbor> &nbrs) const {
+        nbrs.clear();
+        if (k == 0)
+            return;
+        nbrs.reserve(k);
+        search(0, static_cast<uint32_t>(pnts.size()), pos, k, nbrs);
+    }
+
+  private:
+    struct Point {
+        std::array<float, 3> pos;
+        uint32_t srcIdx;
+    };
+
+    std::vector<Point> pnts;
+    std::vector<uint8_t> axes;
+
+    /*
+     * 函数: split
+     * 功能: 递归划分 [lo, hi)。leafNum 非零时至多划分出 leafNum 个子树，
+     *       并将其区间追加到 leaves 留待构建；为零时构建整棵子树
+     */
+    void split(uint32_t lo, uint32_t hi, uint32_t leafNum,
+               std::vector<std::array<uint32_t, 2>> &leaves) {
+        if (hi - lo <= 1)
+            return;
+        if (leafNum == 1) {
+            leaves.push_back({lo, hi});
+            return;
+        }
+
+        auto minPos = pnts[lo].pos;
+        auto maxPos = pnts[lo].pos;
+        for (auto i = lo + 1; i < hi; ++i)
+            for (int a = 0; a < 3; ++a) {
+                minPos[a] = std::min(minPos[a], pnts[i].pos[a]);
+                maxPos[a] = std::max(maxPos[a], pnts[i].pos[a]);
+            }
+        uint8_t axis = 0;
+        for (uint8_t a = 1; a < 3; ++a)
+            if (maxPos[a] - minPos[a] > maxPos[axis] - minPos[axis])
+                axis = a;
+
+        auto mid = lo + (hi - lo) / 2;
+        std::nth_element(pnts.begin() + lo, pnts.begin() + mid, pnts.begin() + hi,
+                         [&](const Point &a, const Point &b) { return a.pos[axis] < b.pos[axis]; });
+        axes[mid] = axis;
+
+        split(lo, mid, leafNum / 2, leaves);
+        split(mid + 1, hi, leafNum - leafNum / 2, leaves);
+    }
+
+    void search(uint32_t lo, uint32_t hi, const std::array<float, 3> &pos, uint32_t k,
+                std::vector<Neighbor> &nbrs) const {
+        if (lo >= hi)
+            return;
+
+        auto mid = lo + (hi - lo) / 2;
+        auto &p = pnts[mid].pos;
+        auto sqrDist = 0.f;
+        for (int a = 0; a < 3; ++a)
+            sqrDist += (p[a] - pos[a]) * (p[a] - pos[a]);
+        if (nbrs.size() < k || sqrDist < nbrs.back().sqrDist) {
+            if (nbrs.size() == k)
+                nbrs.pop_back();
+            auto itr =
+                std::upper_bound(nbrs.begin(), nbrs.end(), sqrDist,
+                                 [](float d, const Neighbor &nbr) { return d < nbr.sqrDist; });
+            nbrs.insert(itr, Neighbor{sqrDist, mid});
+        }
+
+        // 先搜索 pos 所在的一侧，另一侧仅在划分面比当前第 k 近邻更近时搜索
+        auto diff = pos[axes[mid]] - p[axes[mid]];
+        auto nearLo = diff < 0.f ? lo : mid + 1;
+        auto nearHi = diff < 0.f ? mid : hi;
+        search(nearLo, nearHi, pos, k, nbrs);
+        if (nbrs.size() < k || diff * diff < nbrs.back().sqrDist)
+            search(diff < 0.f ? mid + 1 : lo, diff < 0.f ? hi : mid, pos, k, nbrs);
+    }
+};
+
+/*
+ * 类: ScatteredGridder
+ * 功能: 将散点 (经度, 纬度, 高度, 值) 插值到规则网格，输出归一化的 Float32 体数据。
+ *       散点先映射到体素坐标系，距离以体素为单位度量；每个体素取 k 个最近邻，
+ *       以反距离加权或普通克里金插值，体素按行并行处理
+ */
+class ScatteredGridder {
+  public:
+    enum class EMethod { InverseDistance = 0, OrdinaryKriging };
+
+    struct Parameters {
+        EMethod method = EMethod::InverseDistance;
+        std::array<uint32_t, 3> voxPerVol = {0, 0, 0};
+        // 网格覆盖的范围，最大值不大于最小值时取散点的范围
+        std::array<float, 2> lonRng = {0.f, 0.f};
+        std::array<float, 2> latRng = {0.f, 0.f};
+        std::array<float, 2> hRng = {0.f, 0.f};
+        uint32_t neighborNum = 12;
+        float power = 2.f; // 反距离加权的幂次
+        // 克里金的指数变异函数 nugget + sill * (1 - exp(-3h / range))，sill、range 不大于 0 时
+        // 分别取归一化值的方差、散点到其第 neighborNum 近邻的平均距离
+        float nugget = 0.f;
+        float sill = 0.f;
+        float range = 0.f;
+    };
+    struct Statistics {
+        uint64_t sampleNum;      // 有效散点数（不含 NaN、inf）
+        double buildSeconds;     // 映射散点并构建 k-d 树的耗时
+        double gridSeconds;      // 插值的耗时
+        double samplesPerSecond; // sampleNum / (buildSeconds + gridSeconds)
+        double voxelsPerSecond;  // 输出体素数 / gridSeconds
+        uint64_t solveNum;       // 克里金方程组的分解次数
+        uint64_t reusedSolveNum; // 邻域与同行先前体素相同、复用分解的次数
+    };
+
+    /*
+     * 函数: Grid
+     * 功能: 插值散点，值按有效散点的范围归一化到 [0, 1]，克里金的过冲被截断
+     * 参数:
+     * -- coords: 各散点的 (经度, 纬度, 高度)
+     * -- vals: 各散点的值，NaN、inf 的散点被忽略
+     * -- stats: 非空时写入统计信息
+     */
+    static ReteurnOrError<RAWVolumeData> Grid(const std::vector<std::array<float, 3>> &coords,
+                                              const std::vector<float> &vals,
+                                              const Parameters &param,
+                                              Statistics *stats = nullptr) {
+        if (coords.size() != vals.size())
+            return "Invalid coords, whose size differs from vals.";
+        if (param.voxPerVol[0] == 0 || param.voxPerVol[1] == 0 || param.voxPerVol[2] == 0)
+            return "Invalid param.voxPerVol.";
+        if (coords.size() >= std::numeric_limits<uint32_t>::max())
+            return "Invalid coords, which has too many samples.";
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::array<float, 2> valRng = {std::numeric_limits<float>::max(),
+                                       std::numeric_limits<float>::lowest()};
+        std::array<std::array<float, 2>, 3> coordRngs = {valRng, valRng, valRng};
+        std::vector<uint32_t> validIndices;
+        validIndices.reserve(vals.size());
+        for (uint32_t i = 0; i < vals.size(); ++i) {
+            if (!std::isfinite(vals[i]))
+                continue;
+            validIndices.emplace_back(i);
+            valRng[0] = std::min(valRng[0], vals[i]);
+            valRng[1] = std::max(valRng[1], vals[i]);
+            for (int a = 0; a < 3; ++a) {
+                coordRngs[a][0] = std::min(coordRngs[a][0], coords[i][a]);
+                coordRngs[a][1] = std::max(coordRngs[a][1], coords[i][a]);
+            }
+        }
+        if (validIndices.empty())
+            return "Invalid vals, which has no finite value.";
+
+        std::array<const std::array<float, 2> *, 3> paramRngs = {&param.lonRng, &param.latRng,
+                                                                 &param.hRng};
+        std::array<float, 3> scales;
+        for (int a = 0; a < 3; ++a) {
+            if ((*paramRngs[a])[1] > (*paramRngs[a])[0])
+                coordRngs[a] = *paramRngs[a];
+            auto rngWid = coordRngs[a][1] - coordRngs[a][0];
+            scales[a] = rngWid > 0.f ? (param.voxPerVol[a] - 1) / rngWid : 0.f;
+        }
+
+        Gridder gridder(param);
+        {
+            std::vector<std::array<float, 3>> poss(validIndices.size());
+            for (size_t i = 0; i < validIndices.size(); ++i)
+                for (int a = 0; a < 3; ++a)
+                    poss[i][a] = (coords[validIndices[i]][a] - coordRngs[a][0]) * scales[a];
+            gridder.tree = PointKDTree::Build(poss);
+        }
+        // 按树序存放归一化的值，省去查询结果到源下标的间接访问
+        auto valRngWid = valRng[1] - valRng[0];
+        gridder.vals.resize(validIndices.size());
+        for (uint32_t i = 0; i < gridder.vals.size(); ++i) {
+            auto val = vals[validIndices[gridder.tree.GetSourceIndex(i)]];
+            gridder.vals[i] = valRngWid > 0.f ? (val - valRng[0]) / valRngWid : 0.f;
+        }
+        std::vector<uint32_t>().swap(validIndices);
+        if (param.method == EMethod::OrdinaryKriging)
+            gridder.fitVariogram();
+        auto buildSeconds = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        std::vector<float> dat(static_cast<size_t>(param.voxPerVol[0]) * param.voxPerVol[1] *
+                               param.voxPerVol[2]);
+        auto rowNum = param.voxPerVol[1] * param.voxPerVol[2];
+        ThreadPool::Global().ParallelFor(0, rowNum, [&](uint32_t row) {
+            gridder.gridRow(row, dat.data() + static_cast<size_t>(row) * param.voxPerVol[0]);
+        });
+        auto gridSeconds = secondsSince(start);
+
+        if (stats) {
+            stats->sampleNum = gridder.vals.size();
+            stats->buildSeconds = buildSeconds;
+            stats->gridSeconds = gridSeconds;
+            stats->samplesPerSecond = stats->sampleNum / (buildSeconds + gridSeconds);
+            stats->voxelsPerSecond = dat.size() / gridSeconds;
+            stats->solveNum = gridder.solveNum;
+            stats->reusedSolveNum = gridder.reusedSolveNum;
+        }
+
+        return RAWVolumeData::CreateFromVoxels(param.voxPerVol, std::move(dat));
+    }
+
+  private:
+    /*
+     * 结构体: KrigingSystem
+     * 功能: 普通克里金方程组 [Γ 1; 1^T 0] 的 LU 分解。系数矩阵只取决于邻域，
+     *       相邻体素的邻域多半相同，只需为新的右端项回代
+     */
+    struct KrigingSystem {
+        std::vector<uint32_t> ids; // 升序的邻域树序下标
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu;
+    };
+
+    struct Gridder {
+        Parameters param;
+        PointKDTree tree;
+        std::vector<float> vals;
+        uint32_t k;
+        std::atomic<uint64_t> solveNum;
+        std::atomic<uint64_t> reusedSolveNum;
+
+        Gridder(const Parameters &param)
+            : param(param), k(std::max(1u, param.neighborNum)), solveNum(0), reusedSolveNum(0) {}
+
+        double variogram(double h) const {
+            if (h <= 0.)
+                return 0.;
+            return param.nugget + param.sill * (1. - std::exp(-3. * h / param.range));
+        }
+        double variogram(const std::array<float, 3> &a, const std::array<float, 3> &b) const {
+            double sqrDist = 0.;
+            for (int i = 0; i < 3; ++i)
+                sqrDist += (static_cast<double>(a[i]) - b[i]) * (static_cast<double>(a[i]) - b[i]);
+            return variogram(std::sqrt(sqrDist));
+        }
+
+        /*
+         * 函数: fitVariogram
+         * 功能: 补全未给定的 sill 与 range。range 由至多 1024 个均匀抽取的散点估计
+         */
+        void fitVariogram() {
+            if (param.sill <= 0.f) {
+                double sum = 0., sqrSum = 0.;
+                for (auto val : vals) {
+                    sum += val;
+                    sqrSum += val * val;
+                }
+                auto mean = sum / vals.size();
+                param.sill =
+                    std::max(1e-6f, static_cast<float>(sqrSum / vals.size() - mean * mean));
+            }
+            if (param.range <= 0.f) {
+                auto pntNum = tree.GetPointNumber();
+                auto probeNum = std::min(pntNum, 1024u);
+                std::vector<PointKDTree::Neighbor> nbrs;
+                double sum = 0.;
+                for (uint32_t i = 0; i < probeNum; ++i) {
+                    // 最近邻含散点自身，故多取一个
+                    tree.KNearest(tree.GetPosition(static_cast<uint64_t>(i) * pntNum / probeNum),
+                                  k + 1, nbrs);
+                    sum += std::sqrt(nbrs.back().sqrDist);
+                }
+                param.range = std::max(1.f, static_cast<float>(sum / probeNum));
+            }
+        }
+
+        float inverseDistance(const std::vector<PointKDTree::Neighbor> &nbrs) const {
+            double wSum = 0., valSum = 0.;
+            for (auto &nbr : nbrs) {
+                auto w = std::pow(static_cast<double>(nbr.sqrDist), -.5 * param.power);
+                wSum += w;
+                valSum += w * vals[nbr.id];
+            }
+            return static_cast<float>(valSum / wSum);
+        }
+
+        /*
+         * 函数: gridRow
+         * 功能: 插值第 row 行（y + z * 高）的体素。同行最近使用的若干分解被缓存，
+         *       方程组退化（如散点重合）时该体素退回反距离加权
+         */
+        void gridRow(uint32_t row, float *out) {
+            static constexpr size_t CacheSize = 8;
+
+            auto y = row % param.voxPerVol[1];
+            auto z = row / param.voxPerVol[1];
+            std::vector<PointKDTree::Neighbor> nbrs;
+            std::vector<uint32_t> ids;
+            std::vector<KrigingSystem> cache;
+            size_t cacheNext = 0;
+            Eigen::VectorXd rhs;
+            uint64_t rowSolveNum = 0, rowReusedSolveNum = 0;
+
+            for (uint32_t x = 0; x < param.voxPerVol[0]; ++x, ++out) {
+                std::array<float, 3> pos = {static_cast<float>(x), static_cast<float>(y),
+                                            static_cast<float>(z)};
+                tree.KNearest(pos, k, nbrs);
+                if (nbrs.front().sqrDist == 0.f) {
+                    *out = vals[nbrs.front().id];
+                    continue;
+                }
+                if (param.method == EMethod::InverseDistance || nbrs.size() == 1) {
+                    *out = inverseDistance(nbrs);
+                    continue;
+                }
+
+                ids.resize(nbrs.size());
+                for (size_t i = 0; i < nbrs.size(); ++i)
+                    ids[i] = nbrs[i].id;
+                std::sort(ids.begin(), ids.end());
+
+                auto n = static_cast<Eigen::Index>(ids.size());
+                auto itr = std::find_if(cache.begin(), cache.end(),
+                                        [&](const KrigingSystem &sys) { return sys.ids == ids; });
+                if (itr != cache.end())
+                    ++rowReusedSolveNum;
+                else {
+                    Eigen::MatrixXd A(n + 1, n + 1);
+                    for (Eigen::Index i = 0; i < n; ++i) {
+                        for (Eigen::Index j = 0; j < i; ++j)
+                            A(i, j) = A(j, i) =
+                                variogram(tree.GetPosition(ids[i]), tree.GetPosition(ids[j]));
+                        A(i, i) = 0.;
+                        A(i, n) = A(n, i) = 1.;
+                    }
+                    A(n, n) = 0.;
+
+                    if (cache.size() < CacheSize) {
+                        cache.emplace_back();
+                        itr = cache.end() - 1;
+                    } else {
+                        itr = cache.begin() + cacheNext;
+                        cacheNext = (cacheNext + 1) % CacheSize;
+                    }
+                    itr->ids = ids;
+                    itr->lu.compute(A);
+                    ++rowSolveNum;
+                }
+
+                rhs.resize(n + 1);
+                for (Eigen::Index i = 0; i < n; ++i)
+                    rhs(i) = variogram(tree.GetPosition(ids[i]), pos);
+                rhs(n) = 1.;
+                Eigen::VectorXd w = itr->lu.solve(rhs);
+                if (!w.allFinite()) {
+                    *out = inverseDistance(nbrs);
+                    continue;
+                }
+
+                double val = 0.;
+                for (Eigen::Index i = 0; i < n; ++i)
+                    val += w(i) * vals[ids[i]];
+                *out = std::min(1.f, std::max(0.f, static_cast<float>(val)));
+            }
+
+            solveNum += rowSolveNum;
+            reusedSolveNum += rowReusedSolveNum;
+        }
+    };
+
+    static double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_GRIDDING_H
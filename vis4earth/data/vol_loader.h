@@ -0,0 +1,231 @@
+#ifndef VIS4EARTH_DATA_VOL_LOADER_H
+#define VIS4EARTH_DATA_VOL_LOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <array>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/macro_cell.h>
+#include <vis4earth/data/vol_container.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/data/vol_gradient.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: AsyncVolumeLoader
+ * 功能: 在专用的加载线程中按文件顺序异步加载时变 RAW 体数据并构建纹理图像。
+ *       在途数据（已加载但尚未被调用方 Release 的字节数）受预算限制，超出时加载线程等待；
+ *       可随时取消，析构时取消并等待加载线程退出。
+ *       加载线程不属于全局线程池，等待预算时不占用池中的线程，
+ *       加载中的重采样、宏单元等计算仍经 ParallelFor 分派到全局线程池
+ */
+class AsyncVolumeLoader {
+  public:
+    struct Parameters {
+        std::vector<std::string> filePaths;
+        std::array<uint32_t, 3> voxPerVol;
+        ESupportedVoxelType voxTy;
+        RAWVolumeData::EStorageMode storageMode;
+        RAWVolumeData::ETextureSizeMode texSizeMode;
+        bool keepCPUData;
+        uint32_t macroCellSize; // 非 0 时在加载线程中构建宏单元网格
+        bool computeGradient;   // 为真时在加载线程中预先计算梯度纹理
+        size_t inFlightByteBudget;
+        uint32_t workerNum; // 加载线程数，0 时使用硬件线程数的一半
+        std::shared_ptr<const VolumeContainer> container; // 非空时从容器读取时间步，忽略 filePaths
+    };
+    struct Result {
+        uint32_t fileIdx;
+        std::string errMsg; // 为空表示加载成功
+        RAWVolumeData volCPU;
+        osg::ref_ptr<osg::Texture3D> vol;
+        std::shared_ptr<const MacroCellGrid> macroCells;
+        osg::ref_ptr<osg::Texture3D> gradient;
+        size_t byteSize;    // 需由调用方 Release 的在途字节数
+        double milliseconds;
+    };
+    // 以下回调均在加载线程中调用
+    using ProcessCallback = std::function<void(uint32_t fileIdx, const RAWVolumeData &vol)>;
+    using LoadedCallback = std::function<void(Result result)>;
+
+    /*
+     * 函数: AsyncVolumeLoader
+     * 功能: 立即开始加载
+     * 参数:
+     * -- process: 可选，加载完成、交付结果前对 CPU 体数据的额外处理（如预先光滑）
+     * -- loaded: 每个文件处理完成（或失败）后调用，取消后不再调用
+     */
+    AsyncVolumeLoader(const Parameters &param, ProcessCallback process, LoadedCallback loaded)
+        : state(std::make_shared<State>()) {
+        state->param = param;
+        state->process = std::move(process);
+        state->loaded = std::move(loaded);
+
+        auto &voxPerVol = param.voxPerVol;
+        state->byteSizePerFile =
+            RAWVolumeData::GetVoxelSize(param.voxTy) * voxPerVol[0] * voxPerVol[1] * voxPerVol[2];
+        if (param.texSizeMode == RAWVolumeData::ETextureSizeMode::PowerOfTwo) {
+            size_t potVoxNum = RAWVolumeData::GetVoxelSize(param.voxTy);
+            for (int i = 0; i < 3; ++i) {
+                uint32_t potDim = 1;
+                while (potDim < voxPerVol[i])
+                    potDim *= 2;
+                potVoxNum *= potDim;
+            }
+            state->byteSizePerFile += potVoxNum;
+        }
+
+        auto workerNum = param.workerNum != 0
+                             ? param.workerNum
+                             : std::max(1u, std::thread::hardware_concurrency() / 2);
+        workerNum = std::min(workerNum, GetFileNumber());
+        for (uint32_t i = 0; i < workerNum; ++i) {
+            auto state = this->state;
+            workers.emplace_back([state]() { state->Run(); });
+        }
+    }
+    ~AsyncVolumeLoader() {
+        Cancel();
+        Wait();
+    }
+
+    AsyncVolumeLoader(const AsyncVolumeLoader &) = delete;
+    AsyncVolumeLoader &operator=(const AsyncVolumeLoader &) = delete;
+
+    uint32_t GetFileNumber() const { return state->GetFileNumber(); }
+    bool IsCancelled() const { return state->cancelled.load(); }
+
+    void Cancel() {
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            state->cancelled = true;
+        }
+        state->cv.notify_all();
+    }
+    void Wait() {
+        for (auto &worker : workers)
+            if (worker.joinable())
+                worker.join();
+    }
+    /*
+     * 函数: Release
+     * 功能: 调用方接管（或丢弃）某个结果后归还其在途字节数，使等待中的加载线程继续
+     */
+    void Release(size_t byteSize) {
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            state->inFlightBytes -= std::min(byteSize, state->inFlightBytes);
+        }
+        state->cv.notify_all();
+    }
+
+  private:
+    struct State {
+        Parameters param;
+        ProcessCallback process;
+        LoadedCallback loaded;
+        size_t byteSizePerFile;
+
+        std::atomic<bool> cancelled;
+        std::mutex mtx;
+        std::condition_variable cv;
+        uint32_t nextFileIdx = 0;
+        size_t inFlightBytes = 0;
+
+        State() : cancelled(false) {}
+
+        uint32_t GetFileNumber() const {
+            return param.container ? param.container->GetTimeNumber()
+                                   : static_cast<uint32_t>(param.filePaths.size());
+        }
+
+        void Run() {
+            while (true) {
+                // 先获得预算再领取文件，保证序号最小的未交付文件总能取得预算，不会死锁
+                uint32_t fileIdx;
+                {
+                    std::unique_lock<std::mutex> lk(mtx);
+                    cv.wait(lk, [&]() {
+                        return cancelled || nextFileIdx >= GetFileNumber() ||
+                               inFlightBytes == 0 ||
+                               inFlightBytes + byteSizePerFile <= param.inFlightByteBudget;
+                    });
+                    if (cancelled || nextFileIdx >= GetFileNumber())
+                        return;
+
+                    fileIdx = nextFileIdx++;
+                    inFlightBytes += byteSizePerFile;
+                }
+
+                auto result = load(fileIdx);
+                if (cancelled) {
+                    std::lock_guard<std::mutex> lk(mtx);
+                    inFlightBytes -= std::min(byteSizePerFile, inFlightBytes);
+                    return;
+                }
+                loaded(std::move(result));
+            }
+        }
+
+        Result load(uint32_t fileIdx) {
+            auto start = std::chrono::steady_clock::now();
+            Result result;
+            result.fileIdx = fileIdx;
+            result.byteSize = byteSizePerFile;
+
+            auto volDat = param.container
+                              ? param.container->ReadTimeStep(fileIdx)
+                              : RAWVolumeData::LoadFromFile(RAWVolumeData::FromFileParameters{
+                                    param.voxPerVol, param.voxTy, param.filePaths[fileIdx],
+                                    param.storageMode, MappedFile::EAccessHint::Sequential});
+            if (!volDat.ok)
+                result.errMsg = volDat.result.errMsg;
+            else {
+                result.vol = volDat.result.dat.ToOSGTexture(param.texSizeMode);
+                if (process)
+                    process(fileIdx, volDat.result.dat);
+                if (param.macroCellSize != 0) {
+                    auto macroCells = MacroCellGrid::Build(volDat.result.dat, param.macroCellSize);
+                    if (macroCells.ok)
+                        result.macroCells =
+                            std::make_shared<MacroCellGrid>(std::move(macroCells.result.dat));
+                }
+                if (param.computeGradient) {
+                    auto gradient = GradientVolume::Compute(volDat.result.dat);
+                    if (gradient.ok)
+                        result.gradient = gradient.result.dat.ToOSGTexture();
+                }
+                if (param.keepCPUData) {
+                    result.volCPU = std::move(volDat.result.dat);
+                    // 后续 marching cube 等算法按体素随机访问
+                    if (result.volCPU.IsMemoryMapped())
+                        result.volCPU.AdviseAccess(MappedFile::EAccessHint::Random);
+                }
+            }
+
+            result.milliseconds = std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count();
+            return result;
+        }
+    };
+
+    std::shared_ptr<State> state;
+    std::vector<std::thread> workers;
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_LOADER_H
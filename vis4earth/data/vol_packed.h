@@ -0,0 +1,149 @@
+#ifndef VIS4EARTH_DATA_VOL_PACKED_H
+#define VIS4EARTH_DATA_VOL_PACKED_H
+
+#include <algorithm>
+#include <cstring>
+
+#include <array>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: PackedVolumeData
+ * 功能: 将至多 4 个体素数与体素类型均相同、空间上配准的变量按通道交错打包为一个多通道体，
+ *       光线投射时每个采样点一次纹理读取即可得到全部变量。
+ *       1 个变量存为 R，2 个变量存为 RG，3、4 个变量存为 RGBA（3 个变量时 A 通道补 0），
+ *       通道格式随体素类型为 8 位、16 位无符号归一化或 32 位浮点，如 RGBA8、RG16
+ */
+class PackedVolumeData {
+  public:
+    static uint32_t MaxVariableNumber() { return 4; }
+
+    static ReteurnOrError<PackedVolumeData> Pack(const std::vector<const RAWVolumeData *> &vols) {
+        if (vols.empty() || vols.size() > MaxVariableNumber())
+            return "Invalid variable number.";
+        for (auto vol : vols) {
+            if (!vol || vol->GetDataSize() == 0)
+                return "Empty volume.";
+            if (vol->GetVoxelPerVolume() != vols[0]->GetVoxelPerVolume() ||
+                vol->GetVoxelType() != vols[0]->GetVoxelType())
+                return "Variables differ in voxPerVol or voxel type.";
+        }
+
+        PackedVolumeData packed;
+        packed.varNum = static_cast<uint32_t>(vols.size());
+        packed.chNum = packed.varNum <= 2 ? packed.varNum : 4;
+        packed.voxPerVol = vols[0]->GetVoxelPerVolume();
+        packed.voxTy = vols[0]->GetVoxelType();
+        switch (packed.voxTy) {
+        case ESupportedVoxelType::UInt8:
+            packed.pack<uint8_t>(vols);
+            break;
+        case ESupportedVoxelType::UInt16:
+            packed.pack<uint16_t>(vols);
+            break;
+        case ESupportedVoxelType::Float32:
+            packed.pack<float>(vols);
+            break;
+        default:
+            assert(false);
+        }
+
+        return packed;
+    }
+
+    uint32_t GetVariableNumber() const { return varNum; }
+    uint32_t GetChannelNumber() const { return chNum; }
+    ESupportedVoxelType GetVoxelType() const { return voxTy; }
+    const std::array<uint32_t, 3> &GetVoxelPerVolume() const { return voxPerVol; }
+    // 按 x、y、z 线性排列，每个体素依次存放 GetChannelNumber() 个通道
+    const uint8_t *GetData() const { return dat.data(); }
+    size_t GetDataSize() const { return dat.size(); }
+
+    template <typename VoxTy>
+    VoxTy Sample(uint32_t varID, uint32_t x, uint32_t y, uint32_t z) const {
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        return reinterpret_cast<const VoxTy *>(
+            dat.data())[(z * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0] + x) * chNum +
+                        varID];
+    }
+
+    /*
+     * 函数: ToOSGTexture
+     * 功能: 返回按线性过滤的多通道纹理。上传后释放纹理所持有的 CPU 数据，
+     *       使打包纹理不额外占用内存
+     */
+    osg::ref_ptr<osg::Texture3D> ToOSGTexture() const {
+        // 以通道数为下标
+        static const std::array<GLenum, 5> PixelFormats = {0, GL_RED, GL_RG, 0, GL_RGBA};
+        static const std::array<GLint, 5> UInt8Formats = {0, GL_R8, GL_RG8, 0, GL_RGBA8};
+        static const std::array<GLint, 5> UInt16Formats = {0, GL_R16, GL_RG16, 0, GL_RGBA16};
+        static const std::array<GLint, 5> Float32Formats = {0, GL_R32F, GL_RG32F, 0,
+                                                            GL_RGBA32F_ARB};
+        GLenum pixTy;
+        GLint internalFmt;
+        switch (voxTy) {
+        case ESupportedVoxelType::UInt8:
+            pixTy = VoxelTypeTraits<uint8_t>::PixelType();
+            internalFmt = UInt8Formats[chNum];
+            break;
+        case ESupportedVoxelType::UInt16:
+            pixTy = VoxelTypeTraits<uint16_t>::PixelType();
+            internalFmt = UInt16Formats[chNum];
+            break;
+        default:
+            pixTy = VoxelTypeTraits<float>::PixelType();
+            internalFmt = Float32Formats[chNum];
+        }
+
+        osg::ref_ptr<osg::Image> img = new osg::Image;
+        img->allocateImage(voxPerVol[0], voxPerVol[1], voxPerVol[2], PixelFormats[chNum], pixTy);
+        img->setInternalTextureFormat(internalFmt);
+        std::memcpy(img->data(), dat.data(), dat.size());
+
+        osg::ref_ptr<osg::Texture3D> tex = new osg::Texture3D;
+        tex->setResizeNonPowerOfTwoHint(false);
+        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
+        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        tex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        tex->setUnRefImageDataAfterApply(true);
+        tex->setImage(img);
+
+        return tex;
+    }
+
+  private:
+    uint32_t varNum = 0;
+    uint32_t chNum = 0;
+    ESupportedVoxelType voxTy = ESupportedVoxelType::UInt8;
+    std::array<uint32_t, 3> voxPerVol = {0, 0, 0};
+    std::vector<uint8_t> dat;
+
+    template <typename T> void pack(const std::vector<const RAWVolumeData *> &vols) {
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        dat.assign(voxPerVolYxX * voxPerVol[2] * chNum * sizeof(T), 0);
+
+        auto out = reinterpret_cast<T *>(dat.data());
+        ThreadPool::Global().ParallelFor(0, voxPerVol[2], [&](uint32_t z) {
+            for (uint32_t v = 0; v < varNum; ++v) {
+                auto in = reinterpret_cast<const T *>(vols[v]->GetData()) + z * voxPerVolYxX;
+                auto sliceOut = out + z * voxPerVolYxX * chNum + v;
+                for (size_t i = 0; i < voxPerVolYxX; ++i)
+                    sliceOut[i * chNum] = in[i];
+            }
+        });
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_PACKED_H
@@ -0,0 +1,261 @@
+#ifndef VIS4EARTH_DATA_VOL_PLAYER_H
+#define VIS4EARTH_DATA_VOL_PLAYER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <array>
+#include <set>
+#include <vector>
+
+#include <osg/Texture3D>
+
+#include <vis4earth/data/vol_container.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: TimeVaryingVolumePlayer
+ * 功能: 流式播放时变体数据。CPU 上仅保留从当前时间步起的 cpuStepNum 个时间步，
+ *       其中前 gpuStepNum 个构建纹理；时间步 t 存放于环形缓冲的第 t % N 个槽位，
+ *       窗口外的时间步被覆盖，内存占用与序列长度无关。第 0 个时间步常驻，供查询尺寸等使用
+ */
+class TimeVaryingVolumePlayer {
+  public:
+    struct Parameters {
+        std::vector<std::string> filePaths;
+        std::array<uint32_t, 3> voxPerVol;
+        ESupportedVoxelType voxTy;
+        RAWVolumeData::EStorageMode storageMode;
+        RAWVolumeData::ETextureSizeMode texSizeMode;
+        uint32_t cpuStepNum;
+        uint32_t gpuStepNum; // 不超过 cpuStepNum
+        std::shared_ptr<const VolumeContainer> container; // 非空时从容器读取时间步，忽略 filePaths
+    };
+    struct Statistics {
+        uint64_t presentedNum; // 按时显示的时间步数
+        uint64_t lateNum;      // 到达时未就绪、先沿用上一帧纹理的时间步数
+        uint64_t droppedNum;   // 因播放时钟超前而跳过的时间步数
+        uint64_t loadedNum;    // 从文件加载的时间步数
+    };
+
+    static ReteurnOrError<std::shared_ptr<TimeVaryingVolumePlayer>>
+    Create(const Parameters &param) {
+        if (param.filePaths.empty() && !param.container)
+            return "Empty filePaths.";
+
+        std::shared_ptr<TimeVaryingVolumePlayer> player(new TimeVaryingVolumePlayer);
+        auto &state = *player->state;
+        state.param = param;
+        state.param.cpuStepNum = std::max(1u, param.cpuStepNum);
+        state.param.gpuStepNum =
+            std::min(state.param.cpuStepNum, std::max(1u, param.gpuStepNum));
+        state.cpuSteps.resize(state.param.cpuStepNum);
+        state.gpuSteps.resize(state.param.gpuStepNum);
+
+        auto volDat = state.load(0);
+        if (!volDat.ok)
+            return volDat.result.errMsg.c_str();
+        state.firstVolCPU = std::move(volDat.result.dat);
+        state.firstVol = state.firstVolCPU.ToOSGTexture(param.texSizeMode);
+        player->lastVol = state.firstVol;
+
+        return player;
+    }
+    ~TimeVaryingVolumePlayer() { state->stopped = true; }
+
+    TimeVaryingVolumePlayer(const TimeVaryingVolumePlayer &) = delete;
+    TimeVaryingVolumePlayer &operator=(const TimeVaryingVolumePlayer &) = delete;
+
+    uint32_t GetTimeNumber() const { return state->GetTimeNumber(); }
+    const RAWVolumeData &GetFirstVolumeCPU() const { return state->firstVolCPU; }
+    Statistics GetStatistics() const { return stats; }
+
+    /*
+     * 函数: GetVolume
+     * 功能: 返回已驻留的时间步纹理，未驻留时返回空
+     */
+    osg::ref_ptr<osg::Texture3D> GetVolume(uint32_t timeID) const {
+        if (timeID == 0)
+            return state->firstVol;
+
+        std::lock_guard<std::mutex> lk(state->mtx);
+        auto &step = state->gpuSteps[timeID % state->gpuSteps.size()];
+        return step.timeID == timeID ? step.vol : nullptr;
+    }
+
+    /*
+     * 函数: Present
+     * 功能: 播放时钟到达 timeID 时调用，预取其后的时间步，并返回应显示的纹理。
+     *       timeID 未就绪时返回上一帧的纹理并计为迟到。迟到期间应每帧以同一 timeID 再次调用，
+     *       以继续预取（在途任务已满时首次调用可能未能提交 timeID），就绪后即返回其纹理。
+     *       重复调用不再计入统计
+     */
+    osg::ref_ptr<osg::Texture3D> Present(uint32_t timeID) {
+        auto timeNum = GetTimeNumber();
+        timeID %= timeNum;
+        auto repeated = hasPresented && timeID == lastTimeID;
+        if (hasPresented && !repeated) {
+            auto gap = (timeID + timeNum - lastTimeID) % timeNum;
+            if (gap > 1)
+                stats.droppedNum += gap - 1;
+        }
+        hasPresented = true;
+        lastTimeID = timeID;
+
+        prefetch(timeID);
+
+        auto vol = GetVolume(timeID);
+        if (!repeated) {
+            if (vol.valid())
+                ++stats.presentedNum;
+            else
+                ++stats.lateNum;
+        }
+        if (vol.valid())
+            lastVol = vol;
+        late = !vol.valid();
+        stats.loadedNum = state->loadedNum.load();
+
+        return lastVol;
+    }
+
+    // 上次 Present 的时间步未就绪、返回的是上一帧的纹理时为真
+    bool IsLate() const { return late; }
+
+  private:
+    struct CPUStep {
+        uint32_t timeID = std::numeric_limits<uint32_t>::max();
+        RAWVolumeData volCPU;
+    };
+    struct GPUStep {
+        uint32_t timeID = std::numeric_limits<uint32_t>::max();
+        osg::ref_ptr<osg::Texture3D> vol;
+    };
+    struct State {
+        Parameters param;
+        RAWVolumeData firstVolCPU;
+        osg::ref_ptr<osg::Texture3D> firstVol;
+
+        std::atomic<bool> stopped;
+        std::atomic<uint64_t> loadedNum;
+        std::mutex mtx;
+        uint32_t currTimeID = 0;
+        std::vector<CPUStep> cpuSteps;
+        std::vector<GPUStep> gpuSteps;
+        std::set<uint32_t> fetchingTimeIDs;
+
+        State() : stopped(false), loadedNum(0) {}
+
+        uint32_t GetTimeNumber() const {
+            return param.container ? param.container->GetTimeNumber()
+                                   : static_cast<uint32_t>(param.filePaths.size());
+        }
+        ReteurnOrError<RAWVolumeData> load(uint32_t timeID) {
+            if (param.container)
+                return param.container->ReadTimeStep(timeID);
+            return RAWVolumeData::LoadFromFile(RAWVolumeData::FromFileParameters{
+                param.voxPerVol, param.voxTy, param.filePaths[timeID], param.storageMode,
+                MappedFile::EAccessHint::Sequential});
+        }
+        // 从 currTimeID 起按播放方向（循环）计算的距离
+        uint32_t distance(uint32_t timeID) const {
+            auto timeNum = GetTimeNumber();
+            return (timeID + timeNum - currTimeID) % timeNum;
+        }
+
+        /*
+         * 函数: fetch
+         * 功能: 在工作线程中加载 timeID（已在 CPU 上时跳过）并按需构建纹理，
+         *       完成时若其已滑出窗口则丢弃
+         */
+        void fetch(uint32_t timeID) {
+            RAWVolumeData volCPU;
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                auto &cpuStep = cpuSteps[timeID % cpuSteps.size()];
+                if (cpuStep.timeID == timeID)
+                    volCPU = cpuStep.volCPU;
+            }
+            if (!stopped && volCPU.GetDataSize() == 0) {
+                auto volDat = load(timeID);
+                if (volDat.ok) {
+                    volCPU = std::move(volDat.result.dat);
+                    ++loadedNum;
+                }
+            }
+
+            std::unique_lock<std::mutex> lk(mtx);
+            if (stopped || volCPU.GetDataSize() == 0 || distance(timeID) >= cpuSteps.size()) {
+                fetchingTimeIDs.erase(timeID);
+                return;
+            }
+
+            auto &cpuStep = cpuSteps[timeID % cpuSteps.size()];
+            cpuStep.timeID = timeID;
+            cpuStep.volCPU = volCPU;
+            if (distance(timeID) < gpuSteps.size() &&
+                gpuSteps[timeID % gpuSteps.size()].timeID != timeID) {
+                lk.unlock();
+                auto vol = volCPU.ToOSGTexture(param.texSizeMode);
+                lk.lock();
+                if (distance(timeID) < gpuSteps.size()) {
+                    auto &gpuStep = gpuSteps[timeID % gpuSteps.size()];
+                    gpuStep.timeID = timeID;
+                    gpuStep.vol = vol;
+                }
+            }
+            fetchingTimeIDs.erase(timeID);
+        }
+    };
+
+    std::shared_ptr<State> state;
+    Statistics stats = {0, 0, 0, 0};
+    bool hasPresented = false;
+    bool late = false;
+    uint32_t lastTimeID = 0;
+    osg::ref_ptr<osg::Texture3D> lastVol;
+
+    TimeVaryingVolumePlayer() : state(std::make_shared<State>()) {}
+
+    /*
+     * 函数: prefetch
+     * 功能: 将窗口移到 timeID，为窗口内缺失的 CPU 数据或纹理提交加载任务。
+     *       在途任务数不超过窗口大小，加载跟不上播放时新任务被推迟而非无限堆积
+     */
+    void prefetch(uint32_t timeID) {
+        std::vector<uint32_t> fetchTimeIDs;
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            state->currTimeID = timeID;
+
+            auto timeNum = GetTimeNumber();
+            auto windowSize = std::min(static_cast<uint32_t>(state->cpuSteps.size()), timeNum);
+            for (uint32_t i = 0; i < windowSize; ++i) {
+                auto t = (timeID + i) % timeNum;
+                auto needCPU = state->cpuSteps[t % state->cpuSteps.size()].timeID != t;
+                auto needGPU = i < state->gpuSteps.size() &&
+                               state->gpuSteps[t % state->gpuSteps.size()].timeID != t;
+                if (!needCPU && !needGPU)
+                    continue;
+                if (state->fetchingTimeIDs.size() >= windowSize)
+                    break;
+                if (state->fetchingTimeIDs.insert(t).second)
+                    fetchTimeIDs.emplace_back(t);
+            }
+        }
+
+        for (auto t : fetchTimeIDs) {
+            auto state = this->state;
+            ThreadPool::Global().Submit([state, t]() { state->fetch(t); });
+        }
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_PLAYER_H
@@ -0,0 +1,717 @@
+#ifndef VIS4EARTH_DATA_VOL_PYRAMID_H
+#define VIS4EARTH_DATA_VOL_PYRAMID_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include <array>
+#include <list>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include <QDebug>
+
+#include <osg/Texture3D>
+#include <osg/Vec4>
+
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/io/mapped_file.h>
+#include <vis4earth/math.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: VolumePyramid
+ * 功能: 存放于磁盘的多分辨率砖块金字塔（*.v4p）。第 l 层由原体数据按 2^l 的边长盒式下采样，
+ *       逐层划分为边长 brickSize 的砖块，直到整层只剩一个砖块。每个砖块在六个方向各多存一层
+ *       相邻体素，使不同砖块在纹理中分别存放时三线性插值仍然连续。
+ *       读取时只读映射整个文件，砖块按需访问，体数据与单个纹理的尺寸均不受内存限制
+ * 文件布局（小端）:
+ * -- Header
+ * -- 按页对齐后，各层砖块依次存放，层内按 x、y、z 顺序，每个砖块 (brickSize + 2)^3 个体素
+ */
+class VolumePyramid {
+  public:
+    struct Info {
+        std::array<uint32_t, 3> voxPerVol; // 第 0 层的尺寸
+        ESupportedVoxelType voxTy;
+        uint32_t brickSize; // 砖块边长，不含边框
+        std::array<float, 2> lonRange;    // 单位为度
+        std::array<float, 2> latRange;    // 单位为度
+        std::array<float, 2> heightRange; // 距地表高度，单位为米
+    };
+    struct BrickKey {
+        uint32_t level;
+        std::array<uint32_t, 3> brickPos;
+
+        bool operator<(const BrickKey &other) const {
+            return std::tie(level, brickPos) < std::tie(other.level, other.brickPos);
+        }
+        bool operator==(const BrickKey &other) const {
+            return level == other.level && brickPos == other.brickPos;
+        }
+    };
+
+    static ReteurnOrError<std::shared_ptr<VolumePyramid>>
+    Open(const std::string &filePath,
+         MappedFile::EAccessHint hint = MappedFile::EAccessHint::Random) {
+        std::shared_ptr<VolumePyramid> pyramid(new VolumePyramid);
+        pyramid->mapped = MappedFile::Open(filePath, hint);
+        if (!pyramid->mapped)
+            return "Invalid filePath.";
+
+        auto fileSz = pyramid->mapped->GetSize();
+        Header header;
+        if (fileSz < sizeof(header))
+            return "Invalid file content, which is not a volume pyramid.";
+        std::memcpy(&header, pyramid->mapped->GetData(), sizeof(header));
+        if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0)
+            return "Invalid file content, which is not a volume pyramid.";
+        if (header.version != Version)
+            return "Unsupported volume pyramid version.";
+        if (header.voxTy > static_cast<uint32_t>(ESupportedVoxelType::Float32))
+            return "Unsupported voxel type.";
+        if (header.voxPerVol[0] == 0 || header.voxPerVol[1] == 0 || header.voxPerVol[2] == 0 ||
+            header.brickSize == 0)
+            return "Invalid file content, which has an empty volume.";
+
+        auto &info = pyramid->info;
+        for (int i = 0; i < 3; ++i)
+            info.voxPerVol[i] = header.voxPerVol[i];
+        info.voxTy = static_cast<ESupportedVoxelType>(header.voxTy);
+        info.brickSize = header.brickSize;
+        info.lonRange = {header.lonRange[0], header.lonRange[1]};
+        info.latRange = {header.latRange[0], header.latRange[1]};
+        info.heightRange = {header.heightRange[0], header.heightRange[1]};
+        pyramid->initLevels();
+        if (header.levelNum != pyramid->GetLevelNumber())
+            return "Invalid file content, which has a broken level number.";
+        if (fileSz < pyramid->levelOffsets.back())
+            return "Invalid file content, which is truncated.";
+
+        qDebug() << "Opened" << filePath.c_str() << "with" << pyramid->GetLevelNumber()
+                 << "levels";
+        return pyramid;
+    }
+
+    const Info &GetInfo() const { return info; }
+    uint32_t GetLevelNumber() const { return static_cast<uint32_t>(levelOffsets.size() - 1); }
+    std::array<uint32_t, 3> GetVoxelPerLevel(uint32_t level) const {
+        return getVoxelPerLevel(info.voxPerVol, level);
+    }
+    std::array<uint32_t, 3> GetBrickPerLevel(uint32_t level) const {
+        return getBrickPerLevel(info.voxPerVol, info.brickSize, level);
+    }
+    // 含边框的砖块边长
+    uint32_t GetBrickVoxelPerSide() const { return info.brickSize + 2; }
+    size_t GetBrickByteSize() const { return getBrickByteSize(info.voxTy, info.brickSize); }
+    const uint8_t *GetBrickData(const BrickKey &key) const {
+        auto brickPerLvl = GetBrickPerLevel(key.level);
+        auto brickID = (static_cast<size_t>(key.brickPos[2]) * brickPerLvl[1] + key.brickPos[1]) *
+                           brickPerLvl[0] +
+                       key.brickPos[0];
+        return mapped->GetData() + levelOffsets[key.level] + brickID * GetBrickByteSize();
+    }
+
+    /*
+     * 函数: GetPreviewLevel
+     * 功能: 返回各维尺寸均不超过 maxVoxPerSide 的最精细层，用作整体预览
+     */
+    uint32_t GetPreviewLevel(uint32_t maxVoxPerSide) const {
+        for (uint32_t l = 0; l < GetLevelNumber(); ++l) {
+            auto voxPerLvl = GetVoxelPerLevel(l);
+            if (voxPerLvl[0] <= maxVoxPerSide && voxPerLvl[1] <= maxVoxPerSide &&
+                voxPerLvl[2] <= maxVoxPerSide)
+                return l;
+        }
+        return GetLevelNumber() - 1;
+    }
+
+    /*
+     * 函数: ReadLevel
+     * 功能: 将第 level 层的全部砖块（去掉边框）拼合为体数据
+     */
+    ReteurnOrError<RAWVolumeData> ReadLevel(uint32_t level) const {
+        if (level >= GetLevelNumber())
+            return "Invalid level.";
+
+        auto voxSz = RAWVolumeData::GetVoxelSize(info.voxTy);
+        auto voxPerLvl = GetVoxelPerLevel(level);
+        auto brickPerLvl = GetBrickPerLevel(level);
+        auto bs = info.brickSize;
+        auto bvps = GetBrickVoxelPerSide();
+        std::vector<uint8_t> dat(voxSz * voxPerLvl[0] * voxPerLvl[1] * voxPerLvl[2]);
+        ThreadPool::Global().ParallelFor(0, brickPerLvl[2], [&](uint32_t bz) {
+            for (uint32_t by = 0; by < brickPerLvl[1]; ++by)
+                for (uint32_t bx = 0; bx < brickPerLvl[0]; ++bx) {
+                    auto brickDat = GetBrickData({level, {bx, by, bz}});
+                    auto xNum = std::min(bs, voxPerLvl[0] - bx * bs);
+                    auto yNum = std::min(bs, voxPerLvl[1] - by * bs);
+                    auto zNum = std::min(bs, voxPerLvl[2] - bz * bs);
+                    for (uint32_t z = 0; z < zNum; ++z)
+                        for (uint32_t y = 0; y < yNum; ++y)
+                            std::memcpy(
+                                dat.data() +
+                                    voxSz * ((static_cast<size_t>(bz * bs + z) * voxPerLvl[1] +
+                                              by * bs + y) *
+                                                 voxPerLvl[0] +
+                                             bx * bs),
+                                brickDat + voxSz * ((static_cast<size_t>(z + 1) * bvps + y + 1) *
+                                                        bvps +
+                                                    1),
+                                voxSz * xNum);
+                }
+        });
+
+        return RAWVolumeData::CreateFromData(voxPerLvl, info.voxTy, std::move(dat));
+    }
+
+  private:
+    friend class VolumePyramidWriter;
+
+    static constexpr uint32_t Version = 1;
+    static constexpr uint64_t PageSize = 4096;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t voxTy;
+        uint32_t voxPerVol[3];
+        uint32_t brickSize;
+        uint32_t levelNum;
+        uint32_t reserved;
+        float lonRange[2];
+        float latRange[2];
+        float heightRange[2];
+    };
+    static_assert(sizeof(Header) == 64, "Header layout must not depend on the compiler.");
+
+    Info info;
+    std::shared_ptr<const MappedFile> mapped;
+    std::vector<uint64_t> levelOffsets; // 各层起始偏移，最后一项为文件数据的末尾
+
+    VolumePyramid() {}
+
+    static const char *magic() { return "V4EPYR\0"; } // 连同结尾的 '\0' 共 8 字节
+
+    static std::array<uint32_t, 3> getVoxelPerLevel(const std::array<uint32_t, 3> &voxPerVol,
+                                                    uint32_t level) {
+        std::array<uint32_t, 3> voxPerLvl;
+        for (int i = 0; i < 3; ++i)
+            voxPerLvl[i] = ((voxPerVol[i] - 1) >> level) + 1;
+        return voxPerLvl;
+    }
+    static std::array<uint32_t, 3> getBrickPerLevel(const std::array<uint32_t, 3> &voxPerVol,
+                                                    uint32_t brickSize, uint32_t level) {
+        auto brickPerLvl = getVoxelPerLevel(voxPerVol, level);
+        for (int i = 0; i < 3; ++i)
+            brickPerLvl[i] = (brickPerLvl[i] + brickSize - 1) / brickSize;
+        return brickPerLvl;
+    }
+    static size_t getBrickByteSize(ESupportedVoxelType voxTy, uint32_t brickSize) {
+        size_t bvps = brickSize + 2;
+        return RAWVolumeData::GetVoxelSize(voxTy) * bvps * bvps * bvps;
+    }
+
+    void initLevels() {
+        levelOffsets.assign(1, (sizeof(Header) + PageSize - 1) / PageSize * PageSize);
+        for (uint32_t l = 0;; ++l) {
+            auto brickPerLvl = GetBrickPerLevel(l);
+            levelOffsets.emplace_back(levelOffsets.back() +
+                                      static_cast<uint64_t>(brickPerLvl[0]) * brickPerLvl[1] *
+                                          brickPerLvl[2] * GetBrickByteSize());
+            if (brickPerLvl[0] == 1 && brickPerLvl[1] == 1 && brickPerLvl[2] == 1)
+                break;
+        }
+    }
+};
+
+/*
+ * 类: VolumePyramidWriter
+ * 功能: 由体数据（可为内存映射）离线构建 VolumePyramid。每层均直接由第 0 层盒式下采样，
+ *       按批并行计算砖块后顺序写出，内存中只保留一批砖块
+ */
+class VolumePyramidWriter {
+  public:
+    /*
+     * 函数: Build
+     * 参数:
+     * -- info: 金字塔信息，其中 voxPerVol、voxTy 取自 vol
+     * 返回: 错误信息，成功时为空
+     */
+    static std::string Build(const std::string &filePath, const RAWVolumeData &vol,
+                             VolumePyramid::Info info) {
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+        if (info.brickSize == 0)
+            return "Invalid brickSize.";
+        info.voxPerVol = vol.GetVoxelPerVolume();
+        info.voxTy = vol.GetVoxelType();
+
+        auto start = std::chrono::steady_clock::now();
+        std::ofstream os(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os.is_open())
+            return "Invalid filePath.";
+
+        VolumePyramid pyramid;
+        pyramid.info = info;
+        pyramid.initLevels();
+
+        VolumePyramid::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, VolumePyramid::magic(), sizeof(header.magic));
+        header.version = VolumePyramid::Version;
+        header.voxTy = static_cast<uint32_t>(info.voxTy);
+        for (int i = 0; i < 3; ++i)
+            header.voxPerVol[i] = info.voxPerVol[i];
+        header.brickSize = info.brickSize;
+        header.levelNum = pyramid.GetLevelNumber();
+        for (int i = 0; i < 2; ++i) {
+            header.lonRange[i] = info.lonRange[i];
+            header.latRange[i] = info.latRange[i];
+            header.heightRange[i] = info.heightRange[i];
+        }
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        std::vector<char> padding(pyramid.levelOffsets.front() - sizeof(header), 0);
+        os.write(padding.data(), padding.size());
+
+        auto brickByteSz = pyramid.GetBrickByteSize();
+        auto batchNum = std::max(1u, ThreadPool::Global().GetThreadNumber()) * 4;
+        std::vector<uint8_t> buf(brickByteSz * batchNum);
+        for (uint32_t l = 0; l < pyramid.GetLevelNumber(); ++l) {
+            auto brickPerLvl = pyramid.GetBrickPerLevel(l);
+            auto brickNum = brickPerLvl[0] * brickPerLvl[1] * brickPerLvl[2];
+            for (uint32_t batchBeg = 0; batchBeg < brickNum; batchBeg += batchNum) {
+                auto batchEnd = std::min(brickNum, batchBeg + batchNum);
+                ThreadPool::Global().ParallelFor(batchBeg, batchEnd, [&](uint32_t brickID) {
+                    VolumePyramid::BrickKey key = {
+                        l,
+                        {brickID % brickPerLvl[0], brickID / brickPerLvl[0] % brickPerLvl[1],
+                         brickID / brickPerLvl[0] / brickPerLvl[1]}};
+                    auto dst = buf.data() + (brickID - batchBeg) * brickByteSz;
+                    switch (info.voxTy) {
+                    case ESupportedVoxelType::UInt8:
+                        buildBrick<uint8_t>(vol, info.brickSize, key, dst);
+                        break;
+                    case ESupportedVoxelType::UInt16:
+                        buildBrick<uint16_t>(vol, info.brickSize, key, dst);
+                        break;
+                    case ESupportedVoxelType::Float32:
+                        buildBrick<float>(vol, info.brickSize, key, dst);
+                        break;
+                    default:
+                        assert(false);
+                    }
+                });
+                os.write(reinterpret_cast<const char *>(buf.data()),
+                         brickByteSz * (batchEnd - batchBeg));
+            }
+        }
+        os.close();
+        if (!os)
+            return "Failed to write file.";
+
+        qDebug() << "Built volume pyramid with" << pyramid.GetLevelNumber() << "levels,"
+                 << pyramid.levelOffsets.back() << "bytes in"
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              start)
+                        .count()
+                 << "ms";
+        return "";
+    }
+
+  private:
+    /*
+     * 函数: buildBrick
+     * 功能: 计算砖块 key 含边框的全部体素。第 l 层的体素为第 0 层中对应 2^l 边长区域的平均值，
+     *       边框越出该层时取最近的体素
+     */
+    template <typename T>
+    static void buildBrick(const RAWVolumeData &vol, uint32_t brickSize,
+                           const VolumePyramid::BrickKey &key, uint8_t *dst) {
+        auto voxPerVol = vol.GetVoxelPerVolume();
+        auto voxPerLvl = VolumePyramid::getVoxelPerLevel(voxPerVol, key.level);
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+        auto src = reinterpret_cast<const T *>(vol.GetData());
+        auto out = reinterpret_cast<T *>(dst);
+        auto bvps = brickSize + 2;
+
+        // 各维上边框内每个体素对应的第 0 层区间
+        std::array<std::vector<std::array<uint32_t, 2>>, 3> rngs;
+        for (int i = 0; i < 3; ++i) {
+            rngs[i].resize(bvps);
+            for (uint32_t j = 0; j < bvps; ++j) {
+                auto lvlPos = static_cast<int64_t>(key.brickPos[i]) * brickSize + j - 1;
+                lvlPos = std::min<int64_t>(std::max<int64_t>(lvlPos, 0), voxPerLvl[i] - 1);
+                rngs[i][j][0] = static_cast<uint32_t>(lvlPos << key.level);
+                rngs[i][j][1] =
+                    std::min(static_cast<uint32_t>((lvlPos + 1) << key.level), voxPerVol[i]);
+            }
+        }
+
+        for (uint32_t z = 0; z < bvps; ++z)
+            for (uint32_t y = 0; y < bvps; ++y)
+                for (uint32_t x = 0; x < bvps; ++x) {
+                    double sum = 0.;
+                    for (auto sz = rngs[2][z][0]; sz < rngs[2][z][1]; ++sz)
+                        for (auto sy = rngs[1][y][0]; sy < rngs[1][y][1]; ++sy) {
+                            auto row =
+                                src + sz * voxPerVolYxX + static_cast<size_t>(sy) * voxPerVol[0];
+                            for (auto sx = rngs[0][x][0]; sx < rngs[0][x][1]; ++sx)
+                                sum += row[sx];
+                        }
+                    auto num = static_cast<double>(rngs[0][x][1] - rngs[0][x][0]) *
+                               (rngs[1][y][1] - rngs[1][y][0]) * (rngs[2][z][1] - rngs[2][z][0]);
+                    *out = VoxelTypeTraits<T>::FromFloat(static_cast<float>(sum / num));
+                    ++out;
+                }
+    }
+};
+
+/*
+ * 类: PyramidBrickCache
+ * 功能: 按视点为 VolumePyramid 逐区域选择分辨率层，并将所选砖块调入固定容量的纹理图集。
+ *       页表纹理按第 0 层的砖块划分，每项记录覆盖该区域的已驻留砖块在图集中的位置与所在层，
+ *       着色器据此把体数据空间的坐标换算为图集坐标。图集槽位按最近最少使用（LRU）的顺序复用
+ */
+class PyramidBrickCache {
+  public:
+    static constexpr uint32_t MaxAtlasVoxelPerSide = 2048;
+
+    struct LODParameters {
+        osg::Vec3 eyePos; // 与 DVR 着色器相同的地心坐标
+        std::array<float, 2> lonRange;    // 单位为弧度
+        std::array<float, 2> latRange;    // 单位为弧度
+        std::array<float, 2> radiusRange; // 地心距离
+        float errorThreshold; // 单个体素对视点所张角度（弧度）的上限，超出时细分
+    };
+    struct Statistics {
+        uint64_t hitNum;
+        uint64_t missNum;
+        uint64_t evictNum;
+        uint32_t selectedNum; // 最近一次选择的砖块数
+        uint32_t residentNum;
+        uint32_t slotNum;
+        size_t residentBytes;
+    };
+
+    /*
+     * 函数: PyramidBrickCache
+     * 参数:
+     * -- byteBudget: 图集的字节数上限，决定可同时驻留的砖块数
+     */
+    PyramidBrickCache(std::shared_ptr<const VolumePyramid> pyramid, size_t byteBudget)
+        : pyramid(std::move(pyramid)) {
+        auto bvps = this->pyramid->GetBrickVoxelPerSide();
+        auto targetNum = static_cast<uint32_t>(std::max(
+            size_t(1), std::min(byteBudget / this->pyramid->GetBrickByteSize(), size_t(1) << 20)));
+        auto maxSlotPerSide = std::max(1u, MaxAtlasVoxelPerSide / bvps);
+        auto slotPerSide =
+            static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(targetNum))));
+        slotPerAtlas[0] = slotPerAtlas[1] = std::min(maxSlotPerSide, slotPerSide);
+        slotPerAtlas[2] = std::min(
+            maxSlotPerSide, std::max(1u, targetNum / (slotPerAtlas[0] * slotPerAtlas[1])));
+        for (uint32_t s = GetSlotNumber(); s > 0; --s)
+            freeSlots.emplace_back(s - 1);
+
+        GLenum pixFmt = GL_RED;
+        GLenum pixTy = GL_UNSIGNED_BYTE;
+        GLint internalFmt = GL_R8;
+        switch (this->pyramid->GetInfo().voxTy) {
+        case VIS4Earth::ESupportedVoxelType::UInt8:
+            break;
+        case VIS4Earth::ESupportedVoxelType::UInt16:
+            pixTy = VoxelTypeTraits<uint16_t>::PixelType();
+            internalFmt = VoxelTypeTraits<uint16_t>::InternalFormat();
+            break;
+        case VIS4Earth::ESupportedVoxelType::Float32:
+            pixTy = VoxelTypeTraits<float>::PixelType();
+            internalFmt = VoxelTypeTraits<float>::InternalFormat();
+            break;
+        default:
+            assert(false);
+        }
+        atlasImg = new osg::Image;
+        atlasImg->allocateImage(slotPerAtlas[0] * bvps, slotPerAtlas[1] * bvps,
+                                slotPerAtlas[2] * bvps, pixFmt, pixTy);
+        atlasImg->setInternalTextureFormat(internalFmt);
+        std::memset(atlasImg->data(), 0, atlasImg->getTotalSizeInBytes());
+        atlas = new osg::Texture3D;
+        atlas->setResizeNonPowerOfTwoHint(false);
+        atlas->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::LINEAR);
+        atlas->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::LINEAR);
+        atlas->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        atlas->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        atlas->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        atlas->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        atlas->setImage(atlasImg);
+
+        auto pagePerVol = this->pyramid->GetBrickPerLevel(0);
+        pageTableImg = new osg::Image;
+        pageTableImg->allocateImage(pagePerVol[0], pagePerVol[1], pagePerVol[2], GL_RGBA,
+                                    GL_FLOAT);
+        pageTableImg->setInternalTextureFormat(GL_RGBA32F_ARB);
+        std::memset(pageTableImg->data(), 0, pageTableImg->getTotalSizeInBytes());
+        pageTable = new osg::Texture3D;
+        pageTable->setResizeNonPowerOfTwoHint(false);
+        pageTable->setFilter(osg::Texture::MAG_FILTER, osg::Texture::FilterMode::NEAREST);
+        pageTable->setFilter(osg::Texture::MIN_FILTER, osg::Texture::FilterMode::NEAREST);
+        pageTable->setWrap(osg::Texture::WRAP_S, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        pageTable->setWrap(osg::Texture::WRAP_T, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        pageTable->setWrap(osg::Texture::WRAP_R, osg::Texture::WrapMode::CLAMP_TO_EDGE);
+        pageTable->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
+        pageTable->setImage(pageTableImg);
+    }
+
+    PyramidBrickCache(const PyramidBrickCache &) = delete;
+    PyramidBrickCache &operator=(const PyramidBrickCache &) = delete;
+
+    const std::shared_ptr<const VolumePyramid> &GetPyramid() const { return pyramid; }
+    uint32_t GetSlotNumber() const { return slotPerAtlas[0] * slotPerAtlas[1] * slotPerAtlas[2]; }
+    std::array<uint32_t, 3> GetAtlasVoxelPerVolume() const {
+        auto bvps = pyramid->GetBrickVoxelPerSide();
+        return {slotPerAtlas[0] * bvps, slotPerAtlas[1] * bvps, slotPerAtlas[2] * bvps};
+    }
+    osg::ref_ptr<osg::Texture3D> GetAtlasTexture() const { return atlas; }
+    osg::ref_ptr<osg::Texture3D> GetPageTableTexture() const { return pageTable; }
+
+    /*
+     * 函数: SelectBricks
+     * 功能: 从最粗的层开始，每次细分屏幕空间误差最大的砖块，直到误差均不超过阈值，
+     *       或再细分将超出图集容量。返回的砖块互不重叠且覆盖整个体
+     */
+    std::vector<VolumePyramid::BrickKey> SelectBricks(const LODParameters &param) const {
+        using Item = std::pair<float, VolumePyramid::BrickKey>;
+        auto cmp = [](const Item &a, const Item &b) { return a.first < b.first; };
+        std::priority_queue<Item, std::vector<Item>, decltype(cmp)> candidates(cmp);
+        std::vector<VolumePyramid::BrickKey> keys;
+
+        auto topLvl = pyramid->GetLevelNumber() - 1;
+        candidates.emplace(computeError(param, {topLvl, {0, 0, 0}}),
+                           VolumePyramid::BrickKey{topLvl, {0, 0, 0}});
+        auto selectedNum = 1u;
+        while (!candidates.empty()) {
+            auto item = candidates.top();
+            candidates.pop();
+            auto &key = item.second;
+            if (item.first <= param.errorThreshold || key.level == 0) {
+                keys.emplace_back(key);
+                continue;
+            }
+
+            auto brickPerLvl = pyramid->GetBrickPerLevel(key.level - 1);
+            std::vector<VolumePyramid::BrickKey> children;
+            for (uint32_t i = 0; i < 8; ++i) {
+                VolumePyramid::BrickKey child = {key.level - 1,
+                                                 {2 * key.brickPos[0] + (i & 1),
+                                                  2 * key.brickPos[1] + ((i >> 1) & 1),
+                                                  2 * key.brickPos[2] + ((i >> 2) & 1)}};
+                if (child.brickPos[0] < brickPerLvl[0] && child.brickPos[1] < brickPerLvl[1] &&
+                    child.brickPos[2] < brickPerLvl[2])
+                    children.emplace_back(child);
+            }
+            if (selectedNum - 1 + children.size() > GetSlotNumber()) {
+                keys.emplace_back(key);
+                continue;
+            }
+
+            selectedNum += static_cast<uint32_t>(children.size()) - 1;
+            for (auto &child : children)
+                candidates.emplace(computeError(param, child), child);
+        }
+
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    /*
+     * 函数: Update
+     * 功能: 按视点重新选择砖块，将未驻留的砖块从映射中调入图集并更新页表
+     * 返回: 图集或页表是否有变化
+     */
+    bool Update(const LODParameters &param) {
+        auto keys = SelectBricks(param);
+        stats.selectedNum = static_cast<uint32_t>(keys.size());
+
+        std::vector<VolumePyramid::BrickKey> misses;
+        for (auto &key : keys) {
+            auto itr = key2Slots.find(key);
+            if (itr == key2Slots.end()) {
+                misses.emplace_back(key);
+                continue;
+            }
+            ++stats.hitNum;
+            lru.splice(lru.begin(), lru, itr->second);
+        }
+
+        // 所选砖块数不超过槽位数，且命中的砖块已移到 LRU 链表头部，因此尾部的砖块均未被选中
+        std::vector<std::pair<VolumePyramid::BrickKey, uint32_t>> loads;
+        for (auto &key : misses) {
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = lru.back().second;
+                key2Slots.erase(lru.back().first);
+                lru.pop_back();
+                ++stats.evictNum;
+            }
+            ++stats.missNum;
+            lru.emplace_front(key, slot);
+            key2Slots.emplace(key, lru.begin());
+            loads.emplace_back(key, slot);
+        }
+        ThreadPool::Global().ParallelFor(0, static_cast<uint32_t>(loads.size()), [&](uint32_t i) {
+            loadBrick(loads[i].first, loads[i].second);
+        });
+        if (!loads.empty())
+            atlasImg->dirty();
+
+        auto changed = keys != selectedKeys;
+        if (changed) {
+            selectedKeys = std::move(keys);
+            updatePageTable();
+            pageTableImg->dirty();
+        }
+        return changed || !loads.empty();
+    }
+
+    Statistics GetStatistics() const {
+        auto ret = stats;
+        ret.residentNum = static_cast<uint32_t>(key2Slots.size());
+        ret.slotNum = GetSlotNumber();
+        ret.residentBytes = key2Slots.size() * pyramid->GetBrickByteSize();
+        return ret;
+    }
+
+    void LogStatistics() const {
+        auto stats = GetStatistics();
+        qDebug() << "PyramidBrickCache:" << stats.selectedNum << "selected," << stats.residentNum
+                 << "/" << stats.slotNum << "resident bricks," << stats.residentBytes << "bytes,"
+                 << stats.hitNum << "hits," << stats.missNum << "misses," << stats.evictNum
+                 << "evictions";
+    }
+
+  private:
+    std::shared_ptr<const VolumePyramid> pyramid;
+    std::array<uint32_t, 3> slotPerAtlas;
+    osg::ref_ptr<osg::Image> atlasImg;
+    osg::ref_ptr<osg::Texture3D> atlas;
+    osg::ref_ptr<osg::Image> pageTableImg;
+    osg::ref_ptr<osg::Texture3D> pageTable;
+
+    std::vector<uint32_t> freeSlots;
+    std::list<std::pair<VolumePyramid::BrickKey, uint32_t>> lru; // (砖块, 槽位)
+    std::map<VolumePyramid::BrickKey,
+             std::list<std::pair<VolumePyramid::BrickKey, uint32_t>>::iterator>
+        key2Slots;
+    std::vector<VolumePyramid::BrickKey> selectedKeys;
+    Statistics stats = {0, 0, 0, 0, 0, 0, 0};
+
+    std::array<uint32_t, 3> getSlotPosition(uint32_t slot) const {
+        return {slot % slotPerAtlas[0], slot / slotPerAtlas[0] % slotPerAtlas[1],
+                slot / slotPerAtlas[0] / slotPerAtlas[1]};
+    }
+
+    /*
+     * 函数: computeError
+     * 功能: 以砖块的包围球估计其体素对视点所张的角度，视点位于包围球内时视为误差最大
+     */
+    float computeError(const LODParameters &param, const VolumePyramid::BrickKey &key) const {
+        auto &voxPerVol = pyramid->GetInfo().voxPerVol;
+        auto bs = pyramid->GetInfo().brickSize;
+        std::array<std::array<float, 2>, 3> uRngs;
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 2; ++j) {
+                auto vox = std::min(static_cast<uint64_t>(key.brickPos[i] + j) * bs << key.level,
+                                    static_cast<uint64_t>(voxPerVol[i]));
+                uRngs[i][j] = static_cast<float>(vox) / voxPerVol[i];
+            }
+
+        std::array<osg::Vec3, 9> pnts;
+        for (uint32_t i = 0; i < 9; ++i) {
+            std::array<float, 3> u;
+            for (int d = 0; d < 3; ++d)
+                u[d] = i == 8 ? .5f * (uRngs[d][0] + uRngs[d][1]) : uRngs[d][(i >> d) & 1];
+            pnts[i] = Math::BLHToEarthOSGVec3(
+                param.lonRange[0] + u[0] * (param.lonRange[1] - param.lonRange[0]),
+                param.latRange[0] + u[1] * (param.latRange[1] - param.latRange[0]),
+                param.radiusRange[0] + u[2] * (param.radiusRange[1] - param.radiusRange[0]));
+        }
+        osg::Vec3 cntr(0.f, 0.f, 0.f);
+        for (auto &pnt : pnts)
+            cntr += pnt;
+        cntr /= static_cast<float>(pnts.size());
+        float radius = 0.f;
+        for (auto &pnt : pnts)
+            radius = std::max(radius, (pnt - cntr).length());
+
+        auto voxSz = 2.f * radius / (bs * std::sqrt(3.f));
+        auto dist = (param.eyePos - cntr).length() - radius;
+        if (dist <= voxSz)
+            return std::numeric_limits<float>::max();
+        return voxSz / dist;
+    }
+
+    void loadBrick(const VolumePyramid::BrickKey &key, uint32_t slot) {
+        auto voxSz = RAWVolumeData::GetVoxelSize(pyramid->GetInfo().voxTy);
+        auto bvps = pyramid->GetBrickVoxelPerSide();
+        auto atlasVoxPerVol = GetAtlasVoxelPerVolume();
+        auto slotPos = getSlotPosition(slot);
+        auto src = pyramid->GetBrickData(key);
+        for (uint32_t z = 0; z < bvps; ++z)
+            for (uint32_t y = 0; y < bvps; ++y)
+                std::memcpy(atlasImg->data() +
+                                voxSz * ((static_cast<size_t>(slotPos[2] * bvps + z) *
+                                              atlasVoxPerVol[1] +
+                                          slotPos[1] * bvps + y) *
+                                             atlasVoxPerVol[0] +
+                                         slotPos[0] * bvps),
+                            src + voxSz * (static_cast<size_t>(z) * bvps + y) * bvps,
+                            voxSz * bvps);
+    }
+
+    /*
+     * 函数: updatePageTable
+     * 功能: 页表项 (x, y, z, w) 中 w = 2^l，体数据空间中第 0 层的体素坐标 p 对应图集中的体素坐标
+     *       p / w + (x, y, z)
+     */
+    void updatePageTable() {
+        auto bs = pyramid->GetInfo().brickSize;
+        auto bvps = pyramid->GetBrickVoxelPerSide();
+        auto pagePerVol = pyramid->GetBrickPerLevel(0);
+        auto entries = reinterpret_cast<osg::Vec4 *>(pageTableImg->data());
+        for (auto &key : selectedKeys) {
+            auto slotPos = getSlotPosition(key2Slots.at(key)->second);
+            osg::Vec4 entry;
+            for (int i = 0; i < 3; ++i)
+                entry[i] = static_cast<float>(slotPos[i] * bvps + 1) -
+                           static_cast<float>(key.brickPos[i] * bs);
+            entry[3] = static_cast<float>(1u << key.level);
+
+            std::array<uint32_t, 3> beg, end;
+            for (int i = 0; i < 3; ++i) {
+                beg[i] = key.brickPos[i] << key.level;
+                end[i] = std::min((key.brickPos[i] + 1) << key.level, pagePerVol[i]);
+            }
+            for (auto z = beg[2]; z < end[2]; ++z)
+                for (auto y = beg[1]; y < end[1]; ++y)
+                    for (auto x = beg[0]; x < end[0]; ++x)
+                        entries[(static_cast<size_t>(z) * pagePerVol[1] + y) * pagePerVol[0] +
+                                x] = entry;
+        }
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_DATA_VOL_PYRAMID_H
@@ -73,3 +73,14 @@ VIS4Earth::GeographicsComponent::GeographicsComponent(QWidget *parent)
             QOverload<double>::of(&QDoubleSpinBox::valueChanged), onGeographicsChanged);
     onGeographicsChanged(0.);
 }
+
+void VIS4Earth::GeographicsComponent::SetGeographics(float lonMin, float lonMax, float latMin,
+                                                     float latMax, float heightMin,
+                                                     float heightMax) {
+    ui->doubleSpinBox_longtitudeMin_float_VIS4EarthReflectable->setValue(lonMin);
+    ui->doubleSpinBox_longtitudeMax_float_VIS4EarthReflectable->setValue(lonMax);
+    ui->doubleSpinBox_latitudeMin_float_VIS4EarthReflectable->setValue(latMin);
+    ui->doubleSpinBox_latitudeMax_float_VIS4EarthReflectable->setValue(latMax);
+    ui->doubleSpinBox_heightMin_float_VIS4EarthReflectable->setValue(heightMin);
+    ui->doubleSpinBox_heightMax_float_VIS4EarthReflectable->setValue(heightMax);
+}
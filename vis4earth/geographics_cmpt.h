@@ -22,6 +22,13 @@ class GeographicsComponent : public QtOSGReflectableWidget {
 
     const osg::ref_ptr<osg::Uniform> &GetRotateMatrix() const { return rotMat; }
 
+    /*
+     * 函数: SetGeographics
+     * 功能: 设置经纬度（单位为度）与高度（单位为米）范围，如使用体数据容器中记录的范围
+     */
+    void SetGeographics(float lonMin, float lonMax, float latMin, float latMax, float heightMin,
+                        float heightMax);
+
   Q_SIGNALS:
     void GeographicsChanged();
 
@@ -0,0 +1,185 @@
+#ifndef VIS4EARTH_IO_MAPPED_FILE_H
+#define VIS4EARTH_IO_MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // !NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace VIS4Earth {
+
+/*
+ * 类: MappedFile
+ * 功能: 以只读共享页的方式将整个文件映射到内存，数据按需由操作系统换入，
+ *       多个对象可通过 std::shared_ptr 共享同一份映射
+ */
+class MappedFile {
+  public:
+    enum class EAccessHint { Sequential = 0, Random, Normal };
+
+    static std::shared_ptr<MappedFile> Open(const std::string &filePath, EAccessHint hint,
+                                            std::string *errMsg = nullptr) {
+        std::shared_ptr<MappedFile> ret(new MappedFile);
+
+#ifdef _WIN32
+        DWORD flags = hint == EAccessHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+                      : hint == EAccessHint::Random   ? FILE_FLAG_RANDOM_ACCESS
+                                                      : FILE_ATTRIBUTE_NORMAL;
+        ret->file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, flags, nullptr);
+        if (ret->file == INVALID_HANDLE_VALUE) {
+            if (errMsg)
+                *errMsg = "Invalid File Path";
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSz;
+        if (!GetFileSizeEx(ret->file, &fileSz) || fileSz.QuadPart == 0) {
+            if (errMsg)
+                *errMsg = "Empty File";
+            return nullptr;
+        }
+        ret->size = static_cast<size_t>(fileSz.QuadPart);
+
+        FILETIME writeTime;
+        if (GetFileTime(ret->file, nullptr, nullptr, &writeTime))
+            ret->modifiedTime =
+                (static_cast<uint64_t>(writeTime.dwHighDateTime) << 32) | writeTime.dwLowDateTime;
+
+        ret->mapping = CreateFileMappingA(ret->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!ret->mapping) {
+            if (errMsg)
+                *errMsg = "Failed to Map File";
+            return nullptr;
+        }
+        ret->dat = reinterpret_cast<const uint8_t *>(
+            MapViewOfFile(ret->mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        ret->fd = open(filePath.c_str(), O_RDONLY);
+        if (ret->fd < 0) {
+            if (errMsg)
+                *errMsg = "Invalid File Path";
+            return nullptr;
+        }
+
+        struct stat st;
+        if (fstat(ret->fd, &st) != 0 || st.st_size == 0) {
+            if (errMsg)
+                *errMsg = "Empty File";
+            return nullptr;
+        }
+        ret->size = static_cast<size_t>(st.st_size);
+        ret->modifiedTime = static_cast<uint64_t>(st.st_mtime);
+
+        auto ptr = mmap(nullptr, ret->size, PROT_READ, MAP_SHARED, ret->fd, 0);
+        if (ptr == MAP_FAILED)
+            ptr = nullptr;
+        ret->dat = reinterpret_cast<const uint8_t *>(ptr);
+#endif // _WIN32
+
+        if (!ret->dat) {
+            if (errMsg)
+                *errMsg = "Failed to Map File";
+            return nullptr;
+        }
+
+        ret->Advise(hint);
+        return ret;
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (dat)
+            UnmapViewOfFile(dat);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (dat)
+            munmap(const_cast<uint8_t *>(dat), size);
+        if (fd >= 0)
+            close(fd);
+#endif // _WIN32
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *GetData() const { return dat; }
+    size_t GetSize() const { return size; }
+    // 打开时文件的最后修改时间，单位随平台而异，仅用于判断文件是否变化
+    uint64_t GetModifiedTime() const { return modifiedTime; }
+
+    /*
+     * 函数: Advise
+     * 功能: 根据后续访问模式提示操作系统调整预读策略
+     */
+    void Advise(EAccessHint hint) const {
+#ifndef _WIN32
+        int advice = hint == EAccessHint::Sequential ? MADV_SEQUENTIAL
+                     : hint == EAccessHint::Random   ? MADV_RANDOM
+                                                     : MADV_NORMAL;
+        madvise(const_cast<uint8_t *>(dat), size, advice);
+#endif // !_WIN32
+    }
+
+    /*
+     * 函数: GetResidentBytes
+     * 功能: 返回映射中 [offs, offs + sz) 范围内当前驻留于物理内存的字节数（按页统计）
+     * 注意: Windows 下不统计工作集，返回范围大小作为上界
+     */
+    size_t GetResidentBytes(size_t offs = 0,
+                            size_t sz = std::numeric_limits<size_t>::max()) const {
+        offs = std::min(offs, size);
+        sz = std::min(sz, size - offs);
+#ifdef _WIN32
+        return sz;
+#else
+        auto pageSz = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto pageBeg = offs / pageSz * pageSz; // mincore 要求起始地址按页对齐
+        auto pageNum = (offs + sz - pageBeg + pageSz - 1) / pageSz;
+        std::vector<unsigned char> residency(pageNum);
+        if (mincore(const_cast<uint8_t *>(dat) + pageBeg, offs + sz - pageBeg,
+                    residency.data()) != 0)
+            return sz;
+
+        size_t residentPageNum = 0;
+        for (auto flag : residency)
+            residentPageNum += flag & 0x1;
+        return std::min(residentPageNum * pageSz, sz);
+#endif // _WIN32
+    }
+
+  private:
+    size_t size = 0;
+    uint64_t modifiedTime = 0;
+    const uint8_t *dat = nullptr;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif // _WIN32
+
+    MappedFile() {}
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_IO_MAPPED_FILE_H
@@ -0,0 +1,83 @@
+#ifndef VIS4EARTH_IO_RLE_CODEC_H
+#define VIS4EARTH_IO_RLE_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <vector>
+
+namespace VIS4Earth {
+
+/*
+ * 类: RLECodec
+ * 功能: 字节级游程编码（PackBits 变体）。控制字节 c < 128 时其后跟随 c + 1 个原样字节；
+ *       c >= 128 时其后的 1 个字节重复 c - 125 次（3 ~ 130 次）。
+ *       最坏情况下每 128 字节仅膨胀 1 字节
+ */
+class RLECodec {
+  public:
+    static constexpr size_t MaxLiteralNumber = 128;
+    static constexpr size_t MinRunNumber = 3;
+    static constexpr size_t MaxRunNumber = 130;
+
+    /*
+     * 函数: Encode
+     * 功能: 将 src 的 srcSize 个字节编码后追加到 dst 末尾
+     */
+    static void Encode(const uint8_t *src, size_t srcSize, std::vector<uint8_t> &dst) {
+        size_t i = 0;
+        while (i < srcSize) {
+            size_t runNum = 1;
+            while (i + runNum < srcSize && runNum < MaxRunNumber && src[i + runNum] == src[i])
+                ++runNum;
+            if (runNum >= MinRunNumber) {
+                dst.emplace_back(static_cast<uint8_t>(runNum + 125));
+                dst.emplace_back(src[i]);
+                i += runNum;
+                continue;
+            }
+
+            // 原样字节持续到下一段足够长的游程开始为止
+            auto beg = i;
+            while (i < srcSize && i - beg < MaxLiteralNumber) {
+                if (i + 2 < srcSize && src[i] == src[i + 1] && src[i] == src[i + 2])
+                    break;
+                ++i;
+            }
+            dst.emplace_back(static_cast<uint8_t>(i - beg - 1));
+            dst.insert(dst.end(), src + beg, src + i);
+        }
+    }
+
+    /*
+     * 函数: Decode
+     * 功能: 将 src 解码到 dst，解码结果须恰好为 dstSize 个字节
+     * 返回: 数据损坏或长度不符时返回 false
+     */
+    static bool Decode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+        size_t i = 0, o = 0;
+        while (i < srcSize) {
+            auto c = src[i++];
+            if (c < MaxLiteralNumber) {
+                size_t num = c + 1;
+                if (num > srcSize - i || num > dstSize - o)
+                    return false;
+                std::memcpy(dst + o, src + i, num);
+                i += num;
+                o += num;
+            } else {
+                size_t num = c - 125;
+                if (i == srcSize || num > dstSize - o)
+                    return false;
+                std::memset(dst + o, src[i], num);
+                ++i;
+                o += num;
+            }
+        }
+        return o == dstSize;
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_IO_RLE_CODEC_H
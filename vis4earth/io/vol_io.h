@@ -1,30 +1,61 @@
 #ifndef VIS4EARTH_IO_VOL_IO_H
 #define VIS4EARTH_IO_VOL_IO_H
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 
 #include <array>
+#include <deque>
 #include <unordered_set>
 #include <vector>
 
 #include <osg/Vec3>
 #include <osg/Vec4>
 
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/data/vol_gridding.h>
+#include <vis4earth/io/mapped_file.h>
+#include <vis4earth/thread_pool.h>
+
 namespace VIS4Earth {
 namespace Loader {
 class RAWVolume {
   public:
+    /*
+     * 函数: LoadU8FromFile
+     * 功能: 将RAW文件的体素数据读入 std::vector。优先经只读映射顺序复制一次，
+     *       无法映射时退回流式读入，errMsg 中附带映射失败的原因
+     */
     static std::vector<uint8_t> LoadU8FromFile(const std::string &filePath,
                                                const std::array<uint32_t, 3> &dim,
                                                std::string *errMsg = nullptr) {
+        std::string mapErrMsg;
+        if (auto mapped = MappedFile::Open(filePath, MappedFile::EAccessHint::Sequential,
+                                           &mapErrMsg)) {
+            auto voxNum = static_cast<size_t>(dim[0]) * dim[1] * dim[2];
+            if (mapped->GetSize() < sizeof(uint8_t) * voxNum) {
+                if (errMsg)
+                    *errMsg = "File Size is Smaller than Volume Size";
+                return std::vector<uint8_t>();
+            }
+            return std::vector<uint8_t>(mapped->GetData(), mapped->GetData() + voxNum);
+        }
+
         std::ifstream is(filePath, std::ios::in | std::ios::binary | std::ios::ate);
         if (!is.is_open()) {
             if (errMsg)
-                *errMsg = "Invalid File Path";
+                *errMsg = "Invalid File Path (mapping: " + mapErrMsg + ")";
             return std::vector<uint8_t>();
         }
 
@@ -48,6 +79,28 @@ class RAWVolume {
         return dat;
     }
 
+    /*
+     * 函数: MapU8FromFile
+     * 功能: 以只读映射的方式打开RAW文件，不复制体素数据
+     * 返回: 映射对象，其前 dim[0]*dim[1]*dim[2] 字节为体素数据；失败时返回空指针
+     */
+    static std::shared_ptr<MappedFile>
+    MapU8FromFile(const std::string &filePath, const std::array<uint32_t, 3> &dim,
+                  MappedFile::EAccessHint hint = MappedFile::EAccessHint::Sequential,
+                  std::string *errMsg = nullptr) {
+        auto mapped = MappedFile::Open(filePath, hint, errMsg);
+        if (!mapped)
+            return nullptr;
+
+        if (mapped->GetSize() < sizeof(uint8_t) * dim[0] * dim[1] * dim[2]) {
+            if (errMsg)
+                *errMsg = "File Size is Smaller than Volume Size";
+            return nullptr;
+        }
+
+        return mapped;
+    }
+
     static bool DumpToFile(const std::string &filePath, const std::vector<uint8_t> &dat,
                            std::string *errMsg = nullptr) {
         std::ofstream os(filePath, std::ios::out | std::ios::binary);
@@ -64,70 +117,235 @@ class RAWVolume {
     }
 };
 
+/*
+ * 类: TXTParser
+ * 功能: 文本数据的数值解析，供各 TXT 加载器共用
+ */
+class TXTParser {
+  public:
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+    /*
+     * 函数: ParseFloat
+     * 功能: 解析 [p, end) 开头的浮点数（接受的格式与 %f 相同，含 nan、inf），成功时前移 p。
+     *       有效数字不超过 18 位时以 64 位整数累加，再乘以精确的 10 的幂，结果与 strtof 一致
+     *       或仅差末位
+     */
+    static bool ParseFloat(const char *&p, const char *end, float &val) {
+        static const double pow10s[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        auto q = p;
+        auto neg = false;
+        if (q != end && (*q == '+' || *q == '-')) {
+            neg = *q == '-';
+            ++q;
+        }
+
+        auto matchWord = [&](const char *word) {
+            auto len = std::strlen(word);
+            if (static_cast<size_t>(end - q) < len)
+                return false;
+            for (size_t i = 0; i < len; ++i)
+                if ((q[i] | 0x20) != word[i])
+                    return false;
+            q += len;
+            return true;
+        };
+        if (matchWord("nan")) {
+            val = std::numeric_limits<float>::quiet_NaN();
+            p = q;
+            return true;
+        }
+        if (matchWord("inf")) {
+            matchWord("inity");
+            val = neg ? -std::numeric_limits<float>::infinity()
+                      : std::numeric_limits<float>::infinity();
+            p = q;
+            return true;
+        }
+
+        uint64_t mant = 0;
+        int32_t exp10 = 0;
+        int32_t digitNum = 0;
+        auto hasDigit = false;
+        auto addDigit = [&](char c, bool isFrac) {
+            if (digitNum < 18) {
+                mant = mant * 10 + (c - '0');
+                if (mant != 0)
+                    ++digitNum;
+                if (isFrac)
+                    --exp10;
+            } else if (!isFrac)
+                ++exp10;
+            hasDigit = true;
+        };
+        for (; q != end && *q >= '0' && *q <= '9'; ++q)
+            addDigit(*q, false);
+        if (q != end && *q == '.')
+            for (++q; q != end && *q >= '0' && *q <= '9'; ++q)
+                addDigit(*q, true);
+        if (!hasDigit)
+            return false;
+
+        if (q != end && (*q == 'e' || *q == 'E')) {
+            auto r = q + 1;
+            auto expNeg = false;
+            if (r != end && (*r == '+' || *r == '-')) {
+                expNeg = *r == '-';
+                ++r;
+            }
+            if (r != end && *r >= '0' && *r <= '9') {
+                int32_t e = 0;
+                for (; r != end && *r >= '0' && *r <= '9'; ++r)
+                    e = std::min(e * 10 + (*r - '0'), 100000);
+                exp10 += expNeg ? -e : e;
+                q = r;
+            }
+        }
+
+        auto v = static_cast<double>(mant);
+        if (exp10 < 0)
+            v = -exp10 <= 22 ? v / pow10s[-exp10] : v * std::pow(10., exp10);
+        else if (exp10 > 0)
+            v = exp10 <= 22 ? v * pow10s[exp10] : v * std::pow(10., exp10);
+        val = static_cast<float>(neg ? -v : v);
+        p = q;
+        return true;
+    }
+};
+
 class TXTVolume {
   public:
     static std::vector<float> LoadFromFile(const std::string &filePath,
                                            const std::array<uint32_t, 3> &dim, float nullVal,
                                            std::string *errMsg = nullptr) {}
-    /* 读取txt点云文件 */
-    static std::vector<osg::Vec3f> LoadFromFile(const std::string &filePath,
-                                                std::string *errMsg = nullptr) {
-        std::ifstream is(filePath);
-        if (!is.is_open()) {
+    /*
+     * 结构体: PointBatch
+     * 功能: 一个文本块解析出的点，按列以结构数组存放，前 colNum 列有效且等长
+     */
+    struct PointBatch {
+        uint32_t chunkID; // 块在文件中的序号，各批按此顺序交付
+        std::array<std::vector<float>, 4> cols;
+
+        size_t GetPointNumber() const { return cols[0].size(); }
+    };
+    struct StreamParameters {
+        uint32_t colNum = 3;           // 每行读取的列数（1 至 4）
+        size_t chunkSize = 4 << 20;    // 每块的文本字节数，决定单批的点数
+        uint32_t maxChunkInFlight = 0; // 同时解析与待交付的块数，为 0 时取线程数的 2 倍
+    };
+
+    /*
+     * 函数: Stream
+     * 功能: 流式加载点云文本。文件按 chunkSize 在行边界处切块，由线程池并行解析，
+     *       解析完成的批按文件顺序在调用线程中交给 consumer，调用方无需等待整个文件读完。
+     *       在途的块数有上限，内存占用取决于块大小而非文件大小。
+     *       首列可解析的行有效，缺少的其余列记为 0；空行与无法解析的行被跳过
+     * 参数:
+     * -- consumer: 接收各批，返回 false 时停止加载
+     * -- errMsg: 非空时写入错误信息
+     */
+    static bool Stream(const std::string &filePath, const StreamParameters &param,
+                       const std::function<bool(PointBatch &&)> &consumer,
+                       std::string *errMsg = nullptr) {
+        if (param.colNum == 0 || param.colNum > 4 || param.chunkSize == 0) {
             if (errMsg)
-                *errMsg = "Invalid File Path";
-            return std::vector<osg::Vec3f>();
+                *errMsg = "Invalid param.";
+            return false;
         }
 
-        std::string line;
-        std::vector<osg::Vec3f> ret;
-        int flag = 0;
-        while (std::getline(is, line)) {
-            /*if (flag == 0) {
-                    flag++;
-                    continue;
-            }*/
-            float x, y, z;
-            std::stringstream ss(line);
-            ss >> x;
-            ss >> y;
-            ss >> z;
-            osg::Vec3f point(x, y, z);
-            ret.push_back(point);
-            // flag--;
+        std::shared_ptr<const MappedFile> mapped =
+            MappedFile::Open(filePath, MappedFile::EAccessHint::Sequential, errMsg);
+        if (!mapped)
+            return false;
+
+        auto fileBeg = reinterpret_cast<const char *>(mapped->GetData());
+        auto fileEnd = fileBeg + mapped->GetSize();
+        auto chunkNum = static_cast<uint32_t>((mapped->GetSize() + param.chunkSize - 1) /
+                                              param.chunkSize);
+        // 块 c 始于 c * chunkSize - 1 处及其后首个换行符之后，保证块间首尾相接
+        auto chunkBeg = [&](uint32_t c) {
+            if (c == 0)
+                return fileBeg;
+            if (c >= chunkNum)
+                return fileEnd;
+            auto p = fileBeg + static_cast<size_t>(c) * param.chunkSize - 1;
+            auto lineEnd = static_cast<const char *>(std::memchr(p, '\n', fileEnd - p));
+            return lineEnd ? lineEnd + 1 : fileEnd;
+        };
+
+        auto maxChunkInFlight = param.maxChunkInFlight != 0
+                                    ? param.maxChunkInFlight
+                                    : std::max(2u, 2 * ThreadPool::Global().GetThreadNumber());
+        auto colNum = param.colNum;
+        std::deque<std::shared_ptr<ChunkTask>> inFlight;
+        uint32_t nextChunkID = 0;
+        for (uint32_t c = 0; c < chunkNum; ++c) {
+            for (; nextChunkID < chunkNum && inFlight.size() < maxChunkInFlight; ++nextChunkID) {
+                auto task = std::make_shared<ChunkTask>();
+                task->beg = chunkBeg(nextChunkID);
+                task->end = chunkBeg(nextChunkID + 1);
+                task->batch.chunkID = nextChunkID;
+                // 任务持有映射与自身，调用方提前返回后仍可安全完成
+                task->done = ThreadPool::Global().Submit([task, mapped, colNum]() {
+                    if (!task->claimed.exchange(true))
+                        parsePointChunk(task->beg, task->end, colNum, task->batch);
+                });
+                inFlight.emplace_back(std::move(task));
+            }
+
+            // 尚无工作线程认领时由调用线程解析，避免在工作线程中调用时死锁
+            auto task = std::move(inFlight.front());
+            inFlight.pop_front();
+            if (!task->claimed.exchange(true))
+                parsePointChunk(task->beg, task->end, colNum, task->batch);
+            else
+                task->done.wait();
+
+            if (!consumer(std::move(task->batch)))
+                break;
         }
+
+        return true;
+    }
+
+    /* 读取txt点云文件，每行为 "x y z" */
+    static std::vector<osg::Vec3f> LoadFromFile(const std::string &filePath,
+                                                std::string *errMsg = nullptr) {
+        std::vector<osg::Vec3f> ret;
+        StreamParameters param;
+        param.colNum = 3;
+        Stream(
+            filePath, param,
+            [&](PointBatch &&batch) {
+                auto num = batch.GetPointNumber();
+                for (size_t i = 0; i < num; ++i)
+                    ret.emplace_back(batch.cols[0][i], batch.cols[1][i], batch.cols[2][i]);
+                return true;
+            },
+            errMsg);
         return ret;
     }
 
+    /* 读取txt点云文件，每行为 "经度 纬度 时间 值"，返回 ((经度, 纬度, 值), 时间) */
     static std::vector<std::pair<osg::Vec3f, float>>
     LoadFromParFile(const std::string &filePath, std::string *errMsg = nullptr) {
-        std::ifstream is(filePath);
-        if (!is.is_open()) {
-            if (errMsg)
-                *errMsg = "Invalid File Path";
-            return std::vector<std::pair<osg::Vec3f, float>>();
-        }
-
-        std::string line;
         std::vector<std::pair<osg::Vec3f, float>> ret;
-        int flag = 0;
-        while (std::getline(is, line)) {
-            /*if (flag == 0) {
-                    flag++;
-                    continue;
-            }*/
-            float lon, lat, t, data;
-            // float x, y, z;
-            std::stringstream ss(line);
-            ss >> lon;
-            ss >> lat;
-            ss >> t;
-            ss >> data;
-            osg::Vec3f point(lon, lat, data);
-
-            ret.push_back(std::make_pair(point, t));
-            // flag--;
-        }
+        StreamParameters param;
+        param.colNum = 4;
+        Stream(
+            filePath, param,
+            [&](PointBatch &&batch) {
+                auto num = batch.GetPointNumber();
+                for (size_t i = 0; i < num; ++i)
+                    ret.emplace_back(
+                        osg::Vec3f(batch.cols[0][i], batch.cols[1][i], batch.cols[3][i]),
+                        batch.cols[2][i]);
+                return true;
+            },
+            errMsg);
         return ret;
     }
 
@@ -162,6 +380,49 @@ class TXTVolume {
     //	}
     //	return data;
     // }
+
+  private:
+    struct ChunkTask {
+        const char *beg;
+        const char *end;
+        std::atomic<bool> claimed;
+        PointBatch batch;
+        std::future<void> done;
+
+        ChunkTask() : claimed(false) {}
+    };
+
+    /*
+     * 函数: parsePointChunk
+     * 功能: 逐行解析 [beg, end) 的前 colNum 列。先按换行符数预留各列，避免逐点扩容
+     */
+    static void parsePointChunk(const char *beg, const char *end, uint32_t colNum,
+                                PointBatch &batch) {
+        auto lineNum = static_cast<size_t>(std::count(beg, end, '\n')) + 1;
+        for (uint32_t i = 0; i < colNum; ++i)
+            batch.cols[i].reserve(lineNum);
+
+        std::array<float, 4> vals;
+        for (auto p = beg; p < end;) {
+            auto lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!lineEnd)
+                lineEnd = end;
+
+            uint32_t validRead = 0;
+            for (; validRead < colNum; ++validRead) {
+                while (p != lineEnd && TXTParser::IsSpace(*p))
+                    ++p;
+                if (!TXTParser::ParseFloat(p, lineEnd, vals[validRead]))
+                    break;
+            }
+            p = lineEnd + 1;
+            if (validRead == 0)
+                continue;
+
+            for (uint32_t i = 0; i < colNum; ++i)
+                batch.cols[i].emplace_back(i < validRead ? vals[i] : 0.f);
+        }
+    }
 };
 
 class LabeledTXTVolume {
@@ -173,6 +434,7 @@ class LabeledTXTVolume {
     std::array<float, 2> latRng;
     std::array<float, 2> hRng;
     std::vector<float> dat;
+    std::vector<std::array<float, 3>> coords; // 非稠密时为各值的 (经度, 纬度, 高度)，稠密时为空
 
     void Normalize(const std::array<float, 2> *valRng = nullptr) {
         if (valRng && (*valRng)[1] > (*valRng)[0])
@@ -181,7 +443,7 @@ class LabeledTXTVolume {
         auto rngWid = this->valRng[1] - this->valRng[0];
         for (auto itr = dat.begin(); itr != dat.end(); ++itr) {
             if (isnan(*itr))
-                *itr = this->valRng[0];
+                *itr = 0.f; // 缺测值按最小值处理
             else {
                 *itr = (*itr - this->valRng[0]) / rngWid;
                 if (*itr < 0.f)
@@ -194,63 +456,283 @@ class LabeledTXTVolume {
     }
 
   public:
+    /*
+     * 函数: LoadFromFile
+     * 功能: 加载带标签的 TXT 体数据，首行为表头，其后每行为 "标签 高度 纬度 经度 [值]"。
+     *       useSidecar 为真时优先映射同目录下的二进制旁路缓存（GetSidecarPath），
+     *       缓存缺失或与源文件的大小、修改时间不符时解析文本，并重写缓存供下次使用
+     * 参数:
+     * -- filePath: TXT 文件路径
+     * -- errMsg: 非空时写入错误信息
+     * -- useSidecar: 是否读写旁路缓存。缓存写入失败（如目录只读）时不影响加载结果
+     */
     static LabeledTXTVolume LoadFromFile(const std::string &filePath,
-                                         std::string *errMsg = nullptr) {
+                                         std::string *errMsg = nullptr, bool useSidecar = true) {
         LabeledTXTVolume ret;
 
-        std::ifstream is(filePath, std::ios::in);
-        if (!is.is_open()) {
-            if (errMsg)
-                *errMsg = "Invalid File Path";
+        auto mapped = MappedFile::Open(filePath, MappedFile::EAccessHint::Sequential, errMsg);
+        if (!mapped)
             return ret;
+        if (useSidecar && ret.loadSidecar(GetSidecarPath(filePath), *mapped))
+            return ret;
+
+        ret = parse(*mapped);
+        if (useSidecar)
+            ret.writeSidecar(GetSidecarPath(filePath), *mapped);
+        return ret;
+    }
+    /*
+     * 函数: ParseFromFile
+     * 功能: 不经旁路缓存，直接解析 TXT 文件
+     */
+    static LabeledTXTVolume ParseFromFile(const std::string &filePath,
+                                          std::string *errMsg = nullptr) {
+        auto mapped = MappedFile::Open(filePath, MappedFile::EAccessHint::Sequential, errMsg);
+        if (!mapped)
+            return LabeledTXTVolume();
+        return parse(*mapped);
+    }
+    static std::string GetSidecarPath(const std::string &filePath) { return filePath + ".v4t"; }
+
+  private:
+    static constexpr uint32_t SidecarVersion = 2;
+
+    struct SidecarHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t isDense;
+        uint64_t srcSize; // 源 TXT 文件的大小与修改时间，不符时缓存失效
+        uint64_t srcModifiedTime;
+        uint64_t valNum;
+        uint32_t dim[3];
+        uint32_t reserved;
+        float valRng[2];
+        float lonRng[2];
+        float latRng[2];
+        float hRng[2];
+        // 其后为 valNum 个值，非稠密时再接 valNum 个 (经度, 纬度, 高度)
+    };
+    static_assert(sizeof(SidecarHeader) == 88,
+                  "SidecarHeader layout must not depend on the compiler.");
+
+    static const char *sidecarMagic() { return "V4ETXT\0"; } // 连同结尾的 '\0' 共 8 字节
+
+    /*
+     * 结构体: ParsedChunk
+     * 功能: 单个文本块的解析结果。坐标的取值集合与各范围在块内独立统计，最后合并
+     */
+    struct ParsedChunk {
+        std::vector<float> dat;
+        std::vector<std::array<float, 3>> coords;           // 经度、纬度、高度
+        std::array<std::unordered_set<float>, 3> coordSets; // 高度、纬度、经度
+        std::array<std::array<float, 2>, 4> rngs;           // 值、高度、纬度、经度
+    };
+
+    LabeledTXTVolume() {
+        dim[0] = dim[1] = dim[2] = 0;
+        isDense = false;
+        valRng[0] = lonRng[0] = latRng[0] = hRng[0] = std::numeric_limits<float>::max();
+        valRng[1] = lonRng[1] = latRng[1] = hRng[1] = std::numeric_limits<float>::lowest();
+    }
+
+    /*
+     * 函数: parseChunk
+     * 功能: 逐行解析 [beg, end)，两端均位于行首。每行至少读出 4 个数时有效，缺少值时记为 NaN。
+     *       坐标按行有序排列时相邻行多为同一取值，与上一次插入相同时跳过集合插入
+     */
+    static void parseChunk(const char *beg, const char *end, ParsedChunk &chunk) {
+        for (auto &rng : chunk.rngs) {
+            rng[0] = std::numeric_limits<float>::max();
+            rng[1] = std::numeric_limits<float>::lowest();
         }
+        std::array<float, 3> lastCoords;
+        std::array<bool, 3> hasLastCoords = {false, false, false};
 
-        auto computeMinMax = [](std::array<float, 2> &rng, float val) {
-            if (rng[0] > val)
-                rng[0] = val;
-            if (rng[1] < val)
-                rng[1] = val;
-        };
+        for (auto p = beg; p < end;) {
+            auto lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!lineEnd)
+                lineEnd = end;
 
-        std::unordered_set<float> hSets, latSets, lonSets;
-        std::string buf;
-        std::getline(is, buf); // 跳过第一行
-        while (std::getline(is, buf)) {
             std::array<float, 5> f5;
-
-            auto validRead =
-                sscanf(buf.c_str(), "%f%f%f%f%f", &f5[0], &f5[1], &f5[2], &f5[3], &f5[4]);
+            int validRead = 0;
+            for (; validRead < 5; ++validRead) {
+                while (p != lineEnd && TXTParser::IsSpace(*p))
+                    ++p;
+                if (!TXTParser::ParseFloat(p, lineEnd, f5[validRead]))
+                    break;
+            }
+            p = lineEnd + 1;
             if (validRead < 4)
                 continue;
 
-            hSets.emplace(f5[1]);
-            latSets.emplace(f5[2]);
-            lonSets.emplace(f5[3]);
-
-            computeMinMax(ret.hRng, f5[1]);
-            computeMinMax(ret.latRng, f5[2]);
-            computeMinMax(ret.lonRng, f5[3]);
-            if (validRead == 5)
-                computeMinMax(ret.valRng, f5[4]);
-            else
+            for (int i = 0; i < 3; ++i) {
+                auto coord = f5[i + 1];
+                if (!hasLastCoords[i] || lastCoords[i] != coord) {
+                    chunk.coordSets[i].emplace(coord);
+                    lastCoords[i] = coord;
+                    hasLastCoords[i] = true;
+                }
+            }
+            for (int i = 0; i < 4; ++i) {
+                if (i == 0 && validRead < 5)
+                    continue;
+                auto &rng = chunk.rngs[i];
+                auto val = i == 0 ? f5[4] : f5[i];
+                rng[0] = std::min(rng[0], val);
+                rng[1] = std::max(rng[1], val);
+            }
+            if (validRead < 5)
                 f5[4] = std::numeric_limits<float>::quiet_NaN();
 
-            ret.dat.emplace_back(f5[4]);
+            chunk.dat.emplace_back(f5[4]);
+            chunk.coords.push_back({f5[3], f5[2], f5[1]});
+        }
+    }
+
+    /*
+     * 函数: parse
+     * 功能: 跳过表头后按行边界将映射的文本切分为若干块并行解析，
+     *       各块结果按块顺序拼接，数据顺序与逐行读取一致。坐标仅在非稠密时保留
+     */
+    static LabeledTXTVolume parse(const MappedFile &mapped) {
+        LabeledTXTVolume ret;
+        auto fileBeg = reinterpret_cast<const char *>(mapped.GetData());
+        auto fileEnd = fileBeg + mapped.GetSize();
+        auto datBeg = static_cast<const char *>(std::memchr(fileBeg, '\n', fileEnd - fileBeg));
+        if (!datBeg)
+            return ret;
+        ++datBeg;
+
+        // 块数取线程数的数倍以均衡负载，每块不小于 1 MB
+        auto chunkNum = static_cast<uint32_t>(std::max<size_t>(
+            1, std::min<size_t>(4 * ThreadPool::Global().GetThreadNumber(),
+                                (fileEnd - datBeg) / (1 << 20))));
+        std::vector<const char *> chunkBegs(chunkNum + 1);
+        chunkBegs[0] = datBeg;
+        chunkBegs[chunkNum] = fileEnd;
+        for (uint32_t c = 1; c < chunkNum; ++c) {
+            auto p = std::max(chunkBegs[c - 1], datBeg + (fileEnd - datBeg) * c / chunkNum);
+            auto lineEnd = static_cast<const char *>(std::memchr(p, '\n', fileEnd - p));
+            chunkBegs[c] = lineEnd ? lineEnd + 1 : fileEnd;
         }
 
-        ret.dim[2] = hSets.size();
-        ret.dim[1] = latSets.size();
-        ret.dim[0] = lonSets.size();
+        std::vector<ParsedChunk> chunks(chunkNum);
+        ThreadPool::Global().ParallelFor(0, chunkNum, [&](uint32_t c) {
+            parseChunk(chunkBegs[c], chunkBegs[c + 1], chunks[c]);
+        });
+
+        std::vector<size_t> offsets(chunkNum + 1, 0);
+        for (uint32_t c = 0; c < chunkNum; ++c)
+            offsets[c + 1] = offsets[c] + chunks[c].dat.size();
+        ret.dat.resize(offsets[chunkNum]);
+        ThreadPool::Global().ParallelFor(0, chunkNum, [&](uint32_t c) {
+            if (!chunks[c].dat.empty())
+                std::memcpy(ret.dat.data() + offsets[c], chunks[c].dat.data(),
+                            sizeof(float) * chunks[c].dat.size());
+            std::vector<float>().swap(chunks[c].dat);
+        });
+
+        std::array<std::array<float, 2> *, 4> rngs = {&ret.valRng, &ret.hRng, &ret.latRng,
+                                                      &ret.lonRng};
+        for (auto &chunk : chunks)
+            for (int i = 0; i < 4; ++i) {
+                (*rngs[i])[0] = std::min((*rngs[i])[0], chunk.rngs[i][0]);
+                (*rngs[i])[1] = std::max((*rngs[i])[1], chunk.rngs[i][1]);
+            }
+        // 以最大的集合为基础合并，减少插入次数
+        for (int i = 0; i < 3; ++i) {
+            auto &base = std::max_element(chunks.begin(), chunks.end(),
+                                          [&](const ParsedChunk &a, const ParsedChunk &b) {
+                                              return a.coordSets[i].size() <
+                                                     b.coordSets[i].size();
+                                          })
+                             ->coordSets[i];
+            for (auto &chunk : chunks)
+                if (&chunk.coordSets[i] != &base)
+                    base.insert(chunk.coordSets[i].begin(), chunk.coordSets[i].end());
+            ret.dim[2 - i] = static_cast<uint32_t>(base.size());
+        }
         ret.isDense = ret.dat.size() == static_cast<size_t>(ret.dim[2]) * ret.dim[1] * ret.dim[0];
 
+        if (!ret.isDense) {
+            ret.coords.resize(ret.dat.size());
+            ThreadPool::Global().ParallelFor(0, chunkNum, [&](uint32_t c) {
+                if (!chunks[c].coords.empty())
+                    std::memcpy(ret.coords.data() + offsets[c], chunks[c].coords.data(),
+                                sizeof(ret.coords[0]) * chunks[c].coords.size());
+            });
+        }
+
         return ret;
     }
 
-  private:
-    LabeledTXTVolume() {
-        dim[0] = dim[1] = dim[2] = 0;
-        valRng[0] = lonRng[0] = latRng[0] = hRng[0] = std::numeric_limits<float>::max();
-        valRng[1] = lonRng[1] = latRng[1] = hRng[1] = std::numeric_limits<float>::min();
+    /*
+     * 函数: loadSidecar
+     * 功能: 映射旁路缓存，与源文件 src 相符时读出，否则返回 false
+     */
+    bool loadSidecar(const std::string &sidecarPath, const MappedFile &src) {
+        auto mapped = MappedFile::Open(sidecarPath, MappedFile::EAccessHint::Sequential);
+        if (!mapped || mapped->GetSize() < sizeof(SidecarHeader))
+            return false;
+
+        SidecarHeader header;
+        std::memcpy(&header, mapped->GetData(), sizeof(header));
+        if (std::memcmp(header.magic, sidecarMagic(), sizeof(header.magic)) != 0 ||
+            header.version != SidecarVersion || header.srcSize != src.GetSize() ||
+            header.srcModifiedTime != src.GetModifiedTime() ||
+            mapped->GetSize() - sizeof(header) !=
+                (header.isDense != 0 ? 1 : 4) * sizeof(float) * header.valNum)
+            return false;
+
+        isDense = header.isDense != 0;
+        for (int i = 0; i < 3; ++i)
+            dim[i] = header.dim[i];
+        for (int i = 0; i < 2; ++i) {
+            valRng[i] = header.valRng[i];
+            lonRng[i] = header.lonRng[i];
+            latRng[i] = header.latRng[i];
+            hRng[i] = header.hRng[i];
+        }
+        dat.resize(header.valNum);
+        std::memcpy(dat.data(), mapped->GetData() + sizeof(header), sizeof(float) * dat.size());
+        if (!isDense) {
+            coords.resize(header.valNum);
+            std::memcpy(coords.data(),
+                        mapped->GetData() + sizeof(header) + sizeof(float) * dat.size(),
+                        sizeof(coords[0]) * coords.size());
+        }
+        return true;
+    }
+    void writeSidecar(const std::string &sidecarPath, const MappedFile &src) const {
+        SidecarHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, sidecarMagic(), sizeof(header.magic));
+        header.version = SidecarVersion;
+        header.isDense = isDense ? 1 : 0;
+        header.srcSize = src.GetSize();
+        header.srcModifiedTime = src.GetModifiedTime();
+        header.valNum = dat.size();
+        for (int i = 0; i < 3; ++i)
+            header.dim[i] = dim[i];
+        for (int i = 0; i < 2; ++i) {
+            header.valRng[i] = valRng[i];
+            header.lonRng[i] = lonRng[i];
+            header.latRng[i] = latRng[i];
+            header.hRng[i] = hRng[i];
+        }
+
+        std::ofstream os(sidecarPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os.is_open())
+            return;
+        os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char *>(dat.data()), sizeof(float) * dat.size());
+        if (!isDense)
+            os.write(reinterpret_cast<const char *>(coords.data()),
+                     sizeof(coords[0]) * coords.size());
+        if (!os.good()) {
+            os.close();
+            std::remove(sidecarPath.c_str()); // 不完整的缓存会因大小不符被拒绝，仍及时删除
+        }
     }
 };
 } // namespace Loader
@@ -259,9 +741,11 @@ namespace Convertor {
 class RAWVolume {
   public:
     static std::vector<float> U8ToNormalizedFloat(const std::vector<uint8_t> &u8Dat) {
-        std::vector<float> dat(u8Dat.size());
-        size_t i = 0;
-        for (size_t i = 0; i < u8Dat.size(); ++i)
+        return U8ToNormalizedFloat(u8Dat.data(), u8Dat.size());
+    }
+    static std::vector<float> U8ToNormalizedFloat(const uint8_t *u8Dat, size_t voxNum) {
+        std::vector<float> dat(voxNum);
+        for (size_t i = 0; i < voxNum; ++i)
             dat[i] = u8Dat[i] / 255.f;
         return dat;
     }
@@ -273,6 +757,39 @@ class RAWVolume {
             dat[i] = fDat[i] * 255.f;
         return dat;
     }
+    /*
+     * 函数: LabeledTXTToRAWVolume
+     * 功能: 将稠密的带标签 TXT 体数据归一化后直接作为 Float32 体数据，
+     *       接管其数组，不量化为 UInt8，也不复制
+     */
+    static ReteurnOrError<RAWVolumeData> LabeledTXTToRAWVolume(Loader::LabeledTXTVolume &&vol) {
+        if (!vol.isDense)
+            return "Invalid vol, which is not dense.";
+
+        vol.Normalize();
+        return RAWVolumeData::CreateFromVoxels(vol.dim, std::move(vol.dat));
+    }
+    /*
+     * 函数: ScatteredLabeledTXTToRAWVolume
+     * 功能: 将非稠密的带标签 TXT 体数据插值到 param.voxPerVol 的规则网格，
+     *       输出归一化的 Float32 体数据。param 未给定的经纬高范围取 vol 的范围
+     */
+    static ReteurnOrError<RAWVolumeData>
+    ScatteredLabeledTXTToRAWVolume(const Loader::LabeledTXTVolume &vol,
+                                   ScatteredGridder::Parameters param,
+                                   ScatteredGridder::Statistics *stats = nullptr) {
+        if (vol.isDense)
+            return "Invalid vol, which is dense.";
+
+        std::array<std::array<float, 2> *, 3> paramRngs = {&param.lonRng, &param.latRng,
+                                                           &param.hRng};
+        std::array<const std::array<float, 2> *, 3> volRngs = {&vol.lonRng, &vol.latRng,
+                                                               &vol.hRng};
+        for (int a = 0; a < 3; ++a)
+            if ((*paramRngs[a])[1] <= (*paramRngs[a])[0])
+                *paramRngs[a] = *volRngs[a];
+        return ScatteredGridder::Grid(vol.coords, vol.dat, param, stats);
+    }
     static std::vector<float> RoughFloatToSmooth(const std::vector<float> &fDat,
                                                  const std::array<uint32_t, 3> &dim) {
         std::vector<float> smoothed(fDat.size());
@@ -0,0 +1,126 @@
+#ifndef VIS4EARTH_LRU_CACHE_H
+#define VIS4EARTH_LRU_CACHE_H
+
+#include <mutex>
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <QDebug>
+
+namespace VIS4Earth {
+
+/*
+ * 类: LRUCache
+ * 功能: 线程安全的键值缓存，总字节数超出预算时按最近最少使用（LRU）的顺序淘汰
+ * 模板参数:
+ * -- K: 键，需可用 std::less 比较
+ * -- E: 缓存项，按值存取，宜为持有共享数据的轻量类型
+ * -- ByteSizeOf: 函数对象，返回缓存项占用的字节数，插入时计算一次
+ */
+template <typename K, typename E, typename ByteSizeOf> class LRUCache {
+  public:
+    using Key = K;
+    using Entry = E;
+
+    explicit LRUCache(size_t byteBudget) : byteBudget(byteBudget) {}
+
+    size_t GetByteBudget() const { return byteBudget; }
+    void SetByteBudget(size_t byteBudget) {
+        std::lock_guard<std::mutex> lk(mtx);
+        this->byteBudget = byteBudget;
+        evict();
+    }
+    size_t GetByteSize() const { return byteSize; }
+    size_t GetEntryNumber() const { return key2Entries.size(); }
+
+    /*
+     * 函数: Find
+     * 功能: 查找缓存项，命中时将其移到 LRU 链表头部并写入 entry
+     */
+    bool Find(const Key &key, Entry &entry) {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto itr = key2Entries.find(key);
+        if (itr == key2Entries.end()) {
+            ++missNum;
+            return false;
+        }
+
+        ++hitNum;
+        lru.splice(lru.begin(), lru, itr->second);
+        entry = itr->second->entry;
+        return true;
+    }
+
+    /*
+     * 函数: Insert
+     * 功能: 插入（或替换）缓存项并按预算淘汰。刚插入的项不会被淘汰，
+     *       因此单个超出预算的缓存项仍可使用
+     */
+    void Insert(const Key &key, const Entry &entry) {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto itr = key2Entries.find(key);
+        if (itr != key2Entries.end())
+            erase(itr);
+
+        lru.push_front(Node{key, entry, ByteSizeOf()(entry)});
+        key2Entries.emplace(key, lru.begin());
+        byteSize += lru.front().byteSize;
+        evict();
+    }
+
+    /*
+     * 函数: EraseIf
+     * 功能: 移除键满足 pred 的全部缓存项
+     */
+    template <typename Pred> void EraseIf(Pred pred) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (auto itr = key2Entries.begin(); itr != key2Entries.end();)
+            if (pred(itr->first))
+                itr = erase(itr);
+            else
+                ++itr;
+    }
+
+    void LogStatistics(const char *name) const {
+        qDebug() << (std::string(name) + ":").c_str() << key2Entries.size() << "entries,"
+                 << byteSize << "/" << byteBudget << "bytes," << hitNum << "hits," << missNum
+                 << "misses," << evictNum << "evictions";
+    }
+
+  private:
+    struct Node {
+        Key key;
+        Entry entry;
+        size_t byteSize;
+    };
+    using NodeIterator = typename std::list<Node>::iterator;
+    using MapIterator = typename std::map<Key, NodeIterator>::iterator;
+
+    size_t byteBudget;
+    size_t byteSize = 0;
+    size_t hitNum = 0;
+    size_t missNum = 0;
+    size_t evictNum = 0;
+    std::mutex mtx;
+    std::list<Node> lru;
+    std::map<Key, NodeIterator> key2Entries;
+
+    MapIterator erase(MapIterator itr) {
+        byteSize -= itr->second->byteSize;
+        lru.erase(itr->second);
+        return key2Entries.erase(itr);
+    }
+
+    void evict() {
+        while (byteSize > byteBudget && lru.size() > 1) {
+            erase(key2Entries.find(lru.back().key));
+            ++evictNum;
+        }
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_LRU_CACHE_H
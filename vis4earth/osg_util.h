@@ -1,6 +1,8 @@
 ﻿#ifndef VIS4EARTH_OSG_H
 #define VIS4EARTH_OSG_H
 
+#include <functional>
+
 #include <osg/PositionAttitudeTransform>
 #include <osg/ShapeDrawable>
 #include <osg/Texture2D>
@@ -65,6 +67,24 @@ class EyePositionUpdateCallback : public osg::NodeCallback {
     }
 };
 
+/*
+ * 类: FrameUpdateCallback
+ * 功能: 在每帧的更新遍历中以该帧的仿真时间（秒）调用 func，用于按帧时钟驱动动画
+ */
+class FrameUpdateCallback : public osg::NodeCallback {
+  private:
+    std::function<void(double)> func;
+
+  public:
+    FrameUpdateCallback(std::function<void(double)> func) : func(func) {}
+    virtual void operator()(osg::Node *node, osg::NodeVisitor *nv) {
+        if (auto frameStamp = nv->getFrameStamp())
+            func(frameStamp->getSimulationTime());
+
+        traverse(node, nv);
+    }
+};
+
 } // namespace VIS4Earth
 
 #endif // !VIS4EARTH_OSG_H
@@ -0,0 +1,259 @@
+#ifndef VIS4EARTH_PROGRESSIVE_RENDER_H
+#define VIS4EARTH_PROGRESSIVE_RENDER_H
+
+#include <algorithm>
+#include <mutex>
+
+#include <vector>
+
+#include <osg/BlendFunc>
+#include <osg/Camera>
+#include <osg/Depth>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/Program>
+#include <osg/Texture2D>
+
+#include <osgUtil/CullVisitor>
+
+#include <vis4earth/util.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: ProgressiveRenderGroup
+ * 功能: 渐进绘制唯一的子节点。相机或所关注的 uniform 变化时，以降低的分辨率绘制到离屏纹理，
+ *       同时将 stepScale 置为 InteractiveStepScale 以减少采样，再放大叠加到画面；
+ *       变化停止后每帧将分辨率提高一倍，直至按原分辨率直接绘制子节点。
+ *       交互时的降采样倍数按帧时间预算在 MinDownsample 与 MaxDownsample 间调整。
+ *       子节点的着色器需输出预乘不透明度的完整颜色，离屏绘制时关闭混合，
+ *       放大叠加时按 (ONE, ONE_MINUS_SRC_ALPHA) 混合，并以离屏绘制的深度与场景做深度测试
+ */
+class ProgressiveRenderGroup : public osg::Group {
+  public:
+    static uint32_t MinDownsample() { return 2; }
+    static uint32_t MaxDownsample() { return 8; }
+    static float InteractiveStepScale() { return 2.f; }
+
+    struct Statistics {
+        uint32_t downsample;       // 当前帧的降采样倍数，1 表示直接绘制
+        uint32_t interactiveDownsample;
+        double interactiveFrameMS; // 交互（最低分辨率）时的平均帧间隔
+        double fullFrameMS;        // 直接绘制时的平均帧间隔
+    };
+
+    ProgressiveRenderGroup(osg::ref_ptr<osg::Node> content, osg::ref_ptr<osg::Uniform> stepScale)
+        : stepScale(stepScale) {
+        addChild(content);
+        // 在 cull 遍历时修改
+        stepScale->setDataVariance(osg::Object::DYNAMIC);
+
+        tex = new osg::Texture2D;
+        tex->setTextureSize(1, 1);
+        tex->setInternalFormat(GL_RGBA8);
+        tex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        tex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        tex->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        tex->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+
+        depthTex = new osg::Texture2D;
+        depthTex->setTextureSize(1, 1);
+        depthTex->setInternalFormat(GL_DEPTH_COMPONENT24);
+        depthTex->setSourceFormat(GL_DEPTH_COMPONENT);
+        depthTex->setSourceType(GL_FLOAT);
+        depthTex->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+        depthTex->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+        depthTex->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        depthTex->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+
+        // 继承主相机的观察与投影矩阵，仅视口缩小
+        rttCam = new osg::Camera;
+        rttCam->setReferenceFrame(osg::Transform::RELATIVE_RF);
+        rttCam->setProjectionMatrix(osg::Matrix::identity());
+        rttCam->setViewMatrix(osg::Matrix::identity());
+        rttCam->setRenderOrder(osg::Camera::PRE_RENDER);
+        rttCam->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+        rttCam->setClearColor(osg::Vec4(0.f, 0.f, 0.f, 0.f));
+        rttCam->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        rttCam->setViewport(0, 0, 1, 1);
+        rttCam->attach(osg::Camera::COLOR_BUFFER, tex.get());
+        rttCam->attach(osg::Camera::DEPTH_BUFFER, depthTex.get());
+        rttCam->getOrCreateStateSet()->setMode(GL_BLEND, osg::StateAttribute::OFF |
+                                                             osg::StateAttribute::OVERRIDE);
+        rttCam->addChild(content);
+
+        auto quad = osg::createTexturedQuadGeometry(osg::Vec3(0.f, 0.f, 0.f),
+                                                    osg::Vec3(1.f, 0.f, 0.f),
+                                                    osg::Vec3(0.f, 1.f, 0.f));
+        auto quadStateSet = quad->getOrCreateStateSet();
+        quadStateSet->setTextureAttributeAndModes(0, tex.get(), osg::StateAttribute::ON);
+        quadStateSet->setTextureAttributeAndModes(1, depthTex.get(), osg::StateAttribute::ON);
+        quadStateSet->addUniform(new osg::Uniform("colorTex", 0));
+        quadStateSet->addUniform(new osg::Uniform("depthTex", 1));
+        {
+            osg::ref_ptr<osg::Program> program = new osg::Program;
+            program->addShader(osg::Shader::readShaderFile(
+                osg::Shader::VERTEX,
+                GetDataPathPrefix() + VIS4EARTH_SHADER_PREFIX "progressive_quad_vert.glsl"));
+            program->addShader(osg::Shader::readShaderFile(
+                osg::Shader::FRAGMENT,
+                GetDataPathPrefix() + VIS4EARTH_SHADER_PREFIX "progressive_quad_frag.glsl"));
+            quadStateSet->setAttributeAndModes(program, osg::StateAttribute::ON);
+        }
+        quadStateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        // 只做深度测试，不写深度，场景的深度缓冲保持不变
+        quadStateSet->setAttributeAndModes(new osg::Depth(osg::Depth::LEQUAL, 0., 1., false),
+                                           osg::StateAttribute::ON);
+        quadStateSet->setAttributeAndModes(
+            new osg::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+        osg::ref_ptr<osg::Geode> quadGeode = new osg::Geode;
+        quadGeode->addDrawable(quad);
+
+        // 视口未设置时沿用主相机的视口
+        hudCam = new osg::Camera;
+        hudCam->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+        hudCam->setProjectionMatrixAsOrtho2D(0., 1., 0., 1.);
+        hudCam->setViewMatrix(osg::Matrix::identity());
+        hudCam->setRenderOrder(osg::Camera::POST_RENDER);
+        hudCam->setClearMask(0);
+        hudCam->setAllowEventFocus(false);
+        hudCam->addChild(quadGeode);
+    }
+
+    void SetEnabled(bool enabled) {
+        std::lock_guard<std::mutex> lk(mtx);
+        this->enabled = enabled;
+    }
+    void SetFrameBudget(double ms) {
+        std::lock_guard<std::mutex> lk(mtx);
+        frameBudgetMS = ms;
+    }
+    // 在 cull 遍历时比较这些 uniform 的修改计数，变化视为交互
+    void SetWatchedUniforms(const std::vector<osg::ref_ptr<osg::Uniform>> &uniforms) {
+        std::lock_guard<std::mutex> lk(mtx);
+        watchedUnis = uniforms;
+    }
+    // 通知子节点的内容（如纹理）已变化，下一帧起重新渐进绘制
+    void MarkChanged() {
+        std::lock_guard<std::mutex> lk(mtx);
+        changed = true;
+    }
+    Statistics GetStatistics() const {
+        std::lock_guard<std::mutex> lk(mtx);
+        return stats;
+    }
+
+    virtual void traverse(osg::NodeVisitor &nv) override {
+        auto cv = nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR
+                      ? dynamic_cast<osgUtil::CullVisitor *>(&nv)
+                      : nullptr;
+        if (!cv || getNumChildren() == 0) {
+            osg::Group::traverse(nv);
+            return;
+        }
+
+        auto currStats = updateState(*cv);
+        auto downsample = currStats.downsample;
+        if (downsample == 1) {
+            stepScale->set(1.f);
+            osg::Group::traverse(nv);
+            return;
+        }
+
+        auto vp = cv->getViewport();
+        auto w = std::max(1, static_cast<int>(vp->width()) / static_cast<int>(downsample));
+        auto h = std::max(1, static_cast<int>(vp->height()) / static_cast<int>(downsample));
+        if (w != tex->getTextureWidth() || h != tex->getTextureHeight()) {
+            tex->setTextureSize(w, h);
+            tex->dirtyTextureObject();
+            depthTex->setTextureSize(w, h);
+            depthTex->dirtyTextureObject();
+            rttCam->setViewport(0, 0, w, h);
+            rttCam->dirtyAttachmentMap();
+        }
+        stepScale->set(downsample == currStats.interactiveDownsample ? InteractiveStepScale()
+                                                                     : 1.f);
+
+        rttCam->accept(nv);
+        hudCam->accept(nv);
+    }
+
+  private:
+    bool enabled = true;
+    bool changed = true;
+    double frameBudgetMS = 33.;
+    uint32_t level = 0; // 交互时为 0，此后每帧递增，降采样倍数为 interactiveDownsample >> level
+    uint32_t interactiveFrameNum = 0;
+    double prevFrameTime = -1.;
+    osg::Matrix prevViewMat;
+    std::vector<osg::ref_ptr<osg::Uniform>> watchedUnis;
+    std::vector<unsigned int> prevModifiedCnts;
+    Statistics stats = {1, MinDownsample(), 0., 0.};
+    mutable std::mutex mtx;
+
+    osg::ref_ptr<osg::Uniform> stepScale;
+    osg::ref_ptr<osg::Texture2D> tex;
+    osg::ref_ptr<osg::Texture2D> depthTex;
+    osg::ref_ptr<osg::Camera> rttCam;
+    osg::ref_ptr<osg::Camera> hudCam;
+
+    /*
+     * 函数: updateState
+     * 功能: 每帧调用一次。统计上一帧的帧间隔，检测交互并返回含本帧降采样倍数的统计
+     */
+    Statistics updateState(osgUtil::CullVisitor &cv) {
+        std::lock_guard<std::mutex> lk(mtx);
+
+        // 按指数滑动平均统计上一帧所处模式的帧间隔
+        auto frameTime = cv.getFrameStamp() ? cv.getFrameStamp()->getReferenceTime() : 0.;
+        if (prevFrameTime >= 0. && frameTime > prevFrameTime) {
+            auto ms = (frameTime - prevFrameTime) * 1e3;
+            auto accumulate = [&](double &avg) { avg = avg == 0. ? ms : .9 * avg + .1 * ms; };
+            if (stats.downsample == 1)
+                accumulate(stats.fullFrameMS);
+            else if (stats.downsample == stats.interactiveDownsample)
+                accumulate(stats.interactiveFrameMS);
+
+            // 每 10 帧交互帧调整一次降采样倍数，每档的开销约相差 4 倍
+            if (stats.downsample == stats.interactiveDownsample && ++interactiveFrameNum >= 10) {
+                interactiveFrameNum = 0;
+                if (stats.interactiveFrameMS > frameBudgetMS &&
+                    stats.interactiveDownsample < MaxDownsample()) {
+                    stats.interactiveDownsample *= 2;
+                    stats.interactiveFrameMS = 0.;
+                } else if (stats.interactiveFrameMS < .2 * frameBudgetMS &&
+                           stats.interactiveDownsample > MinDownsample()) {
+                    stats.interactiveDownsample /= 2;
+                    stats.interactiveFrameMS = 0.;
+                }
+            }
+        }
+        prevFrameTime = frameTime;
+
+        auto viewMat = cv.getModelViewMatrix() ? *cv.getModelViewMatrix() : osg::Matrix();
+        changed |= viewMat != prevViewMat;
+        prevViewMat = viewMat;
+        prevModifiedCnts.resize(watchedUnis.size(), 0);
+        for (size_t i = 0; i < watchedUnis.size(); ++i) {
+            auto cnt = watchedUnis[i]->getModifiedCount();
+            changed |= cnt != prevModifiedCnts[i];
+            prevModifiedCnts[i] = cnt;
+        }
+
+        if (!enabled)
+            level = 31;
+        else if (changed)
+            level = 0;
+        else if (level < 31)
+            ++level;
+        changed = false;
+
+        stats.downsample = std::max(1u, stats.interactiveDownsample >> std::min(level, 31u));
+        return stats;
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_PROGRESSIVE_RENDER_H
@@ -3,8 +3,11 @@
 #include <ui_dvr.h>
 #include <vis4earth/components_ui_export.h>
 
+// 自适应采样时步长相对于 step 的最大倍数
+static const float MaxStepScale = 4.f;
+
 VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
-    : QtOSGReflectableWidget(ui, parent) {
+    : volCmpt(true), QtOSGReflectableWidget(ui, parent) {
     ui->scrollAreaWidgetContents_main->layout()->addWidget(&geoCmpt);
     ui->scrollAreaWidgetContents_main->layout()->addWidget(&volCmpt);
 
@@ -52,8 +55,39 @@ VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
             });
     }
 
+    // 须在加载体数据前设置，加载时为各时间步构建宏单元网格并预先计算梯度
+    // （环境光遮蔽随传输函数变化，在渲染时由保留的 CPU 数据计算）
+    volCmpt.SetMacroCellSize(8);
+    volCmpt.SetComputeGradient(true);
+    volCmpt.SetPackVolumes(ui->checkBox_usePackedVols->isChecked());
+
     initOSGResource();
 
+    {
+        // 属性变化时与相机移动一样按低分辨率绘制
+        std::vector<osg::ref_ptr<osg::Uniform>> watchedUnis;
+        for (auto obj : std::array<QtOSGReflectableWidget *, 3>{this, &geoCmpt, &volCmpt})
+            obj->ForEachProperty([&](const std::string &name, const Property &prop) {
+                watchedUnis.emplace_back(prop.GetUniform());
+            });
+        progressive->SetWatchedUniforms(watchedUnis);
+
+        auto changeProgressive = [&]() {
+            progressive->SetEnabled(ui->checkBox_useProgressive->isChecked());
+            progressive->SetFrameBudget(ui->spinBox_frameBudgetMS->value());
+        };
+        connect(ui->checkBox_useProgressive, &QCheckBox::stateChanged,
+                [=](int) { changeProgressive(); });
+        connect(ui->spinBox_frameBudgetMS, QOverload<int>::of(&QSpinBox::valueChanged),
+                [=](int) { changeProgressive(); });
+        changeProgressive();
+
+        connect(&statsTimer, &QTimer::timeout, this,
+                &DirectVolumeRenderer::updateProgressiveStats);
+        statsTimer.setInterval(200);
+        statsTimer.start();
+    }
+
 #ifdef VIS4EARTH_USE_OLD_RENDERER
     ui->spinBox_tessellationX->setEnabled(false);
     ui->spinBox_tessellationY->setEnabled(false);
@@ -79,6 +113,8 @@ VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
     onHeightChanged(0.);
 #endif
 
+    connect(&volCmpt, &VolumeComponent::GeographicsLoaded, &geoCmpt,
+            &GeographicsComponent::SetGeographics);
     connect(&volCmpt, &VolumeComponent::VolumeChanged, [&]() {
         for (int i = 0; i < 2; ++i) {
             auto timeNum = volCmpt.GetVolumeTimeNumber(i);
@@ -88,10 +124,23 @@ VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
             std::array<int, 3> voxPerVol = {volCmpt.GetVolume(i, 0)->getImage()->s(),
                                             volCmpt.GetVolume(i, 0)->getImage()->t(),
                                             volCmpt.GetVolume(i, 0)->getImage()->r()};
+            if (auto pyramid = volCmpt.GetPyramid(i))
+                for (int j = 0; j < 3; ++j)
+                    voxPerVol[j] = pyramid->GetInfo().voxPerVol[j];
             dSamplePoss[i]->set(
                 osg::Vec3(1.f / voxPerVol[0], 1.f / voxPerVol[1], 1.f / voxPerVol[2]));
         }
+
+        resetPyramidCache(false);
+        changeTimeStep();
+        updateOccupancy(true);
+        progressive->MarkChanged();
     });
+    connect(ui->spinBox_pyramidCacheMB, QOverload<int>::of(&QSpinBox::valueChanged),
+            [&](int) { resetPyramidCache(true); });
+    connect(&pyramidTimer, &QTimer::timeout, this, &DirectVolumeRenderer::updatePyramid);
+    pyramidTimer.setInterval(100);
+    pyramidTimer.start();
 
     auto changeTF = [&]() {
 #ifdef VIS4EARTH_USE_OLD_RENDERER
@@ -107,35 +156,42 @@ VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
                                               osg::StateAttribute::ON);
         stateSet->setTextureAttributeAndModes(5, volCmpt.GetTransferFunction(1),
                                               osg::StateAttribute::ON);
+        updateOccupancy(true);
+        updateAmbientOcclusion();
+        progressive->MarkChanged();
     };
     connect(&volCmpt, &VolumeComponent::TransferFunctionChanged, changeTF);
     changeTF();
 
-    auto changeVol = [&]() {
-        static uint32_t currTimeID = 0;
-
-#ifdef VIS4EARTH_USE_OLD_RENDERER
-        auto stateSet = sphere->getOrCreateStateSet();
-#else
-        auto stateSet = geode->getOrCreateStateSet();
-#endif
-        int validVolNum = 0;
-        for (int i = 0; i < 2; ++i) {
-            auto timeNum = volCmpt.GetVolumeTimeNumber(i);
-            if (timeNum == 0)
-                continue;
-
-            stateSet->setTextureAttributeAndModes(i, volCmpt.GetVolume(i, currTimeID % timeNum),
-                                                  osg::StateAttribute::ON);
-            ++validVolNum;
-        }
+    // 不使用时释放打包的纹理，两份纹理不同时占用内存
+    connect(ui->checkBox_usePackedVols, &QCheckBox::stateChanged, [&](int) {
+        volCmpt.SetPackVolumes(ui->checkBox_usePackedVols->isChecked());
+        changeTimeStep();
+    });
+    connect(ui->checkBox_useTimeInterp, &QCheckBox::stateChanged, [&](int) {
+        for (uint32_t i = 0; i < 2; ++i)
+            updateNextVolume(i);
+        updateOccupancy(false);
+    });
 
-        useMultiVols->set(validVolNum == 2);
-        ++currTimeID;
+    auto changePlayRate = [&](double rate) {
+        // 从当前游标起按新的速率推进，避免游标跳变
+        playBaseCursor = playCursor;
+        playStartTime = playFrameTime;
+        playRate = rate;
     };
-    connect(&timer, &QTimer::timeout, changeVol);
-    timer.setInterval(330);
-    timer.start();
+    connect(ui->doubleSpinBox_playRate, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            changePlayRate);
+    playRate = ui->doubleSpinBox_playRate->value();
+    playBaseCursor = playCursor = 0.;
+    playStartTime = playFrameTime = -1.;
+    playLastStep = std::numeric_limits<uint64_t>::max();
+    grp->setUpdateCallback(
+        new FrameUpdateCallback([&](double frameTime) { updatePlayback(frameTime); }));
+
+    for (auto checkBox : {ui->checkBox_useAO_bool_VIS4EarthReflectable,
+                          ui->checkBox_usePrecomputedAO_bool_VIS4EarthReflectable})
+        connect(checkBox, &QCheckBox::stateChanged, [&](int) { updateAmbientOcclusion(); });
 
     auto changeStep = [&]() {
         ui->doubleSpinBox_step_float_VIS4EarthReflectable->setMinimum(0.);
@@ -144,6 +200,8 @@ VIS4Earth::DirectVolumeRenderer::DirectVolumeRenderer(QWidget *parent)
             geoCmpt.GetUI()->doubleSpinBox_heightMax_float_VIS4EarthReflectable->value() -
             geoCmpt.GetUI()->doubleSpinBox_heightMin_float_VIS4EarthReflectable->value();
         auto heightVol = volCmpt.GetVolume(0, 0) ? volCmpt.GetVolume(0, 0)->getImage()->r() : 0;
+        if (auto pyramid = volCmpt.GetPyramid(0))
+            heightVol = pyramid->GetInfo().voxPerVol[2];
         if (heightDlt == 0. || heightVol == 0) {
             ui->doubleSpinBox_step_float_VIS4EarthReflectable->setValue(0.);
             return;
@@ -180,10 +238,40 @@ void VIS4Earth::DirectVolumeRenderer::initOSGResource() {
     dSamplePoss[0] = new osg::Uniform("dSamplePos0", osg::Vec3(1.f, 1.f, 1.f));
     dSamplePoss[1] = new osg::Uniform("dSamplePos1", osg::Vec3(1.f, 1.f, 1.f));
     useMultiVols = new osg::Uniform("useMultiVols", false);
+    usePyramid = new osg::Uniform("usePyramid", false);
+    pyramidVoxPerVol = new osg::Uniform("pyramidVoxPerVol", osg::Vec3(1.f, 1.f, 1.f));
+    pyramidBrickSize = new osg::Uniform("pyramidBrickSize", 1.f);
+    atlasVoxPerVol = new osg::Uniform("atlasVoxPerVol", osg::Vec3(1.f, 1.f, 1.f));
+    useOccupancy = new osg::Uniform("useOccupancy", false);
+    macroCellSize = new osg::Uniform("macroCellSize", 1.f);
+    maxStepScale = new osg::Uniform("maxStepScale", MaxStepScale);
+    progressiveStepScale = new osg::Uniform("progressiveStepScale", 1.f);
+    macroCellVoxPerVols[0] = new osg::Uniform("macroCellVoxPerVol0", osg::Vec3(1.f, 1.f, 1.f));
+    macroCellVoxPerVols[1] = new osg::Uniform("macroCellVoxPerVol1", osg::Vec3(1.f, 1.f, 1.f));
+    useGradientTex = new osg::Uniform("useGradientTex", false);
+    useAOTex = new osg::Uniform("useAOTex", false);
+    timeFracs[0] = new osg::Uniform("timeFrac0", 0.f);
+    timeFracs[1] = new osg::Uniform("timeFrac1", 0.f);
+    usePackedVols = new osg::Uniform("usePackedVols", false);
     stateSet->addUniform(eyePos);
     stateSet->addUniform(dSamplePoss[0]);
     stateSet->addUniform(dSamplePoss[1]);
     stateSet->addUniform(useMultiVols);
+    stateSet->addUniform(usePyramid);
+    stateSet->addUniform(pyramidVoxPerVol);
+    stateSet->addUniform(pyramidBrickSize);
+    stateSet->addUniform(atlasVoxPerVol);
+    stateSet->addUniform(useOccupancy);
+    stateSet->addUniform(macroCellSize);
+    stateSet->addUniform(maxStepScale);
+    stateSet->addUniform(progressiveStepScale);
+    stateSet->addUniform(macroCellVoxPerVols[0]);
+    stateSet->addUniform(macroCellVoxPerVols[1]);
+    stateSet->addUniform(useGradientTex);
+    stateSet->addUniform(useAOTex);
+    stateSet->addUniform(timeFracs[0]);
+    stateSet->addUniform(timeFracs[1]);
+    stateSet->addUniform(usePackedVols);
     stateSet->addUniform(geoCmpt.GetRotateMatrix());
     for (auto obj : std::array<QtOSGReflectableWidget *, 3>{this, &geoCmpt, &volCmpt})
         obj->ForEachProperty([&](const std::string &name, const Property &prop) {
@@ -229,6 +317,38 @@ void VIS4Earth::DirectVolumeRenderer::initOSGResource() {
         tfTexUni = new osg::Uniform(osg::Uniform::SAMPLER_1D, "tfTex1");
         tfTexUni->set(5);
         stateSet->addUniform(tfTexUni);
+
+        auto pyramidTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "pageTex");
+        pyramidTexUni->set(6);
+        stateSet->addUniform(pyramidTexUni);
+        pyramidTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "atlasTex");
+        pyramidTexUni->set(7);
+        stateSet->addUniform(pyramidTexUni);
+
+        auto occupancyTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "occupancyTex0");
+        occupancyTexUni->set(8);
+        stateSet->addUniform(occupancyTexUni);
+        occupancyTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "occupancyTex1");
+        occupancyTexUni->set(9);
+        stateSet->addUniform(occupancyTexUni);
+
+        auto gradTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "gradTex0");
+        gradTexUni->set(10);
+        stateSet->addUniform(gradTexUni);
+        gradTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "gradTex1");
+        gradTexUni->set(11);
+        stateSet->addUniform(gradTexUni);
+
+        auto aoTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "aoTex0");
+        aoTexUni->set(12);
+        stateSet->addUniform(aoTexUni);
+
+        volTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "nextVolTex0");
+        volTexUni->set(13);
+        stateSet->addUniform(volTexUni);
+        volTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "nextVolTex1");
+        volTexUni->set(14);
+        stateSet->addUniform(volTexUni);
     }
 
 #ifdef VIS4EARTH_USE_OLD_RENDERER
@@ -239,17 +359,20 @@ void VIS4Earth::DirectVolumeRenderer::initOSGResource() {
     stateSet->setAttributeAndModes(cf);
 
     stateSet->setAttributeAndModes(program, osg::StateAttribute::ON);
-    stateSet->setMode(GL_BLEND, osg::StateAttribute::ON);
+    // 着色器输出预乘不透明度的颜色
+    stateSet->setAttributeAndModes(new osg::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA),
+                                   osg::StateAttribute::ON);
     stateSet->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
 
 #ifdef VIS4EARTH_USE_OLD_RENDERER
     sphere->setCullCallback(new EyePositionUpdateCallback(eyePos));
-    grp->addChild(sphere);
+    progressive = new ProgressiveRenderGroup(sphere, progressiveStepScale);
 #else
     geode->setCullCallback(new EyePositionUpdateCallback(eyePos));
     geode->addChild(geom);
-    grp->addChild(geode);
+    progressive = new ProgressiveRenderGroup(geode, progressiveStepScale);
 #endif
+    grp->addChild(progressive);
 }
 
 #ifdef VIS4EARTH_USE_OLD_RENDERER
@@ -332,3 +455,341 @@ void VIS4Earth::DirectVolumeRenderer::updateGeometry() {
         new osg::DrawElementsUInt(GL_TRIANGLES, vertIndices.size(), vertIndices.data()));
 }
 #endif
+
+void VIS4Earth::DirectVolumeRenderer::updatePlayback(double frameTime) {
+    if (playStartTime < 0.)
+        playStartTime = frameTime;
+    playFrameTime = frameTime;
+    playCursor = playBaseCursor + (frameTime - playStartTime) * playRate;
+
+    // 帧间隔超过一个时间步时跳过的时间步由流式播放器计为丢帧。
+    // 流式播放的当前时间步迟到时沿用上一帧的纹理，此后每帧重新获取，就绪后立即重新绑定
+    auto currStep = static_cast<uint64_t>(playCursor);
+    auto needRebind = currStep != playLastStep;
+    for (uint32_t i = 0; !needRebind && i < 2; ++i)
+        if (volCmpt.IsPlaybackLate(i)) {
+            volCmpt.GetVolumeForPlayback(i, currStep % volCmpt.GetVolumeTimeNumber(i));
+            needRebind = !volCmpt.IsPlaybackLate(i);
+        }
+    if (needRebind) {
+        playLastStep = currStep;
+        changeTimeStep();
+    } else
+        // 流式播放时下一时间步可能在进入当前时间步之后才就绪
+        for (uint32_t i = 0; i < 2; ++i)
+            if (volCmpt.IsStreaming(i) && !boundNextVols[i])
+                updateNextVolume(i);
+
+    auto frac = static_cast<float>(playCursor - static_cast<double>(currStep));
+    for (int i = 0; i < 2; ++i)
+        timeFracs[i]->set(boundNextVols[i] ? frac : 0.f);
+}
+
+void VIS4Earth::DirectVolumeRenderer::changeTimeStep() {
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    // 两个体的时间步数相同且已打包时，纹理单元 0 绑定打包的纹理，纹理单元 1 不再使用
+    auto timeNum0 = volCmpt.GetVolumeTimeNumber(0);
+    osg::ref_ptr<osg::Texture3D> packed;
+    if (ui->checkBox_usePackedVols->isChecked() && timeNum0 != 0 &&
+        timeNum0 == volCmpt.GetVolumeTimeNumber(1))
+        packed = volCmpt.GetPackedVolume(playLastStep % timeNum0);
+    // 改为绑定打包的纹理时，释放此前绑定过的各体单独的纹理所占的显存
+    if (packed && !packedVolsBound)
+        for (uint32_t i = 0; i < 2; ++i)
+            volCmpt.ReleaseVolumeGLObjects(i);
+    packedVolsBound = packed.valid();
+    usePackedVols->set(packedVolsBound);
+
+    int validVolNum = 0;
+    QStringList playStats;
+    for (uint32_t i = 0; i < 2; ++i) {
+        auto timeNum = volCmpt.GetVolumeTimeNumber(i);
+        if (timeNum != 0) {
+            if (!packed)
+                stateSet->setTextureAttributeAndModes(
+                    i, volCmpt.GetVolumeForPlayback(i, playLastStep % timeNum),
+                    osg::StateAttribute::ON);
+            else if (i == 0)
+                stateSet->setTextureAttributeAndModes(0, packed, osg::StateAttribute::ON);
+            else
+                stateSet->removeTextureAttribute(1, osg::StateAttribute::TEXTURE);
+            ++validVolNum;
+        }
+        updateNextVolume(i);
+
+        if (volCmpt.IsStreaming(i)) {
+            auto stats = volCmpt.GetPlaybackStatistics(i);
+            playStats.append(tr("%0号: 显示%1 迟到%2 丢弃%3")
+                                 .arg(i)
+                                 .arg(stats.presentedNum)
+                                 .arg(stats.lateNum)
+                                 .arg(stats.droppedNum));
+        }
+    }
+    ui->label_playStats->setText(playStats.join('\n'));
+
+    useMultiVols->set(validVolNum == 2);
+    updateOccupancy(false);
+    updateGradient();
+    updateAmbientOcclusion();
+}
+
+void VIS4Earth::DirectVolumeRenderer::updateNextVolume(uint32_t volID) {
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    osg::ref_ptr<osg::Texture3D> next;
+    auto timeNum = volCmpt.GetVolumeTimeNumber(volID);
+    // 金字塔的砖块按视点调入，不插值。流式播放时当前时间步未就绪（沿用上一帧的纹理）也不插值，
+    // 下一时间步已由播放器预取，不另占内存
+    if (ui->checkBox_useTimeInterp->isChecked() && timeNum > 1 && !volCmpt.GetPyramid(volID)) {
+        auto currID = static_cast<uint32_t>(playLastStep % timeNum);
+        auto nextID = (currID + 1) % timeNum;
+        // 两个体已打包时纹理单元 1 为空，体 1 不绑定
+        auto curr = packedVolsBound ? volCmpt.GetPackedVolume(currID)
+                                    : volCmpt.GetVolume(volID, currID);
+        if (curr && stateSet->getTextureAttribute(volID, osg::StateAttribute::TEXTURE) == curr)
+            next = packedVolsBound ? volCmpt.GetPackedVolume(nextID)
+                                   : volCmpt.GetVolume(volID, nextID);
+    }
+    if (next == boundNextVols[volID])
+        return;
+    boundNextVols[volID] = next;
+
+    if (next)
+        stateSet->setTextureAttributeAndModes(13 + volID, next, osg::StateAttribute::ON);
+    else
+        stateSet->removeTextureAttribute(13 + volID, osg::StateAttribute::TEXTURE);
+}
+
+void VIS4Earth::DirectVolumeRenderer::resetPyramidCache(bool force) {
+    auto pyramid = volCmpt.GetPyramid(0);
+    if (!force && (pyramidCache ? pyramidCache->GetPyramid() : nullptr) == pyramid)
+        return;
+
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    pyramidCache.reset();
+    ui->label_pyramidStats->clear();
+    if (!pyramid) {
+        usePyramid->set(false);
+        stateSet->removeTextureAttribute(6, osg::StateAttribute::TEXTURE);
+        stateSet->removeTextureAttribute(7, osg::StateAttribute::TEXTURE);
+        return;
+    }
+
+    pyramidCache.reset(new PyramidBrickCache(
+        pyramid, static_cast<size_t>(ui->spinBox_pyramidCacheMB->value()) << 20));
+    auto &info = pyramid->GetInfo();
+    auto atlasDim = pyramidCache->GetAtlasVoxelPerVolume();
+    pyramidVoxPerVol->set(osg::Vec3(info.voxPerVol[0], info.voxPerVol[1], info.voxPerVol[2]));
+    pyramidBrickSize->set(static_cast<float>(info.brickSize));
+    atlasVoxPerVol->set(osg::Vec3(atlasDim[0], atlasDim[1], atlasDim[2]));
+    stateSet->setTextureAttributeAndModes(6, pyramidCache->GetPageTableTexture(),
+                                          osg::StateAttribute::ON);
+    stateSet->setTextureAttributeAndModes(7, pyramidCache->GetAtlasTexture(),
+                                          osg::StateAttribute::ON);
+
+    // 首次绘制前按当前视点调入砖块，避免以空页表绘制
+    updatePyramid();
+    usePyramid->set(true);
+}
+
+void VIS4Earth::DirectVolumeRenderer::updatePyramid() {
+    if (!pyramidCache)
+        return;
+
+    PyramidBrickCache::LODParameters param;
+    eyePos->get(param.eyePos);
+    param.lonRange = {geoCmpt.GetPropertyOSGValue<float>("longtitudeMin").val,
+                      geoCmpt.GetPropertyOSGValue<float>("longtitudeMax").val};
+    param.latRange = {geoCmpt.GetPropertyOSGValue<float>("latitudeMin").val,
+                      geoCmpt.GetPropertyOSGValue<float>("latitudeMax").val};
+    param.radiusRange = {geoCmpt.GetPropertyOSGValue<float>("heightMin").val,
+                         geoCmpt.GetPropertyOSGValue<float>("heightMax").val};
+    param.errorThreshold = static_cast<float>(ui->doubleSpinBox_lodError->value());
+    if (!pyramidCache->Update(param))
+        return;
+
+    auto stats = pyramidCache->GetStatistics();
+    ui->label_pyramidStats->setText(tr("砖块: 选中%0 驻留%1/%2 (%3 MB) 命中%4 缺失%5 淘汰%6")
+                                        .arg(stats.selectedNum)
+                                        .arg(stats.residentNum)
+                                        .arg(stats.slotNum)
+                                        .arg(stats.residentBytes >> 20)
+                                        .arg(stats.hitNum)
+                                        .arg(stats.missNum)
+                                        .arg(stats.evictNum));
+}
+
+void VIS4Earth::DirectVolumeRenderer::updateOccupancy(bool force) {
+    // 两个体已打包时按体 0 绑定的下一时间步插值
+    auto isInterpolated = [&](int volID) {
+        return boundNextVols[packedVolsBound ? 0 : volID].valid();
+    };
+    std::array<std::shared_ptr<const MacroCellGrid>, 4> macroCells;
+    for (int i = 0; i < 2; ++i) {
+        auto timeNum = volCmpt.GetVolumeTimeNumber(i);
+        if (timeNum == 0)
+            continue;
+        macroCells[i] = volCmpt.GetMacroCells(i, playLastStep % timeNum);
+        if (isInterpolated(i))
+            macroCells[2 + i] = volCmpt.GetMacroCells(i, (playLastStep + 1) % timeNum);
+    }
+    if (!force && macroCells == occupiedMacroCells)
+        return;
+    occupiedMacroCells = macroCells;
+
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    // 任一有效的体缺少宏单元网格（如流式播放的其余时间步）时不跳过
+    auto valid = true;
+    size_t occupiedNum = 0, cellNum = 0;
+    double stepScaleSum = 0.;
+    for (int i = 0; i < 2; ++i) {
+        if (!macroCells[i]) {
+            valid &= volCmpt.GetVolumeTimeNumber(i) == 0;
+            stateSet->removeTextureAttribute(8 + i, osg::StateAttribute::TEXTURE);
+            continue;
+        }
+
+        // 插值时取两个时间步的取值范围的外包，下一时间步缺少网格时不跳过
+        auto grid = macroCells[i];
+        if (isInterpolated(i)) {
+            auto merged = macroCells[2 + i] ? grid->GetMerged(*macroCells[2 + i])
+                                            : ReteurnOrError<MacroCellGrid>("Missing macro cells.");
+            if (!merged.ok) {
+                valid = false;
+                stateSet->removeTextureAttribute(8 + i, osg::StateAttribute::TEXTURE);
+                continue;
+            }
+            grid = std::make_shared<const MacroCellGrid>(std::move(merged.result.dat));
+        }
+
+        auto &tf = volCmpt.GetTransferFunctionCPU(i);
+        auto occupancy = grid->ComputeOccupancy(tf);
+        auto stepScales = grid->ComputeStepScales(tf, MaxStepScale);
+        for (size_t ci = 0; ci < occupancy.size(); ++ci) {
+            if (occupancy[ci] == 0)
+                continue;
+            // 非空单元存放步长倍数除以最大倍数，不小于 1 / 255 以区别于空单元
+            occupancy[ci] = static_cast<uint8_t>(
+                std::max(1.f, std::round(255.f * stepScales[ci] / MaxStepScale)));
+            ++occupiedNum;
+            stepScaleSum += stepScales[ci];
+        }
+        cellNum += occupancy.size();
+        stateSet->setTextureAttributeAndModes(8 + i, grid->ToOccupancyTexture(occupancy),
+                                              osg::StateAttribute::ON);
+
+        auto &voxPerVol = grid->GetVoxelPerVolume();
+        macroCellVoxPerVols[i]->set(osg::Vec3(voxPerVol[0], voxPerVol[1], voxPerVol[2]));
+        macroCellSize->set(static_cast<float>(grid->GetCellSize()));
+    }
+    valid &= cellNum != 0;
+    useOccupancy->set(valid);
+
+    if (valid)
+        ui->label_emptySpaceStats->setText(
+            tr("宏单元: 非空%0/%1 (%2%)，非空单元平均步长%3倍")
+                .arg(occupiedNum)
+                .arg(cellNum)
+                .arg(100. * occupiedNum / cellNum, 0, 'f', 1)
+                .arg(occupiedNum == 0 ? 1. : stepScaleSum / occupiedNum, 0, 'f', 2));
+    else
+        ui->label_emptySpaceStats->clear();
+}
+
+void VIS4Earth::DirectVolumeRenderer::updateGradient() {
+    std::array<osg::ref_ptr<osg::Texture3D>, 2> gradients;
+    auto valid = true;
+    for (int i = 0; i < 2; ++i) {
+        auto timeNum = volCmpt.GetVolumeTimeNumber(i);
+        if (timeNum == 0)
+            continue;
+        // 金字塔的砖块按视点调入，没有整体的梯度纹理
+        if (!volCmpt.GetPyramid(i))
+            gradients[i] = volCmpt.GetGradient(i, playLastStep % timeNum);
+        valid &= gradients[i].valid();
+    }
+    valid &= gradients[0].valid() || gradients[1].valid();
+    useGradientTex->set(valid);
+    if (gradients == boundGradients)
+        return;
+    boundGradients = gradients;
+
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    size_t byteSize = 0;
+    for (int i = 0; i < 2; ++i)
+        if (gradients[i]) {
+            stateSet->setTextureAttributeAndModes(10 + i, gradients[i], osg::StateAttribute::ON);
+            byteSize += gradients[i]->getImage()->getTotalSizeInBytes();
+        } else
+            stateSet->removeTextureAttribute(10 + i, osg::StateAttribute::TEXTURE);
+
+    // 体数据读取按每个体、每个着色采样计，梯度纹理读取 1 次代替中心差分的 6 次
+    if (valid)
+        ui->label_gradientStats->setText(tr("梯度纹理: %0 MB，每个着色采样省去 5 次体数据读取")
+                                             .arg(byteSize / (1024. * 1024.), 0, 'f', 1));
+    else
+        ui->label_gradientStats->clear();
+}
+
+void VIS4Earth::DirectVolumeRenderer::updateProgressiveStats() {
+    auto stats = progressive->GetStatistics();
+    ui->label_progressiveStats->setText(
+        tr("当前分辨率 1/%0，交互时 1/%1 帧间隔 %2 ms，完整绘制帧间隔 %3 ms")
+            .arg(stats.downsample)
+            .arg(stats.interactiveDownsample)
+            .arg(stats.interactiveFrameMS, 0, 'f', 1)
+            .arg(stats.fullFrameMS, 0, 'f', 1));
+}
+
+void VIS4Earth::DirectVolumeRenderer::updateAmbientOcclusion() {
+    osg::ref_ptr<osg::Texture3D> ao;
+    AmbientOcclusionVolume::Statistics stats = {0, 0, 0.};
+    auto timeNum = volCmpt.GetVolumeTimeNumber(0);
+    // 金字塔的砖块按视点调入，没有整体的遮蔽纹理
+    if (timeNum != 0 && !volCmpt.GetPyramid(0) &&
+        ui->checkBox_useAO_bool_VIS4EarthReflectable->isChecked() &&
+        ui->checkBox_usePrecomputedAO_bool_VIS4EarthReflectable->isChecked())
+        ao = volCmpt.GetAmbientOcclusion(0, playLastStep % timeNum, &stats);
+    useAOTex->set(ao.valid());
+
+    if (stats.cellNum != 0)
+        ui->label_aoStats->setText(tr("遮蔽: 更新%0/%1个单元，用时 %2 ms")
+                                       .arg(stats.updatedCellNum)
+                                       .arg(stats.cellNum)
+                                       .arg(stats.milliseconds, 0, 'f', 1));
+    else if (!ao)
+        ui->label_aoStats->clear();
+    if (ao == boundAO)
+        return;
+    boundAO = ao;
+
+#ifdef VIS4EARTH_USE_OLD_RENDERER
+    auto stateSet = sphere->getOrCreateStateSet();
+#else
+    auto stateSet = geode->getOrCreateStateSet();
+#endif
+    if (ao)
+        stateSet->setTextureAttributeAndModes(12, ao, osg::StateAttribute::ON);
+    else
+        stateSet->removeTextureAttribute(12, osg::StateAttribute::TEXTURE);
+}
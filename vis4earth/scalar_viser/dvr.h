@@ -1,8 +1,11 @@
 ﻿#ifndef VIS4EARTH_SCALAR_VISER_DVR_H
 #define VIS4EARTH_SCALAR_VISER_DVR_H
 
+#include <memory>
+
 #include <QtCore/QTimer>
 
+#include <osg/BlendFunc>
 #include <osg/CoordinateSystemNode>
 #include <osg/CullFace>
 #include <osg/Group>
@@ -10,6 +13,7 @@
 
 #include <vis4earth/geographics_cmpt.h>
 #include <vis4earth/osg_util.h>
+#include <vis4earth/progressive_render.h>
 #include <vis4earth/qt_osg_reflectable.h>
 #include <vis4earth/volume_cmpt.h>
 
@@ -38,18 +42,109 @@ class DirectVolumeRenderer : public QtOSGReflectableWidget {
 //    osg::ref_ptr<osg::Uniform> MVP;
 #endif
     osg::ref_ptr<osg::Program> program;
+    // 包含上面的绘制节点，交互时以低分辨率绘制
+    osg::ref_ptr<ProgressiveRenderGroup> progressive;
 
     osg::ref_ptr<osg::Uniform> eyePos;
     std::array<osg::ref_ptr<osg::Uniform>, 2> dSamplePoss;
     osg::ref_ptr<osg::Uniform> useMultiVols;
+    osg::ref_ptr<osg::Uniform> usePyramid;
+    osg::ref_ptr<osg::Uniform> pyramidVoxPerVol;
+    osg::ref_ptr<osg::Uniform> pyramidBrickSize;
+    osg::ref_ptr<osg::Uniform> atlasVoxPerVol;
+    osg::ref_ptr<osg::Uniform> useOccupancy;
+    osg::ref_ptr<osg::Uniform> macroCellSize;
+    osg::ref_ptr<osg::Uniform> maxStepScale;
+    osg::ref_ptr<osg::Uniform> progressiveStepScale;
+    std::array<osg::ref_ptr<osg::Uniform>, 2> macroCellVoxPerVols;
+    osg::ref_ptr<osg::Uniform> useGradientTex;
+    osg::ref_ptr<osg::Uniform> useAOTex;
+    std::array<osg::ref_ptr<osg::Uniform>, 2> timeFracs;
+    osg::ref_ptr<osg::Uniform> usePackedVols;
 
     Ui::DirectVolumeRenderer *ui;
-    QTimer timer;
+    // 播放时间游标（以时间步为单位）= playBaseCursor + (帧时间 - playStartTime) * playRate，
+    // 由每帧的更新遍历推进。整数部分为当前时间步，小数部分为与下一时间步插值的权重
+    double playRate;
+    double playBaseCursor;
+    double playStartTime; // 小于 0 表示尚未收到帧时间
+    double playFrameTime;
+    double playCursor;
+    uint64_t playLastStep;
+    // 体 0 由体数据金字塔加载时，按视点调度其砖块
+    std::unique_ptr<PyramidBrickCache> pyramidCache;
+    QTimer pyramidTimer;
+    QTimer statsTimer;
+    // 当前占据纹理所对应的宏单元网格，后两个为插值时下一时间步的网格
+    std::array<std::shared_ptr<const MacroCellGrid>, 4> occupiedMacroCells;
+    // 当前绑定的梯度纹理
+    std::array<osg::ref_ptr<osg::Texture3D>, 2> boundGradients;
+    // 当前绑定的环境光遮蔽纹理，仅体 0 使用
+    osg::ref_ptr<osg::Texture3D> boundAO;
+    // 当前绑定的下一时间步的纹理，为空时不插值
+    std::array<osg::ref_ptr<osg::Texture3D>, 2> boundNextVols;
+    // 为真时纹理单元 0 绑定两个体打包成的纹理，插值时其下一时间步存于 boundNextVols[0]
+    bool packedVolsBound = false;
     GeographicsComponent geoCmpt;
     VolumeComponent volCmpt;
 
     void initOSGResource();
 
+    /*
+     * 函数: updatePlayback
+     * 功能: 每帧调用，按帧时间推进播放时间游标并更新插值权重，
+     *       进入新的时间步时绑定当前与下一时间步的纹理
+     * 参数:
+     * -- frameTime: 帧的仿真时间（秒）
+     */
+    void updatePlayback(double frameTime);
+
+    /*
+     * 函数: changeTimeStep
+     * 功能: 绑定 playLastStep 与其下一时间步的纹理，并更新与时间步相关的加速结构。
+     *       两个体已打包时绑定打包的纹理，每个采样点一次纹理读取即可得到两个体的值
+     */
+    void changeTimeStep();
+
+    /*
+     * 函数: updateNextVolume
+     * 功能: 启用插值且当前时间步已绑定时，绑定第 volID 个体下一时间步的纹理，否则解除绑定。
+     *       两个体已打包时由体 0 绑定下一时间步打包的纹理
+     */
+    void updateNextVolume(uint32_t volID);
+
+    void resetPyramidCache(bool force);
+
+    void updatePyramid();
+
+    /*
+     * 函数: updateOccupancy
+     * 功能: 按当前时间步的宏单元网格与传输函数更新占据纹理，
+     *       用于跳过空区域，非空单元同时存放自适应采样的步长倍数
+     * 参数:
+     * -- force: 为 false 时，仅在宏单元网格变化时更新
+     */
+    void updateOccupancy(bool force);
+
+    /*
+     * 函数: updateGradient
+     * 功能: 绑定当前时间步的预计算梯度纹理，任一有效的体缺少梯度纹理时着色器退回中心差分
+     */
+    void updateGradient();
+
+    /*
+     * 函数: updateAmbientOcclusion
+     * 功能: 按当前时间步与传输函数绑定体 0 的预计算环境光遮蔽纹理，
+     *       未启用遮蔽或预计算遮蔽时不计算，无法计算时着色器退回逐像素求遮蔽
+     */
+    void updateAmbientOcclusion();
+
+    /*
+     * 函数: updateProgressiveStats
+     * 功能: 显示渐进绘制当前的降采样倍数与交互、完整绘制时的平均帧间隔
+     */
+    void updateProgressiveStats();
+
 #ifdef VIS4EARTH_USE_OLD_RENDERER
 #else
   public:
@@ -0,0 +1,473 @@
+#ifndef VIS4EARTH_SCALAR_VISER_DVR_CPU_H
+#define VIS4EARTH_SCALAR_VISER_DVR_CPU_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include <array>
+#include <vector>
+
+#include <vis4earth/data/tf_data.h>
+#include <vis4earth/data/vol_data.h>
+#include <vis4earth/thread_pool.h>
+
+namespace VIS4Earth {
+
+/*
+ * 类: CPUDirectVolumeRenderer
+ * 功能: 在 CPU 上按 dvr_frag_new.glsl 的算法对单个体进行直接体绘制，按图像分块多线程执行。
+ *       包括与经纬高壳层的求交、传输函数查找、预积分、着色与环境光遮蔽，
+ *       纹理采样按 OpenGL 的 LINEAR 与 CLAMP_TO_EDGE 规则进行。
+ *       不支持多体、切面与体数据金字塔。用于无 GPU 时生成基准图像，并作为性能基线
+ */
+class CPUDirectVolumeRenderer {
+  public:
+    using Vec3 = std::array<float, 3>;
+
+    /*
+     * 结构体: Camera
+     * 功能: 透视相机，位置均在地球空间中，fovY 为纵向视角（度）
+     */
+    struct Camera {
+        Vec3 eyePos;
+        Vec3 center;
+        Vec3 up;
+        float fovY = 30.f;
+        uint32_t width = 512;
+        uint32_t height = 512;
+    };
+    /*
+     * 结构体: Parameters
+     * 功能: 与着色器同名 uniform 含义一致，经纬度为弧度，高度为到地心的距离
+     */
+    struct Parameters {
+        float lonMin, lonMax;
+        float latMin, latMax;
+        float heightMin, heightMax;
+        float step;
+        int maxStepCnt = 100;
+        bool useTFPreInt = false;
+        bool useShading = false;
+        bool useAO = false;
+        float ka = .4f;
+        float kd = .4f;
+        float ks = .2f;
+        float shininess = 32.f;
+        Vec3 lightPos = {0.f, 0.f, 0.f};
+        uint32_t tileSize = 32;
+    };
+    /*
+     * 结构体: Image
+     * 功能: RGBA 图像，自上而下逐行存放。与写入 8 位帧缓冲的着色器输出一致，各通道截断到 [0, 1]
+     */
+    struct Image {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<std::array<float, 4>> pixels;
+    };
+    struct DiffStatistics {
+        float maxDiff;
+        float meanDiff;
+        size_t exceedNum; // 任一通道的差超过容差的像素数
+    };
+
+    static ReteurnOrError<Image> Render(const RAWVolumeData &vol, const TransferFunctionData &tf,
+                                        const Parameters &param, const Camera &cam) {
+        if (vol.GetDataSize() == 0)
+            return "Empty volume.";
+        if (cam.width == 0 || cam.height == 0)
+            return "Invalid camera size.";
+        if (param.tileSize == 0)
+            return "Invalid param.tileSize.";
+        if (param.lonMax <= param.lonMin || param.latMax <= param.latMin ||
+            param.heightMax <= param.heightMin)
+            return "Invalid volume range.";
+
+        CPUDirectVolumeRenderer renderer(vol, tf, param);
+
+        auto fwd = normalize(sub(cam.center, cam.eyePos));
+        auto right = normalize(cross(fwd, cam.up));
+        auto camUp = cross(right, fwd);
+        auto tanHalfFov = std::tan(cam.fovY * .5f * 3.14159265f / 180.f);
+        auto aspect = static_cast<float>(cam.width) / cam.height;
+
+        Image img;
+        img.width = cam.width;
+        img.height = cam.height;
+        img.pixels.assign(static_cast<size_t>(cam.width) * cam.height, {0.f, 0.f, 0.f, 0.f});
+
+        auto tileNumX = (cam.width + param.tileSize - 1) / param.tileSize;
+        auto tileNumY = (cam.height + param.tileSize - 1) / param.tileSize;
+        ThreadPool::Global().ParallelFor(0, tileNumX * tileNumY, [&](uint32_t tileID) {
+            auto xBeg = (tileID % tileNumX) * param.tileSize;
+            auto yBeg = (tileID / tileNumX) * param.tileSize;
+            auto xEnd = std::min(xBeg + param.tileSize, cam.width);
+            auto yEnd = std::min(yBeg + param.tileSize, cam.height);
+            for (auto y = yBeg; y < yEnd; ++y)
+                for (auto x = xBeg; x < xEnd; ++x) {
+                    auto px = (2.f * (x + .5f) / cam.width - 1.f) * tanHalfFov * aspect;
+                    auto py = (1.f - 2.f * (y + .5f) / cam.height) * tanHalfFov;
+                    auto d = normalize(add(fwd, add(mul(right, px), mul(camUp, py))));
+                    auto &pix = img.pixels[static_cast<size_t>(y) * cam.width + x];
+                    pix = renderer.castRay(cam.eyePos, d);
+                    for (auto &v : pix)
+                        v = std::min(std::max(v, 0.f), 1.f);
+                }
+        });
+
+        return img;
+    }
+
+    /*
+     * 函数: Diff
+     * 功能: 逐像素比较两幅图像，尺寸不同时所有像素均视为超出容差
+     */
+    static DiffStatistics Diff(const Image &a, const Image &b, float tolerance) {
+        DiffStatistics stats = {0.f, 0.f, 0};
+        if (a.width != b.width || a.height != b.height) {
+            stats.maxDiff = stats.meanDiff = 1.f;
+            stats.exceedNum = std::max(a.pixels.size(), b.pixels.size());
+            return stats;
+        }
+
+        double sum = 0.;
+        for (size_t i = 0; i < a.pixels.size(); ++i) {
+            auto pixMax = 0.f;
+            for (int c = 0; c < 4; ++c) {
+                auto diff = std::abs(a.pixels[i][c] - b.pixels[i][c]);
+                pixMax = std::max(pixMax, diff);
+                sum += diff;
+            }
+            stats.maxDiff = std::max(stats.maxDiff, pixMax);
+            if (pixMax > tolerance)
+                ++stats.exceedNum;
+        }
+        if (!a.pixels.empty())
+            stats.meanDiff = static_cast<float>(sum / (a.pixels.size() * 4));
+        return stats;
+    }
+
+    /*
+     * 函数: SavePAM
+     * 功能: 将图像按 8 位 RGBA 的 PAM 格式写入 path，返回错误信息，成功时为空。
+     *       量化带来至多 1/510 的误差，与读回的图像比较时容差应不小于此值
+     */
+    static std::string SavePAM(const Image &img, const std::string &path) {
+        auto fp = std::fopen(path.c_str(), "wb");
+        if (!fp)
+            return "Cannot open file " + path + ".";
+
+        std::fprintf(fp, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\n", img.width, img.height);
+        std::fprintf(fp, "TUPLTYPE RGB_ALPHA\nENDHDR\n");
+        std::vector<uint8_t> bytes(img.pixels.size() * 4);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            auto v = std::min(1.f, std::max(0.f, img.pixels[i / 4][i % 4]));
+            bytes[i] = static_cast<uint8_t>(std::round(v * 255.f));
+        }
+        auto written = std::fwrite(bytes.data(), 1, bytes.size(), fp);
+        std::fclose(fp);
+
+        if (written != bytes.size())
+            return "Failed to write file " + path + ".";
+        return "";
+    }
+
+    static ReteurnOrError<Image> LoadPAM(const std::string &path) {
+        auto fp = std::fopen(path.c_str(), "rb");
+        if (!fp)
+            return ("Cannot open file " + path + ".").c_str();
+
+        Image img;
+        uint32_t depth = 0, maxVal = 0;
+        char tuplType[32] = {0};
+        auto headerNum = std::fscanf(
+            fp, "P7 WIDTH %u HEIGHT %u DEPTH %u MAXVAL %u TUPLTYPE %31s ENDHDR", &img.width,
+            &img.height, &depth, &maxVal, tuplType);
+        // ENDHDR 后紧跟一个换行符
+        if (headerNum != 5 || std::fgetc(fp) != '\n' || depth != 4 || maxVal != 255 ||
+            std::string(tuplType) != "RGB_ALPHA") {
+            std::fclose(fp);
+            return ("Unsupported PAM header in " + path + ".").c_str();
+        }
+
+        std::vector<uint8_t> bytes(static_cast<size_t>(img.width) * img.height * 4);
+        auto read = std::fread(bytes.data(), 1, bytes.size(), fp);
+        std::fclose(fp);
+        if (read != bytes.size())
+            return ("Truncated PAM file " + path + ".").c_str();
+
+        img.pixels.resize(bytes.size() / 4);
+        for (size_t i = 0; i < bytes.size(); ++i)
+            img.pixels[i / 4][i % 4] = bytes[i] / 255.f;
+        return img;
+    }
+
+  private:
+    static constexpr float SkipAlpha = .95f;
+
+    Parameters param;
+    std::array<uint32_t, 3> voxPerVol;
+    Vec3 dSamplePos;
+    // 与 rotMat 的三行一致，由 GeographicsComponent 按体的中心经纬度设置
+    std::array<Vec3, 3> rotMat;
+    // 归一化到 [0, 1] 的体素值，与纹理采样的结果一致
+    std::vector<float> scalars;
+    std::array<std::array<float, 4>, 256> tfDat;
+    std::vector<std::array<float, 4>> tfPreIntDat;
+
+    CPUDirectVolumeRenderer(const RAWVolumeData &vol, const TransferFunctionData &tf,
+                            const Parameters &param)
+        : param(param), voxPerVol(vol.GetVoxelPerVolume()), tfDat(tf.GetFlatData()) {
+        for (int i = 0; i < 3; ++i)
+            dSamplePos[i] = 1.f / voxPerVol[i];
+
+        switch (vol.GetVoxelType()) {
+        case ESupportedVoxelType::UInt8:
+            normalizeVolume<uint8_t>(vol);
+            break;
+        case ESupportedVoxelType::UInt16:
+            normalizeVolume<uint16_t>(vol);
+            break;
+        case ESupportedVoxelType::Float32:
+            normalizeVolume<float>(vol);
+            break;
+        }
+        if (param.useTFPreInt)
+            tfPreIntDat = tf.GetPreIntegratedFlatData();
+
+        auto lon = .5f * (param.lonMin + param.lonMax);
+        auto lat = .5f * (param.latMin + param.latMax);
+        Vec3 dir = {-std::cos(lat) * std::cos(lon), -std::cos(lat) * std::sin(lon),
+                    -std::sin(lat)};
+        rotMat[0] = cross(Vec3{0.f, 0.f, 1.f}, dir);
+        rotMat[1] = cross(dir, rotMat[0]);
+        rotMat[2] = dir;
+    }
+
+    template <typename T> void normalizeVolume(const RAWVolumeData &vol) {
+        auto src = reinterpret_cast<const T *>(vol.GetData());
+        scalars.resize(static_cast<size_t>(voxPerVol[0]) * voxPerVol[1] * voxPerVol[2]);
+        for (size_t i = 0; i < scalars.size(); ++i)
+            scalars[i] = src[i] / VoxelTypeTraits<T>::Max();
+    }
+
+    static Vec3 add(const Vec3 &a, const Vec3 &b) {
+        return {a[0] + b[0], a[1] + b[1], a[2] + b[2]};
+    }
+    static Vec3 sub(const Vec3 &a, const Vec3 &b) {
+        return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    }
+    static Vec3 mul(const Vec3 &a, float s) { return {a[0] * s, a[1] * s, a[2] * s}; }
+    static float dot(const Vec3 &a, const Vec3 &b) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+    static Vec3 cross(const Vec3 &a, const Vec3 &b) {
+        return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    }
+    static Vec3 normalize(const Vec3 &a) {
+        auto len = std::sqrt(dot(a, a));
+        return len == 0.f ? a : mul(a, 1.f / len);
+    }
+
+    /*
+     * 函数: linearCoord
+     * 功能: 按 LINEAR 与 CLAMP_TO_EDGE 规则，返回归一化坐标 u 在 n 个纹素上的两个下标与权重
+     */
+    static void linearCoord(float u, uint32_t n, uint32_t &i0, uint32_t &i1, float &w) {
+        auto x = std::min(std::max(u * n - .5f, 0.f), static_cast<float>(n - 1));
+        i0 = static_cast<uint32_t>(x);
+        i1 = std::min(i0 + 1, n - 1);
+        w = x - i0;
+    }
+
+    float sampleVol(const Vec3 &samplePos) const {
+        std::array<uint32_t, 3> i0, i1;
+        Vec3 w;
+        for (int i = 0; i < 3; ++i)
+            linearCoord(samplePos[i], voxPerVol[i], i0[i], i1[i], w[i]);
+
+        auto voxPerVolYxX = static_cast<size_t>(voxPerVol[0]) * voxPerVol[1];
+        auto at = [&](uint32_t x, uint32_t y, uint32_t z) {
+            return scalars[z * voxPerVolYxX + static_cast<size_t>(y) * voxPerVol[0] + x];
+        };
+        auto lerp = [](float a, float b, float w) { return a + w * (b - a); };
+        auto c00 = lerp(at(i0[0], i0[1], i0[2]), at(i1[0], i0[1], i0[2]), w[0]);
+        auto c10 = lerp(at(i0[0], i1[1], i0[2]), at(i1[0], i1[1], i0[2]), w[0]);
+        auto c01 = lerp(at(i0[0], i0[1], i1[2]), at(i1[0], i0[1], i1[2]), w[0]);
+        auto c11 = lerp(at(i0[0], i1[1], i1[2]), at(i1[0], i1[1], i1[2]), w[0]);
+        return lerp(lerp(c00, c10, w[1]), lerp(c01, c11, w[1]), w[2]);
+    }
+
+    std::array<float, 4> sampleTF(float scalar) const {
+        uint32_t i0, i1;
+        float w;
+        linearCoord(scalar, 256, i0, i1, w);
+        std::array<float, 4> ret;
+        for (int c = 0; c < 4; ++c)
+            ret[c] = tfDat[i0][c] + w * (tfDat[i1][c] - tfDat[i0][c]);
+        return ret;
+    }
+
+    // 与着色器中 texture(tfTexPreInt, vec2(prevScalar, scalar)) 一致，行对应 scalar
+    std::array<float, 4> samplePreIntTF(float prevScalar, float scalar) const {
+        uint32_t c0, c1, r0, r1;
+        float wc, wr;
+        linearCoord(prevScalar, 256, c0, c1, wc);
+        linearCoord(scalar, 256, r0, r1, wr);
+        std::array<float, 4> ret;
+        for (int c = 0; c < 4; ++c) {
+            auto v0 = tfPreIntDat[r0 * 256 + c0][c] +
+                      wc * (tfPreIntDat[r0 * 256 + c1][c] - tfPreIntDat[r0 * 256 + c0][c]);
+            auto v1 = tfPreIntDat[r1 * 256 + c0][c] +
+                      wc * (tfPreIntDat[r1 * 256 + c1][c] - tfPreIntDat[r1 * 256 + c0][c]);
+            ret[c] = v0 + wr * (v1 - v0);
+        }
+        return ret;
+    }
+
+    struct Hit {
+        bool isHit;
+        float tEntry;
+        float tExit;
+    };
+    static Hit intersectSphere(const Vec3 &eyePos, const Vec3 &d, float r) {
+        Hit hit = {false, 0.f, 0.f};
+
+        auto tVert = -dot(eyePos, d);
+        auto pVert = add(eyePos, mul(d, tVert));
+
+        auto r2 = r * r;
+        auto pVert2 = dot(pVert, pVert);
+        if (pVert2 >= r2)
+            return hit;
+        auto l = std::sqrt(r2 - pVert2);
+
+        hit.isHit = true;
+        hit.tEntry = tVert - l;
+        hit.tExit = tVert + l;
+        return hit;
+    }
+
+    /*
+     * 函数: computeShading
+     * 功能: 以中心差分求法向的 Blinn-Phong 着色。着色器对零向量归一化的结果未定义，
+     *       此处法向为零时仅计环境光
+     */
+    Vec3 computeShading(const Vec3 &tfCol, const Vec3 &d, const Vec3 &pos,
+                        const Vec3 &samplePos) const {
+        Vec3 N;
+        for (int i = 0; i < 3; ++i) {
+            auto pos0 = samplePos, pos1 = samplePos;
+            pos0[i] += dSamplePos[i];
+            pos1[i] -= dSamplePos[i];
+            N[i] = sampleVol(pos0) - sampleVol(pos1);
+        }
+        N = normalize(N);
+        N = add(add(mul(rotMat[0], N[0]), mul(rotMat[1], N[1])), mul(rotMat[2], N[2]));
+        if (dot(N, d) > 0.f)
+            N = mul(N, -1.f);
+
+        auto p2l = normalize(sub(param.lightPos, pos));
+        auto hfDir = normalize(sub(p2l, d));
+
+        auto ambient = param.ka;
+        auto diffuse = param.kd * std::max(0.f, dot(N, p2l));
+        auto specular = param.ks * std::pow(std::max(0.f, dot(N, hfDir)), param.shininess);
+
+        return mul(tfCol, ambient + diffuse + specular);
+    }
+
+    float computeAO(const Vec3 &samplePos) const {
+        auto curr = sampleTF(sampleVol(samplePos))[3];
+        auto AO = 1.f;
+        for (int i = 0; i < 3; ++i)
+            for (auto sign : {1.f, -1.f}) {
+                auto pos = samplePos;
+                pos[i] += sign * dSamplePos[i];
+                AO -= sampleTF(sampleVol(pos))[3] - curr;
+            }
+        return std::min(std::max(AO, 0.f), 1.f);
+    }
+
+    std::array<float, 4> castRay(const Vec3 &eyePos, const Vec3 &d) const {
+        std::array<float, 4> color = {0.f, 0.f, 0.f, 0.f};
+        if (param.step <= .1f)
+            return color;
+
+        auto hit = intersectSphere(eyePos, d, param.heightMax);
+        if (!hit.isHit)
+            return color;
+        auto tEntry = hit.tEntry;
+        auto tExit = hit.tExit;
+        hit = intersectSphere(eyePos, d, param.heightMin);
+        if (hit.isHit)
+            tExit = hit.tEntry;
+
+        auto hDlt = param.heightMax - param.heightMin;
+        auto latDlt = param.latMax - param.latMin;
+        auto lonDlt = param.lonMax - param.lonMin;
+
+        auto tAcc = 0.f;
+        auto prevScalar = -1.f;
+        auto stepCnt = 0;
+        auto pos = add(eyePos, mul(d, tEntry));
+        auto hasFirstValid = false;
+        Vec3 firstValidSamplePos;
+        tExit -= tEntry;
+        do {
+            auto r = std::sqrt(pos[0] * pos[0] + pos[1] * pos[1]);
+            auto lat = std::atan(pos[2] / r);
+            r = std::sqrt(dot(pos, pos));
+            auto lon = std::atan2(pos[1], pos[0]);
+
+            if (lat >= param.latMin && lat <= param.latMax && lon >= param.lonMin &&
+                lon <= param.lonMax) {
+                Vec3 samplePos = {(lon - param.lonMin) / lonDlt, (lat - param.latMin) / latDlt,
+                                  (r - param.heightMin) / hDlt};
+                auto scalar = sampleVol(samplePos);
+                if (prevScalar < 0.f)
+                    prevScalar = scalar;
+                auto tfCol =
+                    param.useTFPreInt ? samplePreIntTF(prevScalar, scalar) : sampleTF(scalar);
+                prevScalar = scalar;
+
+                if (param.useShading && tfCol[3] > 0.f) {
+                    auto rgb = computeShading({tfCol[0], tfCol[1], tfCol[2]}, d, pos, samplePos);
+                    std::copy(rgb.begin(), rgb.end(), tfCol.begin());
+                }
+
+                if (tfCol[3] > 0.f) {
+                    if (!hasFirstValid) {
+                        hasFirstValid = true;
+                        firstValidSamplePos = samplePos;
+                    }
+
+                    auto w = (1.f - color[3]) * (param.useTFPreInt ? 1.f : tfCol[3]);
+                    for (int c = 0; c < 3; ++c)
+                        color[c] += w * tfCol[c];
+                    color[3] += (1.f - color[3]) * tfCol[3];
+                    if (color[3] > SkipAlpha)
+                        break;
+                }
+            }
+
+            pos = add(pos, mul(d, param.step));
+            tAcc += param.step;
+            ++stepCnt;
+        } while (tAcc < tExit && stepCnt <= param.maxStepCnt);
+
+        if (param.useAO && hasFirstValid) {
+            auto AO = computeAO(firstValidSamplePos);
+            for (int c = 0; c < 3; ++c)
+                color[c] *= AO;
+        }
+
+        return color;
+    }
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_SCALAR_VISER_DVR_CPU_H
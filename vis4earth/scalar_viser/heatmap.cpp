@@ -46,6 +46,8 @@ VIS4Earth::HeatmapRenderer::HeatmapRenderer(QWidget *parent)
         volSliceTex->setInternalFormatMode(osg::Texture::InternalFormatMode::USE_IMAGE_DATA_FORMAT);
         volSliceTex->setImage(volSliceImg);
     };
+    connect(&volCmpt, &VolumeComponent::GeographicsLoaded, &geoCmpt,
+            &GeographicsComponent::SetGeographics);
     connect(&volCmpt, &VolumeComponent::VolumeChanged, [&, genHeatmapTex]() {
         auto vol = volCmpt.GetVolume(0, 0);
         if (!vol)
@@ -130,6 +132,20 @@ void VIS4Earth::HeatmapRenderer::initOSGResource() {
     grp->addChild(geode);
 }
 
+template <typename T>
+void VIS4Earth::HeatmapRenderer::fillHeatmap2D(const RAWVolumeData &vol,
+                                               const std::array<float, 3> &scale, int z) {
+    auto &tfFlatDat = volCmpt.GetTransferFunctionCPU(0).GetFlatData();
+    for (int y = 0; y < heatmap2D.height(); ++y) {
+        auto pxPtr = reinterpret_cast<QRgb *>(heatmap2D.scanLine(heatmap2D.height() - 1 - y));
+        for (int x = 0; x < heatmap2D.width(); ++x, ++pxPtr) {
+            auto scalar = vol.Sample<T>(scale[0] * x, scale[1] * y, z);
+            auto &rgba = tfFlatDat[VoxelTypeTraits<T>::ToTFIndex(scalar)];
+            *pxPtr = qRgb(rgba[0] * 255.f, rgba[1] * 255.f, rgba[2] * 255.f);
+        }
+    }
+}
+
 void VIS4Earth::HeatmapRenderer::updateHeatmap2D() {
     if (heatmap2D.width() != ui->spinBox_resX->value() ||
         heatmap2D.height() != ui->spinBox_resY->value())
@@ -140,19 +156,23 @@ void VIS4Earth::HeatmapRenderer::updateHeatmap2D() {
         return;
 
     auto &vol = volCmpt.GetVolumeCPU(0, 0);
-    auto &tfFlatDat = volCmpt.GetTransferFunctionCPU(0).GetFlatData();
     std::array<float, 3> scale{1.f * (vol.GetVoxelPerVolume()[0] - 1) / heatmap2D.width(),
                                1.f * (vol.GetVoxelPerVolume()[1] - 1) / heatmap2D.height(),
                                1.f * (vol.GetVoxelPerVolume()[2] - 1) /
                                    (volCmpt.GetVolume(0, 0)->getImage()->r() - 1)};
     int z = ui->spinBox_height_int_VIS4EarthReflectable->value() * scale[2];
-    for (int y = 0; y < heatmap2D.height(); ++y) {
-        auto pxPtr = reinterpret_cast<QRgb *>(heatmap2D.scanLine(heatmap2D.height() - 1 - y));
-        for (int x = 0; x < heatmap2D.width(); ++x, ++pxPtr) {
-            auto scalar = vol.Sample<uint8_t>(scale[0] * x, scale[1] * y, z);
-            auto &rgba = tfFlatDat[scalar];
-            *pxPtr = qRgb(rgba[0] * 255.f, rgba[1] * 255.f, rgba[2] * 255.f);
-        }
+    switch (vol.GetVoxelType()) {
+    case ESupportedVoxelType::UInt8:
+        fillHeatmap2D<uint8_t>(vol, scale, z);
+        break;
+    case ESupportedVoxelType::UInt16:
+        fillHeatmap2D<uint16_t>(vol, scale, z);
+        break;
+    case ESupportedVoxelType::Float32:
+        fillHeatmap2D<float>(vol, scale, z);
+        break;
+    default:
+        assert(false);
     }
 
     auto pixmap = QPixmap::fromImage(heatmap2D);
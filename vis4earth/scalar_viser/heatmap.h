@@ -47,6 +47,9 @@ class HeatmapRenderer : public QtOSGReflectableWidget {
 
     void initOSGResource();
     void updateHeatmap2D();
+    // 按体素类型特化地采样第 z 层并查传输函数，填充 heatmap2D
+    template <typename T>
+    void fillHeatmap2D(const RAWVolumeData &vol, const std::array<float, 3> &scale, int z);
     void updateGeometry();
 };
 
@@ -48,6 +48,8 @@ VIS4Earth::IsoplethRenderer::IsoplethRenderer(QWidget *parent)
     connect(ui->horizontalSlider_isoval, &QSlider::valueChanged, genIsopleth);
     connect(ui->horizontalSlider_isoval, &QSlider::valueChanged, updateText);
     connect(ui->checkBox_useVolSmoothed, &QCheckBox::stateChanged, genIsopleth);
+    connect(&volCmpt, &VolumeComponent::GeographicsLoaded, &geoCmpt,
+            &GeographicsComponent::SetGeographics);
     connect(&volCmpt, &VolumeComponent::VolumeChanged, genIsopleth);
     connect(ui->comboBox_meshSmoothType, QOverload<int>::of(&QComboBox::currentIndexChanged),
             [&, updateGeom](int idx) {
@@ -132,22 +134,32 @@ void VIS4Earth::IsoplethRenderer::initOSGResource() {
     grp->addChild(geode);
 }
 
-void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
+template <typename T>
+void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID, const RAWVolumeData &volSampled) {
     ELineType lineType = static_cast<ELineType>(ui->comboBox_lineType->currentIndex());
 
-    using T = uint8_t;
     auto &vol = volCmpt.GetVolumeCPU(volID, 0);
     std::array<uint32_t, 3> voxPerVol = {vol.GetVoxelPerVolume()[0], vol.GetVoxelPerVolume()[1],
                                          vol.GetVoxelPerVolume()[2]};
 
     auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+    auto isovalT = isoval * (VoxelTypeTraits<T>::Max() / 255.f);
 
     auto sample = [&](const osg::Vec3i &pos) -> T {
-        if (useVolSmoothed)
-            return volCmpt.GetVolumeCPUSmoothed(volID, 0).Sample<T>(pos.x(), pos.y(), pos.z());
-        return volCmpt.GetVolumeCPU(volID, 0).Sample<T>(pos.x(), pos.y(), pos.z());
+        return volSampled.Sample<T>(pos.x(), pos.y(), pos.z());
     };
 
+    // 按砖块跳过不含等值面的区域，砖块元数据仅在所采样的体数据变化时重建
+    auto &bricked = bricks[volID];
+    if (!bricked.IsBuiltFrom(volSampled)) {
+        auto volBricked = BrickedVolume::Build(volSampled);
+        bricked = volBricked.ok ? std::move(volBricked.result.dat) : BrickedVolume();
+    }
+    auto useBricks = bricked.IsBuiltFrom(volSampled);
+    auto activeBricks =
+        useBricks ? bricked.GetBrickMask(bricked.QueryIsovalue(isovalT)) : std::vector<uint8_t>();
+    auto brickSize = bricked.GetBrickSize();
+
     struct HashEdge {
         size_t operator()(const std::array<int, 3> &edgeID) const {
             size_t hash = edgeID[0];
@@ -217,7 +229,7 @@ void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
             // vertIndices.push_back(verts->size());
             tmpIndices[tmpIndicesIdx] = verts->size();
             verts->push_back(pos);
-            uvs->push_back(osg::Vec2(volID, scalar / 255.f));
+            uvs->push_back(osg::Vec2(volID, scalar / VoxelTypeTraits<T>::Max()));
             edge2vertIDs.emplace(edgeID, tmpIndices[tmpIndicesIdx]);
             ++tmpIndicesIdx;
         }
@@ -271,6 +283,11 @@ void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
 
         for (startPos.y() = 0; startPos.y() < voxPerVol[1] - 1; ++startPos.y())
             for (startPos.x() = 0; startPos.x() < voxPerVol[0] - 1; ++startPos.x()) {
+                if (useBricks && startPos.x() % brickSize == 0 &&
+                    !activeBricks[bricked.GetBrickID(startPos.x(), startPos.y(), startPos.z())]) {
+                    startPos.x() += brickSize - 1; // 单元全部在等值面一侧，不产生线段
+                    continue;
+                }
                 // Voxels in CCW order form a grid
                 // +------------+
                 // |  3 <--- 2  |
@@ -283,7 +300,7 @@ void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
                     sample(startPos), sample(startPos + osg::Vec3i(1, 0, 0)),
                     sample(startPos + osg::Vec3i(1, 1, 0)), sample(startPos + osg::Vec3i(0, 1, 0))};
                 for (uint8_t i = 0; i < 4; ++i)
-                    if (scalars[i] >= isoval)
+                    if (scalars[i] >= isovalT)
                         cornerState |= 1 << i;
 
                 osg::Vec4 omegas(1.f * scalars[0] / (scalars[1] + scalars[0]),
@@ -329,6 +346,26 @@ void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
     }
 }
 
+void VIS4Earth::IsoplethRenderer::marchingSquare(uint32_t volID) {
+    // 光滑体数据在循环外取出一次，避免逐体素查询缓存
+    auto volSmoothed = useVolSmoothed ? volCmpt.GetVolumeCPUSmoothed(volID, 0) : RAWVolumeData();
+    auto &volSampled = useVolSmoothed ? volSmoothed : volCmpt.GetVolumeCPU(volID, 0);
+
+    switch (volSampled.GetVoxelType()) {
+    case ESupportedVoxelType::UInt8:
+        marchingSquare<uint8_t>(volID, volSampled);
+        break;
+    case ESupportedVoxelType::UInt16:
+        marchingSquare<uint16_t>(volID, volSampled);
+        break;
+    case ESupportedVoxelType::Float32:
+        marchingSquare<float>(volID, volSampled);
+        break;
+    default:
+        assert(false);
+    }
+}
+
 void VIS4Earth::IsoplethRenderer::updateGeometry(uint32_t volID) {
     if (vertIndices.empty())
         return;
@@ -61,6 +61,8 @@ VIS4Earth::IsosurfaceRenderer::IsosurfaceRenderer(QWidget *parent)
             [&](int val) { ui->label_isoval->setText(QString::number(val)); });
     connect(ui->horizontalSlider_isoval, &QSlider::valueChanged, genIsosurface);
     connect(ui->checkBox_useVolSmoothed, &QCheckBox::stateChanged, genIsosurface);
+    connect(&volCmpt, &VolumeComponent::GeographicsLoaded, &geoCmpt,
+            &GeographicsComponent::SetGeographics);
     connect(&volCmpt, &VolumeComponent::VolumeChanged, genIsosurface);
     connect(ui->comboBox_meshSmoothType, QOverload<int>::of(&QComboBox::currentIndexChanged),
             [&, updateGeom](int idx) {
@@ -127,20 +129,30 @@ void VIS4Earth::IsosurfaceRenderer::initOSGResource() {
     grp->addChild(geode);
 }
 
-void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
-    using T = uint8_t;
-
+template <typename T>
+void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID, const RAWVolumeData &volSampled) {
     std::array<uint32_t, 3> voxPerVol = {volCmpt.GetUI()->label_voxPerVolX->text().toInt(),
                                          volCmpt.GetUI()->label_voxPerVolY->text().toInt(),
                                          volCmpt.GetUI()->label_voxPerVolZ->text().toInt()};
     auto voxPerVolYxX = static_cast<size_t>(voxPerVol[1]) * voxPerVol[0];
+    auto isovalT = isoval * (VoxelTypeTraits<T>::Max() / 255.f);
 
     auto sample = [&](const osg::Vec3i &pos) -> T {
-        if (useVolSmoothed)
-            return volCmpt.GetVolumeCPUSmoothed(volID, 0).Sample<T>(pos.x(), pos.y(), pos.z());
-        return volCmpt.GetVolumeCPU(volID, 0).Sample<T>(pos.x(), pos.y(), pos.z());
+        return volSampled.Sample<T>(pos.x(), pos.y(), pos.z());
     };
 
+    // 按砖块跳过不含等值面的区域，砖块元数据仅在所采样的体数据变化时重建
+    auto &bricked = bricks[volID];
+    if (!bricked.IsBuiltFrom(volSampled)) {
+        auto volBricked = BrickedVolume::Build(volSampled);
+        bricked = volBricked.ok ? std::move(volBricked.result.dat) : BrickedVolume();
+    }
+    auto useBricks =
+        bricked.IsBuiltFrom(volSampled) && volSampled.GetVoxelPerVolume() == voxPerVol;
+    auto activeBricks =
+        useBricks ? bricked.GetBrickMask(bricked.QueryIsovalue(isovalT)) : std::vector<uint8_t>();
+    auto brickSize = bricked.GetBrickSize();
+
     struct HashEdge {
         size_t operator()(const std::array<int, 3> &edgeID) const {
             size_t hash = edgeID[0];
@@ -160,6 +172,11 @@ void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
 
         for (startPos.y() = 0; startPos.y() < voxPerVol[1] - 1; ++startPos.y())
             for (startPos.x() = 0; startPos.x() < voxPerVol[0] - 1; ++startPos.x()) {
+                if (useBricks && startPos.x() % brickSize == 0 &&
+                    !activeBricks[bricked.GetBrickID(startPos.x(), startPos.y(), startPos.z())]) {
+                    startPos.x() += brickSize - 1; // 单元全部在等值面一侧，不产生三角形
+                    continue;
+                }
                 // Voxels in CCW order form a grid
                 // +-----------------+
                 // |       3 <--- 2  |
@@ -176,7 +193,7 @@ void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
                 std::array<T, 8> scalars;
                 for (int i = 0; i < 8; ++i) {
                     scalars[i] = sample(startPos);
-                    if (scalars[i] >= isoval)
+                    if (scalars[i] >= isovalT)
                         cornerState |= 1 << i;
 
                     startPos.x() += i == 0 || i == 4 ? 1 : i == 2 || i == 6 ? -1 : 0;
@@ -273,7 +290,7 @@ void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
                         vertIndices.emplace_back(verts->size());
                         verts->push_back(pos);
                         norms->push_back(osg::Vec3(0.f, 0.f, 0.f));
-                        uvs->push_back(osg::Vec2(volID, scalar / 255.f));
+                        uvs->push_back(osg::Vec2(volID, scalar / VoxelTypeTraits<T>::Max()));
                         edge2vertIDs[edge2vertIDIdx].emplace(edgeID, vertIndices.back());
                     }
 
@@ -312,6 +329,26 @@ void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
         norm.normalize();
 }
 
+void VIS4Earth::IsosurfaceRenderer::marchingCube(uint32_t volID) {
+    // 光滑体数据在循环外取出一次，避免逐体素查询缓存
+    auto volSmoothed = useVolSmoothed ? volCmpt.GetVolumeCPUSmoothed(volID, 0) : RAWVolumeData();
+    auto &volSampled = useVolSmoothed ? volSmoothed : volCmpt.GetVolumeCPU(volID, 0);
+
+    switch (volSampled.GetVoxelType()) {
+    case ESupportedVoxelType::UInt8:
+        marchingCube<uint8_t>(volID, volSampled);
+        break;
+    case ESupportedVoxelType::UInt16:
+        marchingCube<uint16_t>(volID, volSampled);
+        break;
+    case ESupportedVoxelType::Float32:
+        marchingCube<float>(volID, volSampled);
+        break;
+    default:
+        assert(false);
+    }
+}
+
 void VIS4Earth::IsosurfaceRenderer::updateGeometry(uint32_t volID) {
     if (vertIndices.empty())
         return;
@@ -9,6 +9,7 @@
 #include <osg/Group>
 #include <osg/ShapeDrawable>
 
+#include <vis4earth/data/bricked_vol.h>
 #include <vis4earth/geographics_cmpt.h>
 #include <vis4earth/osg_util.h>
 #include <vis4earth/qt_osg_reflectable.h>
@@ -55,10 +56,13 @@ class IsosurfaceRenderer : public QtOSGReflectableWidget {
 
     std::vector<GLuint> vertIndices;
     std::array<std::set<std::array<GLuint, 2>>, 2> multiEdges;
+    std::array<BrickedVolume, 2> bricks; // 用于跳过不含等值面的区域，体数据变化时重建
 
     void initOSGResource();
 
     void marchingCube(uint32_t volID);
+    // 按体素类型特化的提取核，isoval 按滑条的 [0, 255] 映射到 T 的取值范围
+    template <typename T> void marchingCube(uint32_t volID, const RAWVolumeData &volSampled);
 
     void updateGeometry(uint32_t volID);
 };
@@ -23,6 +23,7 @@ class MultiIsosurfacesRenderer {
 
     struct ShadingParam {
         bool useShading;
+        bool usePrecomputedGradient; // 为真时，已设置梯度纹理的体以其代替中心差分求法向
         float ka;
         float kd;
         float ks;
@@ -42,6 +43,7 @@ class MultiIsosurfacesRenderer {
         osg::ref_ptr<osg::Uniform> maxStepCnt;
 
         osg::ref_ptr<osg::Uniform> useShading;
+        osg::ref_ptr<osg::Uniform> usePrecomputedGradient;
         osg::ref_ptr<osg::Uniform> ka;
         osg::ref_ptr<osg::Uniform> kd;
         osg::ref_ptr<osg::Uniform> ks;
@@ -91,6 +93,7 @@ class MultiIsosurfacesRenderer {
             STATEMENT(maxStepCnt, 100);
 
             STATEMENT(useShading, 0);
+            STATEMENT(usePrecomputedGradient, 0);
             STATEMENT(ka, .5f);
             STATEMENT(kd, .5f);
             STATEMENT(ks, .5f);
@@ -107,6 +110,7 @@ class MultiIsosurfacesRenderer {
     class PerVolParam {
         bool inSelectMode = false;
         bool isDisplayed;
+        bool useSmoothedVol = false;
 
         osg::ref_ptr<osg::Uniform> minLatitute;
         osg::ref_ptr<osg::Uniform> maxLatitute;
@@ -117,6 +121,7 @@ class MultiIsosurfacesRenderer {
         osg::ref_ptr<osg::Uniform> volStartFromZeroLon;
         osg::ref_ptr<osg::Uniform> rotMat;
         osg::ref_ptr<osg::Uniform> dSamplePos;
+        osg::ref_ptr<osg::Uniform> hasGradTex;
 
         osg::ref_ptr<osg::Uniform> isosurfNum;
         osg::ref_ptr<osg::Uniform> sortedIsoVals;
@@ -127,6 +132,8 @@ class MultiIsosurfacesRenderer {
         osg::ref_ptr<osg::ShapeDrawable> selectSphere;
         osg::ref_ptr<osg::Texture3D> volTex;
         osg::ref_ptr<osg::Texture3D> volTexSmoothed;
+        osg::ref_ptr<osg::Texture3D> gradTex;
+        osg::ref_ptr<osg::Texture3D> gradTexSmoothed;
 
       public:
         PerVolParam(osg::ref_ptr<osg::Texture3D> volTex,
@@ -157,9 +164,12 @@ class MultiIsosurfacesRenderer {
                 STATEMENT(rotMat, tmpMat);
             }
             STATEMENT(dSamplePos, osg::Vec3(1.f / volDim[0], 1.f / volDim[1], 1.f / volDim[2]));
+            STATEMENT(hasGradTex, 0);
 
             auto volTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "volTex");
             volTexUni->set(0);
+            auto gradTexUni = new osg::Uniform(osg::Uniform::SAMPLER_3D, "gradTex");
+            gradTexUni->set(1);
 
             STATEMENT(isosurfNum, 0);
             sortedIsoVals = new osg::Uniform(osg::Uniform::FLOAT, "sortedIsoVals", MaxIsoValNum);
@@ -174,6 +184,9 @@ class MultiIsosurfacesRenderer {
                     states->addUniform(rotMat);
                     states->addUniform(dSamplePos);
                     states->addUniform(renderer->useShading);
+                    states->addUniform(renderer->usePrecomputedGradient);
+                    states->addUniform(hasGradTex);
+                    states->addUniform(gradTexUni);
                     states->addUniform(renderer->ka);
                     states->addUniform(renderer->kd);
                     states->addUniform(renderer->ks);
@@ -279,6 +292,7 @@ class MultiIsosurfacesRenderer {
          * -- useSmoothedVol: 为真时，使用平滑体数据
          */
         void SetUseSmoothedVolume(bool useSmoothedVol) {
+            this->useSmoothedVol = useSmoothedVol;
             auto set = [&](osg::StateSet *states) {
                 if (useSmoothedVol)
                     states->setTextureAttributeAndModes(0, volTexSmoothed, osg::StateAttribute::ON);
@@ -287,6 +301,20 @@ class MultiIsosurfacesRenderer {
             };
             set(sphere->getOrCreateStateSet());
             set(selectSphere->getOrCreateStateSet());
+            bindGradient();
+        }
+        /*
+         * 函数: SetGradients
+         * 功能: 设置预计算的梯度纹理（见 GradientVolume），着色时以其代替中心差分求法向
+         * 参数:
+         * -- gradTex: 体数据的梯度纹理
+         * -- gradTexSmoothed: 平滑体数据的梯度纹理
+         */
+        void SetGradients(osg::ref_ptr<osg::Texture3D> gradTex,
+                          osg::ref_ptr<osg::Texture3D> gradTexSmoothed) {
+            this->gradTex = gradTex;
+            this->gradTexSmoothed = gradTexSmoothed;
+            bindGradient();
         }
         /*
          * 函数: SetLongtituteRange
@@ -386,6 +414,15 @@ class MultiIsosurfacesRenderer {
 
       private:
         float deg2Rad(float deg) { return deg * osg::PI / 180.f; };
+        void bindGradient() {
+            auto tex = useSmoothedVol ? gradTexSmoothed : gradTex;
+            auto states = sphere->getOrCreateStateSet();
+            if (tex)
+                states->setTextureAttributeAndModes(1, tex, osg::StateAttribute::ON);
+            else
+                states->removeTextureAttribute(1, osg::StateAttribute::TEXTURE);
+            hasGradTex->set(tex ? 1 : 0);
+        }
         void computeRotMat() {
             float minLon, maxLon;
             float minLat, maxLat;
@@ -548,6 +585,7 @@ class MultiIsosurfacesRenderer {
             this->param.useShading->set(0);
         else {
             this->param.useShading->set(1);
+            this->param.usePrecomputedGradient->set(param.usePrecomputedGradient ? 1 : 0);
             this->param.ka->set(param.ka);
             this->param.kd->set(param.kd);
             this->param.ks->set(param.ks);
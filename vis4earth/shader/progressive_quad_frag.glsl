@@ -0,0 +1,16 @@
+#version 130
+
+uniform sampler2D colorTex;
+uniform sampler2D depthTex;
+
+varying vec2 texCoord;
+
+void main() {
+    vec4 color = texture(colorTex, texCoord);
+    if (color.a == 0.f)
+        discard;
+
+    // Ƶȣʹиڵӽڵ
+    gl_FragColor = color;
+    gl_FragDepth = texture(depthTex, texCoord).r;
+}
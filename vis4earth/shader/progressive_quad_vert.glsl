@@ -0,0 +1,8 @@
+#version 130
+
+varying vec2 texCoord;
+
+void main() {
+    texCoord = gl_MultiTexCoord0.xy;
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+}
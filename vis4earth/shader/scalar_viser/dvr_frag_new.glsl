@@ -9,9 +9,22 @@ uniform sampler2D tfTexPreInt0;
 uniform sampler2D tfTexPreInt1;
 uniform sampler1D tfTex0;
 uniform sampler1D tfTex1;
+uniform sampler3D pageTex;
+uniform sampler3D atlasTex;
+uniform sampler3D occupancyTex0;
+uniform sampler3D occupancyTex1;
+uniform sampler3D gradTex0;
+uniform sampler3D gradTex1;
+uniform sampler3D aoTex0;
+uniform sampler3D nextVolTex0;
+uniform sampler3D nextVolTex1;
 uniform vec3 eyePos;
 uniform vec3 dSamplePos0;
 uniform vec3 dSamplePos1;
+uniform vec3 pyramidVoxPerVol;
+uniform vec3 atlasVoxPerVol;
+uniform vec3 macroCellVoxPerVol0;
+uniform vec3 macroCellVoxPerVol1;
 uniform mat3 rotMat;
 uniform float sliceCntrX;
 uniform float sliceCntrY;
@@ -29,6 +42,12 @@ uniform float longtitudeMin;
 uniform float longtitudeMax;
 uniform float heightMin;
 uniform float heightMax;
+uniform float pyramidBrickSize;
+uniform float macroCellSize;
+uniform float maxStepScale;
+uniform float progressiveStepScale;
+uniform float timeFrac0;
+uniform float timeFrac1;
 uniform float ka;
 uniform float kd;
 uniform float ks;
@@ -38,7 +57,16 @@ uniform bool useSlicing;
 uniform bool useShading;
 uniform bool useTFPreInt;
 uniform bool useMultiVols;
+uniform bool usePackedVols;
 uniform bool useAO;
+uniform bool usePyramid;
+uniform bool useEmptySpaceSkip;
+uniform bool useOccupancy;
+uniform bool useAdaptiveStep;
+uniform bool usePrecomputedGradient;
+uniform bool useGradientTex;
+uniform bool usePrecomputedAO;
+uniform bool useAOTex;
 
 varying vec3 vertex;
 
@@ -96,16 +124,117 @@ SliceOnSphere computeSliceOnSphere() {
     return ret;
 }
 
-vec3 computeShading(vec3 tfCol, vec3 d, vec3 pos, vec3 samplePos, vec3 dSamplePos,
-                    sampler3D volTex) {
+/*
+ * : samplePackedVols
+ * : Ϊ volTex0  RG ͨݣһȡõֵ
+ *       timeFrac0  0 ʱһʱ䲽Բֵ
+ */
+vec2 samplePackedVols(vec3 samplePos) {
+    vec2 scalars = texture(volTex0, samplePos).rg;
+    return timeFrac0 == 0.f ? scalars
+                            : mix(scalars, texture(nextVolTex0, samplePos).rg, timeFrac0);
+}
+
+/*
+ * : sampleVol
+ * :  volID ݡtimeFrac  0 ʱһʱ䲽Բֵ
+ *       ʹݽʱ 0 ҳҵǸλõש飬ٰשڲķֱʲͼ
+ */
+float sampleVol(int volID, vec3 samplePos) {
+    if (usePackedVols) {
+        vec2 scalars = samplePackedVols(samplePos);
+        return volID == 0 ? scalars.x : scalars.y;
+    }
+    if (volID != 0) {
+        float scalar = texture(volTex1, samplePos).r;
+        return timeFrac1 == 0.f ? scalar
+                                : mix(scalar, texture(nextVolTex1, samplePos).r, timeFrac1);
+    }
+    if (!usePyramid) {
+        float scalar = texture(volTex0, samplePos).r;
+        return timeFrac0 == 0.f ? scalar
+                                : mix(scalar, texture(nextVolTex0, samplePos).r, timeFrac0);
+    }
+
+    vec3 vox = clamp(samplePos, 0.f, 1.f) * pyramidVoxPerVol;
+    ivec3 pageID = min(ivec3(vox / pyramidBrickSize), textureSize(pageTex, 0) - 1);
+    vec4 page = texelFetch(pageTex, pageID, 0);
+    return texture(atlasTex, (vox / page.w + page.xyz) / atlasVoxPerVol).r;
+}
+
+/*
+ * : toSamplePos
+ * : ռе pos еĹһλ
+ */
+vec3 toSamplePos(vec3 pos) {
+    float r = sqrt(pos.x * pos.x + pos.y * pos.y);
+    float lat = atan(pos.z / r);
+    r = length(pos);
+    float lon = atan(pos.y, pos.x);
+    return vec3((lon - longtitudeMin) / (longtitudeMax - longtitudeMin),
+                (lat - latitudeMin) / (latitudeMax - latitudeMin),
+                (r - heightMin) / (heightMax - heightMin));
+}
+
+/*
+ * : macroCellOf
+ * : زλڵĺ굥ԪԪǵһ㣬ԲֵԽԪ
+ */
+ivec3 macroCellOf(sampler3D occupancyTex, vec3 voxPerVol, vec3 samplePos) {
+    vec3 vox = samplePos * voxPerVol - .5f;
+    return clamp(ivec3(floor(vox / macroCellSize)), ivec3(0), textureSize(occupancyTex, 0) - 1);
+}
+
+/*
+ * : macroCellValue
+ * : زλں굥Ԫռȡֵ0 ʾգΪõԪĲ maxStepScale
+ */
+float macroCellValue(sampler3D occupancyTex, vec3 voxPerVol, vec3 samplePos) {
+    return texelFetch(occupancyTex, macroCellOf(occupancyTex, voxPerVol, samplePos), 0).r;
+}
+
+float macroCellStepScale(float cellVal) {
+    return cellVal == 0.f ? maxStepScale : max(1.f, cellVal * maxStepScale);
+}
+
+/*
+ * : macroCellExitLength
+ * : ع뿪λں굥Ԫǰĳ
+ * :
+ * -- dSamplePos: عÿλȲλõı仯ڵԪڰԹ
+ */
+float macroCellExitLength(sampler3D occupancyTex, vec3 voxPerVol, vec3 samplePos,
+                          vec3 dSamplePos) {
+    vec3 vox = samplePos * voxPerVol - .5f;
+    vec3 cellMin = vec3(macroCellOf(occupancyTex, voxPerVol, samplePos)) * macroCellSize;
+    vec3 cellMax = cellMin + macroCellSize;
+    vec3 dVox = dSamplePos * voxPerVol;
+
+    float t = 1e20f;
+    for (int i = 0; i < 3; ++i)
+        if (dVox[i] > 0.f)
+            t = min(t, (cellMax[i] - vox[i]) / dVox[i]);
+        else if (dVox[i] < 0.f)
+            t = min(t, (cellMin[i] - vox[i]) / dVox[i]);
+    return max(t, 0.f);
+}
+
+vec3 computeShading(vec3 tfCol, vec3 d, vec3 pos, vec3 samplePos, vec3 dSamplePos, int volID) {
     vec3 N;
-    N.x = texture(volTex, samplePos + vec3(dSamplePos.x, 0, 0)).r -
-          texture(volTex, samplePos - vec3(dSamplePos.x, 0, 0)).r;
-    N.y = texture(volTex, samplePos + vec3(0, dSamplePos.y, 0)).r -
-          texture(volTex, samplePos - vec3(0, dSamplePos.y, 0)).r;
-    N.z = texture(volTex, samplePos + vec3(0, 0, dSamplePos.z)).r -
-          texture(volTex, samplePos - vec3(0, 0, dSamplePos.z)).r;
-    N = rotMat * normalize(N);
+    if (usePrecomputedGradient && useGradientTex) {
+        // Ԥݶȷֵ໥ʱ߹
+        N = (volID == 0 ? texture(gradTex0, samplePos) : texture(gradTex1, samplePos)).rgb;
+        N = N * 2.f - 1.f;
+        N = dot(N, N) > 1e-6f ? rotMat * normalize(N) : vec3(0.f);
+    } else {
+        N.x = sampleVol(volID, samplePos + vec3(dSamplePos.x, 0, 0)) -
+              sampleVol(volID, samplePos - vec3(dSamplePos.x, 0, 0));
+        N.y = sampleVol(volID, samplePos + vec3(0, dSamplePos.y, 0)) -
+              sampleVol(volID, samplePos - vec3(0, dSamplePos.y, 0));
+        N.z = sampleVol(volID, samplePos + vec3(0, 0, dSamplePos.z)) -
+              sampleVol(volID, samplePos - vec3(0, 0, dSamplePos.z));
+        N = rotMat * normalize(N);
+    }
     if (dot(N, d) > 0)
         N = -N;
 
@@ -119,24 +248,24 @@ vec3 computeShading(vec3 tfCol, vec3 d, vec3 pos, vec3 samplePos, vec3 dSamplePo
     return (ambient + diffuse + specular) * tfCol;
 }
 
-float computeAO(vec3 samplePos, vec3 dSamplePos, sampler3D volTex, sampler1D tfTex) {
-    float curr = texture(tfTex, texture(volTex, samplePos).r).a;
+float computeAO(vec3 samplePos, vec3 dSamplePos, int volID, sampler1D tfTex) {
+    float curr = texture(tfTex, sampleVol(volID, samplePos)).a;
     float diff;
     float AO = 1.f;
     
-    diff = texture(tfTex, texture(volTex, samplePos + vec3(dSamplePos.x, 0, 0)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos + vec3(dSamplePos.x, 0, 0))).a - curr;
     AO -= diff;
-    diff = texture(tfTex, texture(volTex, samplePos - vec3(dSamplePos.x, 0, 0)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos - vec3(dSamplePos.x, 0, 0))).a - curr;
     AO -= diff;
 
-    diff = texture(tfTex, texture(volTex, samplePos + vec3(0, dSamplePos.y, 0)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos + vec3(0, dSamplePos.y, 0))).a - curr;
     AO -= diff;
-    diff = texture(tfTex, texture(volTex, samplePos - vec3(0, dSamplePos.y, 0)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos - vec3(0, dSamplePos.y, 0))).a - curr;
     AO -= diff;
 
-    diff = texture(tfTex, texture(volTex, samplePos + vec3(0, 0, dSamplePos.z)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos + vec3(0, 0, dSamplePos.z))).a - curr;
     AO -= diff;
-    diff = texture(tfTex, texture(volTex, samplePos - vec3(0, 0, dSamplePos.z)).r).a - curr;
+    diff = texture(tfTex, sampleVol(volID, samplePos - vec3(0, 0, dSamplePos.z))).a - curr;
     AO -= diff;
 
     return clamp(AO, 0.f, 1.f);
@@ -202,14 +331,15 @@ void main() {
                 lat = (lat - latitudeMin) / latDlt;
                 lon = (lon - longtitudeMin) / lonDlt;
 
-                float scalar = texture(volTex0, vec3(lon, lat, r)).r;
+                float scalar = sampleVol(0, vec3(lon, lat, r));
                 gl_FragColor = texture(tfTex0, scalar);
                 gl_FragColor.a = 1.f;
                 return;
             }
         }
     }
-    // ִйߴ㷨
+    // ִйߴ㷨Ƶĵͷֱ֡ progressiveStepScale Ŵ׼
+    float baseStep = step * progressiveStepScale;
     vec4 color = vec4(0, 0, 0, 0);
     float tAcc = 0.f;
     float prevScalar0 = -1.f;
@@ -219,6 +349,7 @@ void main() {
     vec3 firstValidSamplePos = vec3(-1.f);
     tExit -= tEntry;
     do {
+        float stepScale = 1.f;
         float r = sqrt(pos.x * pos.x + pos.y * pos.y);
         float lat = atan(pos.z / r);
         r = length(pos);
@@ -233,7 +364,35 @@ void main() {
 
             vec4 tfCol;
             vec3 samplePos = vec3(lon, lat, r);
-            float scalar = texture(volTex0, samplePos).r;
+            bool useMacroCells = useOccupancy && !usePyramid;
+            float cellVal0 =
+                useMacroCells ? macroCellValue(occupancyTex0, macroCellVoxPerVol0, samplePos) : 1.f;
+            float cellVal1 = useMacroCells && useMultiVols
+                                 ? macroCellValue(occupancyTex1, macroCellVoxPerVol1, samplePos)
+                                 : 0.f;
+            if (useEmptySpaceSkip && useMacroCells && cellVal0 == 0.f && cellVal1 == 0.f) {
+                // ǰ亯¿յĺ굥ԪڲۻɫԽԪ벻ʱһ
+                vec3 dSamplePos = (toSamplePos(pos + baseStep * d) - samplePos) / baseStep;
+                float tSkip =
+                    macroCellExitLength(occupancyTex0, macroCellVoxPerVol0, samplePos, dSamplePos);
+                if (useMultiVols)
+                    tSkip = min(tSkip, macroCellExitLength(occupancyTex1, macroCellVoxPerVol1,
+                                                           samplePos, dSamplePos));
+                int skipCnt = max(1, int(tSkip / baseStep));
+
+                pos += float(skipCnt) * baseStep * d;
+                tAcc += float(skipCnt) * baseStep;
+                stepCnt += skipCnt;
+                prevScalar0 = prevScalar1 = -1.f;
+                continue;
+            }
+            // 굥Ԫڴ亯ı仯Ŵ󲽳ȡС
+            if (useAdaptiveStep && useMacroCells)
+                stepScale = min(macroCellStepScale(cellVal0), macroCellStepScale(cellVal1));
+            // Ѵʱһβõֵ
+            vec2 scalars = usePackedVols ? samplePackedVols(samplePos)
+                                         : vec2(sampleVol(0, samplePos), 0.f);
+            float scalar = scalars.x;
             if (prevScalar0 < 0.f)
                 prevScalar0 = scalar;
             if (useTFPreInt)
@@ -243,11 +402,11 @@ void main() {
             prevScalar0 = scalar;
 
             if (useShading && tfCol.a > 0.f)
-                tfCol.rgb = computeShading(tfCol.rgb, d, pos, samplePos, dSamplePos0, volTex0);
+                tfCol.rgb = computeShading(tfCol.rgb, d, pos, samplePos, dSamplePos0, 0);
 
             if (useMultiVols) {
                 vec4 tfCol1;
-                scalar = texture(volTex1, samplePos).r;
+                scalar = usePackedVols ? scalars.y : sampleVol(1, samplePos);
                 if (prevScalar1 < 0.f)
                     prevScalar1 = scalar;
                 if (useTFPreInt)
@@ -257,14 +416,21 @@ void main() {
                 prevScalar1 = scalar;
 
                 if (useShading && tfCol1.a > 0.f)
-                    tfCol1.rgb =
-                        computeShading(tfCol1.rgb, d, pos, samplePos, dSamplePos1, volTex1);
+                    tfCol1.rgb = computeShading(tfCol1.rgb, d, pos, samplePos, dSamplePos1, 1);
 
                 float a = tfCol.a / (tfCol.a + tfCol1.a);
                 tfCol.rgb = a * tfCol.rgb + (1.f - a) * tfCol1.rgb;
                 tfCol.a = max(tfCol.a, tfCol1.a);
             }
 
+            if (stepScale * progressiveStepScale != 1.f && tfCol.a > 0.f) {
+                // ͸Ȱ step ĲУԤֵɫѳԲ͸ȣ֮
+                float a = 1.f - pow(1.f - tfCol.a, stepScale * progressiveStepScale);
+                if (useTFPreInt)
+                    tfCol.rgb *= a / tfCol.a;
+                tfCol.a = a;
+            }
+
             if (tfCol.a > 0.f) {
                 if (firstValidSamplePos.x == -1.f)
                     firstValidSamplePos = samplePos;
@@ -279,14 +445,15 @@ void main() {
             }
         }
 
-        pos += step * d;
-        tAcc += step;
+        pos += stepScale * baseStep * d;
+        tAcc += stepScale * baseStep;
         ++stepCnt;
     } while (tAcc < tExit && stepCnt <= maxStepCnt);
 
     float AO = 1.f; 
     if (useAO &&  firstValidSamplePos.x != -1.f)
-        AO = computeAO(firstValidSamplePos, dSamplePos0, volTex0, tfTex0);
+        AO = usePrecomputedAO && useAOTex ? texture(aoTex0, firstValidSamplePos).r
+                                          : computeAO(firstValidSamplePos, dSamplePos0, 0, tfTex0);
     color.rgb *= AO;
 
     gl_FragColor = color;
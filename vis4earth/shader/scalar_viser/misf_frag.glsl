@@ -5,6 +5,7 @@
 #define PI (3.14159f)
 
 uniform sampler3D volTex;
+uniform sampler3D gradTex;
 uniform vec3 eyePos;
 uniform vec3 lightPos;
 uniform vec3 dSamplePos;
@@ -27,6 +28,8 @@ uniform int maxStepCnt;
 uniform int volStartFromZeroLon;
 uniform int selectedIsosurfIdx;
 uniform int useShading;
+uniform int usePrecomputedGradient;
+uniform int hasGradTex;
 
 varying vec3 vertex;
 
@@ -154,10 +157,17 @@ void main() {
 							(scalar - sortedIsoVals[realIdx]) / scalarDlt * prevSamplePos;
 
 						vec3 N;
-						N.x = texture(volTex, cmptSamplePos + vec3(dSamplePos.x, 0, 0)).r - texture(volTex, cmptSamplePos - vec3(dSamplePos.x, 0, 0)).r;
-						N.y = texture(volTex, cmptSamplePos + vec3(0, dSamplePos.y, 0)).r - texture(volTex, cmptSamplePos - vec3(0, dSamplePos.y, 0)).r;
-						N.z = texture(volTex, cmptSamplePos + vec3(0, 0, dSamplePos.z)).r - texture(volTex, cmptSamplePos - vec3(0, 0, dSamplePos.z)).r;
-						N = rotMat * normalize(N);
+						if (usePrecomputedGradient != 0 && hasGradTex != 0) {
+							// Ԥݶȷֵ໥ʱ߹
+							N = texture(gradTex, cmptSamplePos).rgb * 2.f - 1.f;
+							N = dot(N, N) > 1e-6f ? rotMat * normalize(N) : vec3(0.f);
+						}
+						else {
+							N.x = texture(volTex, cmptSamplePos + vec3(dSamplePos.x, 0, 0)).r - texture(volTex, cmptSamplePos - vec3(dSamplePos.x, 0, 0)).r;
+							N.y = texture(volTex, cmptSamplePos + vec3(0, dSamplePos.y, 0)).r - texture(volTex, cmptSamplePos - vec3(0, dSamplePos.y, 0)).r;
+							N.z = texture(volTex, cmptSamplePos + vec3(0, 0, dSamplePos.z)).r - texture(volTex, cmptSamplePos - vec3(0, 0, dSamplePos.z)).r;
+							N = rotMat * normalize(N);
+						}
 						if (dot(N, d) > 0) N = -N;
 
 						vec3 p2l = normalize(lightPos - pos);
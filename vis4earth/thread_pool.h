@@ -0,0 +1,144 @@
+#ifndef VIS4EARTH_THREAD_POOL_H
+#define VIS4EARTH_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <queue>
+#include <vector>
+
+namespace VIS4Earth {
+
+/*
+ * 类: ThreadPool
+ * 功能: 常驻工作线程池，供体数据的批量计算（重采样、光滑、预计算等）使用
+ */
+class ThreadPool {
+  public:
+    static ThreadPool &Global() {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        return pool;
+    }
+
+    explicit ThreadPool(uint32_t threadNum) {
+        workers.reserve(threadNum);
+        for (uint32_t i = 0; i < threadNum; ++i)
+            workers.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lk(mtx);
+                        cv.wait(lk, [&]() { return stopped || !tasks.empty(); });
+                        if (stopped && tasks.empty())
+                            return;
+
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stopped = true;
+        }
+        cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    uint32_t GetThreadNumber() const { return static_cast<uint32_t>(workers.size()); }
+
+    template <typename FuncTy> std::future<void> Submit(FuncTy fn) {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::move(fn));
+        auto ret = task->get_future();
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            tasks.emplace([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return ret;
+    }
+
+    /*
+     * 函数: ParallelFor
+     * 功能: 将 [begin, end) 按 grain 分块，由调用线程与工作线程共同执行 fn(i)
+     * 注意: 调用线程本身也参与计算，因此可在工作线程中嵌套调用而不会死锁
+     */
+    template <typename FuncTy>
+    void ParallelFor(uint32_t begin, uint32_t end, FuncTy fn, uint32_t grain = 1) {
+        if (begin >= end)
+            return;
+        grain = std::max(grain, 1u);
+
+        struct State {
+            std::atomic<uint32_t> next;
+            std::atomic<uint32_t> finished;
+            uint32_t end;
+            uint32_t grain;
+            std::function<void(uint32_t)> fn;
+            std::mutex mtx;
+            std::condition_variable cv;
+
+            void Run() {
+                uint32_t cnt = 0;
+                while (true) {
+                    auto i = next.fetch_add(grain);
+                    if (i >= end)
+                        break;
+
+                    auto iEnd = std::min(end, i + grain);
+                    for (auto ii = i; ii < iEnd; ++ii)
+                        fn(ii);
+                    cnt += iEnd - i;
+                }
+                if (cnt != 0 && finished.fetch_add(cnt) + cnt == end) {
+                    std::lock_guard<std::mutex> lk(mtx);
+                    cv.notify_all();
+                }
+            }
+        };
+        auto state = std::make_shared<State>();
+        state->next = begin;
+        state->finished = begin;
+        state->end = end;
+        state->grain = grain;
+        state->fn = fn;
+
+        auto helperNum = std::min(GetThreadNumber(), (end - begin + grain - 1) / grain - 1);
+        if (helperNum != 0) {
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                for (uint32_t i = 0; i < helperNum; ++i)
+                    tasks.emplace([state]() { state->Run(); });
+            }
+            cv.notify_all();
+        }
+
+        state->Run();
+        std::unique_lock<std::mutex> lk(state->mtx);
+        state->cv.wait(lk, [&]() { return state->finished.load() == end; });
+    }
+
+  private:
+    bool stopped = false;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::queue<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+};
+
+} // namespace VIS4Earth
+
+#endif // !VIS4EARTH_THREAD_POOL_H
@@ -1,7 +1,9 @@
 ﻿#ifndef VIS4EARTH_UTIL_H
 #define VIS4EARTH_UTIL_H
 
+#include <new>
 #include <string>
+#include <utility>
 
 #ifdef DEPLOY_ON_ZHONGDIAN15
 #include <grid/common/base/AppEnv.h>
@@ -15,33 +17,52 @@ template <typename T> struct Optional {
 
     Optional() : ok(false) {}
     Optional(const T &val) : ok(true), val(val) {}
+    Optional(T &&val) : ok(true), val(std::move(val)) {}
 };
 
+/*
+ * 结构体: ReteurnOrError
+ * 功能: 成功时持有结果 dat，失败时持有错误信息 errMsg。支持移动，
+ *       按值返回局部变量或在容器间传递时不复制 dat 所持有的缓冲
+ */
 template <typename T> struct ReteurnOrError {
     bool ok;
     union Result {
         std::string errMsg;
         T dat;
 
-        Result() { new (&this->errMsg) std::string("Empty"); }
-        Result(const char *errMsg) { new (&this->errMsg) std::string(errMsg); }
-        Result(const T &dat) { new (&this->dat) T(dat); }
-        Result& operator=(const T &dat) { new (&this->dat) T(dat); return *this; }
-        Result& operator=(const char *errMsg) { new (&this->errMsg) std::string(errMsg);  return *this; }
+        Result() {}
         ~Result() {}
     } result;
 
-    ReteurnOrError(const char *errMsg) : ok(false), result(errMsg) {}
-    ReteurnOrError(const T &dat) : ok(true), result(dat) {}
-    ReteurnOrError(const ReteurnOrError &other) {
-        // ~ReteurnOrError();
+    ReteurnOrError(const char *errMsg) : ok(false) { new (&result.errMsg) std::string(errMsg); }
+    ReteurnOrError(const T &dat) : ok(true) { new (&result.dat) T(dat); }
+    ReteurnOrError(T &&dat) : ok(true) { new (&result.dat) T(std::move(dat)); }
+    ReteurnOrError(const ReteurnOrError &other) : ok(other.ok) {
+        if (ok)
+            new (&result.dat) T(other.result.dat);
+        else
+            new (&result.errMsg) std::string(other.result.errMsg);
+    }
+    ReteurnOrError(ReteurnOrError &&other) : ok(other.ok) {
+        if (ok)
+            new (&result.dat) T(std::move(other.result.dat));
+        else
+            new (&result.errMsg) std::string(std::move(other.result.errMsg));
+    }
+    ReteurnOrError &operator=(ReteurnOrError other) {
+        destroy();
         ok = other.ok;
         if (ok)
-            result = other.result.dat;
+            new (&result.dat) T(std::move(other.result.dat));
         else
-            result = other.result.errMsg.c_str();
+            new (&result.errMsg) std::string(std::move(other.result.errMsg));
+        return *this;
     }
-    ~ReteurnOrError() {
+    ~ReteurnOrError() { destroy(); }
+
+  private:
+    void destroy() {
         if (ok)
             result.dat.~T();
         else
@@ -1,10 +1,13 @@
 ﻿#include <vis4earth/volume_cmpt.h>
 
+#include <chrono>
+
 #include <ui_volume_cmpt.h>
 
 VIS4Earth::VolumeComponent::VolumeComponent(bool keepCPUData, bool keepVolSmoothed, QWidget *parent)
     : keepCPUData(keepCPUData), keepVolSmoothed(keepVolSmoothed),
-      QtOSGReflectableWidget(ui, parent) {
+      QtOSGReflectableWidget(ui, parent), smoothedCache(0),
+      aoCache(static_cast<size_t>(256) << 20) {
     {
         auto gridLayout = reinterpret_cast<QGridLayout *>(ui->groupBox_tf->layout());
 
@@ -18,6 +21,8 @@ VIS4Earth::VolumeComponent::VolumeComponent(bool keepCPUData, bool keepVolSmooth
 
     connect(ui->pushButton_loadRAWVolume, &QPushButton::clicked, this,
             &VolumeComponent::loadRAWVolume);
+    connect(ui->pushButton_cancelLoad, &QPushButton::clicked, this,
+            &VolumeComponent::cancelLoadRAWVolume);
     connect(ui->pushButton_loadTF, &QPushButton::clicked, this, &VolumeComponent::loadTF);
 
     multiRelativeAlphas[0] = 1.0f;
@@ -26,6 +31,7 @@ VIS4Earth::VolumeComponent::VolumeComponent(bool keepCPUData, bool keepVolSmooth
         ui->doubleSpinBox_relativeAlpha->setValue(multiRelativeAlphas[idx]);
         tfEditors[idx]->raise();
 
+        updateLoadProgress();
         if (GetVolumeTimeNumber(idx) == 0)
             return;
 
@@ -41,6 +47,14 @@ VIS4Earth::VolumeComponent::VolumeComponent(bool keepCPUData, bool keepVolSmooth
             [&](int) { smoothVolume(); });
     connect(ui->comboBox_smoothDim, QOverload<int>::of(&QComboBox::currentIndexChanged),
             [&](int) { smoothVolume(); });
+    connect(ui->spinBox_smoothRadius, QOverload<int>::of(&QSpinBox::valueChanged),
+            [&](int) { smoothVolume(); });
+    auto changeSmoothCacheBudget = [&](int mb) {
+        smoothedCache.SetByteBudget(static_cast<size_t>(mb) << 20);
+    };
+    connect(ui->spinBox_smoothCacheMB, QOverload<int>::of(&QSpinBox::valueChanged),
+            changeSmoothCacheBudget);
+    changeSmoothCacheBudget(ui->spinBox_smoothCacheMB->value());
 
     auto changeRelativeAlpha = [&]() {
         multiRelativeAlphas[ui->comboBox_currVolID->currentIndex()] =
@@ -50,90 +64,370 @@ VIS4Earth::VolumeComponent::VolumeComponent(bool keepCPUData, bool keepVolSmooth
     connect(ui->doubleSpinBox_relativeAlpha, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             changeRelativeAlpha);
     changeRelativeAlpha();
+    // 合并一帧（本程序约每秒 45 帧）内的改变，拖动时首次改变后至多延迟一帧即更新
+    tfTimer.setSingleShot(true);
+    tfTimer.setInterval(1000 / 45);
+    connect(&tfTimer, &QTimer::timeout, this, &VolumeComponent::sampleTF);
     for (int i = 0; i < 2; ++i)
-        connect(tfEditors[i], &TransferFunctionEditor::TransferFunctionChanged, this,
-                &VolumeComponent::sampleTF);
+        connect(tfEditors[i], &TransferFunctionEditor::TransferFunctionChanged, [&, i]() {
+            tfDirties[i] = true;
+            if (!tfTimer.isActive())
+                tfTimer.start();
+        });
     sampleTF();
 }
 
+VIS4Earth::VolumeComponent::~VolumeComponent() {
+    // 工作线程会向本对象投递结果，析构前须等待其退出
+    for (auto &loadState : loadStates)
+        loadState.loader.reset();
+}
+
 void VIS4Earth::VolumeComponent::loadRAWVolume() {
-    auto filePaths = QFileDialog::getOpenFileNames(this, tr("Open RAW Volume File"), "./", tr("RAW Volume (*.raw *.bin)"));
+    auto filePaths = QFileDialog::getOpenFileNames(this, tr("Open RAW Volume File"), "./", tr("RAW Volume (*.raw *.bin);;Volume Container (*.v4e);;Volume Pyramid (*.v4p)"));
     if (filePaths.isEmpty())
         return;
 
     std::array<uint32_t, 3> voxPerVol = {ui->spinBox_voxPerVolX->value(),
                                          ui->spinBox_voxPerVolY->value(),
                                          ui->spinBox_voxPerVolZ->value()};
+    auto voxTy = GetVoxelType();
+
+    // 容器自带尺寸、体素类型与地理范围，无需手动设置
+    std::shared_ptr<const VolumeContainer> container;
+    if (filePaths.size() == 1 && filePaths.front().endsWith(".v4e", Qt::CaseInsensitive)) {
+        auto opened = VolumeContainer::Open(filePaths.front().toStdString());
+        if (!opened.ok) {
+            QMessageBox::warning(this, tr("Error"), tr(opened.result.errMsg.c_str()));
+            return;
+        }
+        container = opened.result.dat;
+
+        auto &info = container->GetInfo();
+        voxPerVol = info.voxPerVol;
+        voxTy = info.voxTy;
+        ui->comboBox_voxTy->setCurrentIndex(static_cast<int>(voxTy));
+        ui->spinBox_voxPerVolX->setValue(voxPerVol[0]);
+        ui->spinBox_voxPerVolY->setValue(voxPerVol[1]);
+        ui->spinBox_voxPerVolZ->setValue(voxPerVol[2]);
+        emit GeographicsLoaded(info.lonRange[0], info.lonRange[1], info.latRange[0],
+                               info.latRange[1], info.heightRange[0], info.heightRange[1]);
+    }
+
+    uint32_t volID = ui->comboBox_currVolID->currentIndex();
+    auto &loadState = loadStates[volID];
+    // 等待上一次加载的工作线程退出后再清空，避免其写入光滑缓存
+    loadState.loader.reset();
+    ++loadState.generation;
+    loadState.nextFileIdx = 0;
+    loadState.finishedNum = 0;
+    loadState.pendings.clear();
+    loadState.errMsgs.clear();
+    loadState.start = std::chrono::steady_clock::now();
+    loadState.compress = ui->checkBox_compressSeries->isChecked();
+
+    multiTimeVaryingVols[volID].clear();
+    multiTimeVaryingVolCPUs[volID].clear();
+    multiCompressedVolCPUs[volID].Clear();
+    multiMacroCells[volID].clear();
+    multiGradients[volID].clear();
+    packedVols.clear();
+    volTexSizeModes[volID] = textureSizeMode();
+    multiCompressedVolCPUs[volID].SetKeyframeInterval(ui->spinBox_keyframeInterval->value());
+    decodedSteps[volID].fill(DecodedStep());
+    players[volID].reset();
+    pyramids[volID].reset();
+    smoothedCache.Erase(volID);
+    aoCache.Erase(volID);
+
+    if (filePaths.size() == 1 && filePaths.front().endsWith(".v4p", Qt::CaseInsensitive)) {
+        loadVolumePyramid(volID, filePaths.front());
+        return;
+    }
+    if (ui->checkBox_streaming->isChecked()) {
+        streamRAWVolume(volID, filePaths, voxPerVol, voxTy, container);
+        return;
+    }
+
+    AsyncVolumeLoader::Parameters param;
+    for (const auto &filePath : filePaths)
+        param.filePaths.emplace_back(filePath.toStdString());
+    param.voxPerVol = voxPerVol;
+    param.voxTy = voxTy;
+    param.storageMode = ui->checkBox_memoryMapped->isChecked()
+                            ? RAWVolumeData::EStorageMode::MemoryMapped
+                            : RAWVolumeData::EStorageMode::InMemory;
+    param.texSizeMode = volTexSizeModes[volID];
+    // 压缩存放须由 CPU 数据编码
+    param.keepCPUData = keepCPUData || loadState.compress;
+    param.macroCellSize = macroCellSize;
+    param.computeGradient = computeGradient;
+    param.inFlightByteBudget = static_cast<size_t>(ui->spinBox_loadInFlightMB->value()) << 20;
+    param.workerNum = 0;
+    param.container = container;
+
+    // 第 0 个时间步在工作线程中顺带按当前参数光滑，交付后即可直接命中缓存
+    AsyncVolumeLoader::ProcessCallback process;
+    if (keepVolSmoothed) {
+        auto smoothParam = smoothParameters();
+        auto texSizeMode = param.texSizeMode;
+        process = [this, volID, smoothParam, texSizeMode](uint32_t fileIdx,
+                                                          const RAWVolumeData &vol) {
+            if (fileIdx == 0)
+                smoothAndCache(volID, fileIdx, smoothParam, texSizeMode, vol);
+        };
+    }
+    auto generation = loadState.generation;
+    auto loaded = [this, volID, generation](AsyncVolumeLoader::Result result) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, volID, generation, result]() { onRAWVolumeLoaded(volID, generation, result); },
+            Qt::QueuedConnection);
+    };
+
+    loadState.loader.reset(new AsyncVolumeLoader(param, process, loaded));
+    qDebug() << "Start Loading" << loadState.loader->GetFileNumber() << "time steps into volume"
+             << volID;
+    updateLoadProgress();
+}
+
+void VIS4Earth::VolumeComponent::streamRAWVolume(
+    uint32_t volID, const QStringList &filePaths, const std::array<uint32_t, 3> &voxPerVol,
+    ESupportedVoxelType voxTy, std::shared_ptr<const VolumeContainer> container) {
+    TimeVaryingVolumePlayer::Parameters param;
+    for (const auto &filePath : filePaths)
+        param.filePaths.emplace_back(filePath.toStdString());
+    param.voxPerVol = voxPerVol;
+    param.voxTy = voxTy;
+    param.storageMode = ui->checkBox_memoryMapped->isChecked()
+                            ? RAWVolumeData::EStorageMode::MemoryMapped
+                            : RAWVolumeData::EStorageMode::InMemory;
+    param.texSizeMode = textureSizeMode();
+    param.cpuStepNum = ui->spinBox_streamCPUSteps->value();
+    param.gpuStepNum = ui->spinBox_streamGPUSteps->value();
+    param.container = container;
+
+    // 仅同步加载第 0 个时间步，其余时间步在播放时由环形缓冲预取
+    auto player = TimeVaryingVolumePlayer::Create(param);
+    if (!player.ok) {
+        QMessageBox::warning(this, tr("Error"), tr(player.result.errMsg.c_str()));
+        return;
+    }
+    players[volID] = player.result.dat;
+    // 仅第 0 个时间步的 CPU 数据常驻，其余时间步不构建宏单元网格，也不计算梯度
+    if (macroCellSize != 0) {
+        auto macroCells = MacroCellGrid::Build(players[volID]->GetFirstVolumeCPU(), macroCellSize);
+        if (macroCells.ok)
+            multiMacroCells[volID].emplace_back(
+                std::make_shared<MacroCellGrid>(std::move(macroCells.result.dat)));
+    }
+    if (computeGradient) {
+        auto gradient = GradientVolume::Compute(players[volID]->GetFirstVolumeCPU());
+        if (gradient.ok)
+            multiGradients[volID].emplace_back(gradient.result.dat.ToOSGTexture());
+    }
+    qDebug() << "Streaming" << players[volID]->GetTimeNumber() << "time steps into volume" << volID
+             << "with" << param.cpuStepNum << "CPU steps and" << param.gpuStepNum << "GPU steps";
+
+    updateLoadProgress();
+    if (volID == static_cast<uint32_t>(ui->comboBox_currVolID->currentIndex()))
+        updateVoxelPerVolume();
+    smoothVolume();
+}
+
+void VIS4Earth::VolumeComponent::loadVolumePyramid(uint32_t volID, const QString &filePath) {
+    // 金字塔的砖块由渲染器按视点调入，此处仅读出不超过该尺寸的预览层，供其余渲染器使用
+    static const uint32_t PreviewVoxelPerSide = 256;
 
-    auto volID = ui->comboBox_currVolID->currentIndex();
+    auto opened = VolumePyramid::Open(filePath.toStdString());
+    if (!opened.ok) {
+        QMessageBox::warning(this, tr("Error"), tr(opened.result.errMsg.c_str()));
+        return;
+    }
+    auto &pyramid = opened.result.dat;
+    auto previewLvl = pyramid->GetPreviewLevel(PreviewVoxelPerSide);
+    auto volDat = pyramid->ReadLevel(previewLvl);
+    if (!volDat.ok) {
+        QMessageBox::warning(this, tr("Error"), tr(volDat.result.errMsg.c_str()));
+        return;
+    }
+
+    pyramids[volID] = pyramid;
+    multiTimeVaryingVols[volID].emplace_back(volDat.result.dat.ToOSGTexture(textureSizeMode()));
+    if (keepCPUData)
+        multiTimeVaryingVolCPUs[volID].emplace_back(std::move(volDat.result.dat));
+    qDebug() << "Loaded level" << previewLvl << "of" << pyramid->GetLevelNumber()
+             << "levels as preview of volume" << volID;
+
+    auto &info = pyramid->GetInfo();
+    ui->comboBox_voxTy->setCurrentIndex(static_cast<int>(info.voxTy));
+    ui->spinBox_voxPerVolX->setValue(info.voxPerVol[0]);
+    ui->spinBox_voxPerVolY->setValue(info.voxPerVol[1]);
+    ui->spinBox_voxPerVolZ->setValue(info.voxPerVol[2]);
+    emit GeographicsLoaded(info.lonRange[0], info.lonRange[1], info.latRange[0], info.latRange[1],
+                           info.heightRange[0], info.heightRange[1]);
+
+    updateLoadProgress();
+    if (volID == static_cast<uint32_t>(ui->comboBox_currVolID->currentIndex()))
+        updateVoxelPerVolume();
+    smoothVolume();
+}
+
+void VIS4Earth::VolumeComponent::cancelLoadRAWVolume() {
+    auto &loadState = loadStates[ui->comboBox_currVolID->currentIndex()];
+    if (!loadState.loader)
+        return;
+
+    loadState.loader->Cancel();
+    loadState.pendings.clear();
+    qDebug() << "Loading cancelled after" << loadState.nextFileIdx << "/"
+             << loadState.loader->GetFileNumber() << "files";
+    updateLoadProgress();
+}
+
+void VIS4Earth::VolumeComponent::onRAWVolumeLoaded(uint32_t volID, uint32_t generation,
+                                                   AsyncVolumeLoader::Result result) {
+    auto &loadState = loadStates[volID];
+    if (generation != loadState.generation || !loadState.loader ||
+        loadState.loader->IsCancelled())
+        return;
+
+    qDebug() << "End Reading" << result.fileIdx << "in" << result.milliseconds << "ms";
+    ++loadState.finishedNum;
+    loadState.pendings.emplace(result.fileIdx, result);
+
+    // 按文件顺序交付，已交付的时间步立即可被渲染器使用
     auto &vols = multiTimeVaryingVols[volID];
     auto &volCPUs = multiTimeVaryingVolCPUs[volID];
+    auto prevTimeNum = vols.size();
+    for (auto itr = loadState.pendings.find(loadState.nextFileIdx);
+         itr != loadState.pendings.end(); itr = loadState.pendings.find(loadState.nextFileIdx)) {
+        auto &res = itr->second;
+        if (res.errMsg.empty()) {
+            multiMacroCells[volID].emplace_back(res.macroCells);
+            multiGradients[volID].emplace_back(res.gradient);
+        }
+        if (res.errMsg.empty() && loadState.compress) {
+            // 第 0 个时间步同时保留未压缩的数据，渲染器无需解码即可使用
+            if (vols.empty()) {
+                vols.emplace_back(res.vol);
+                volCPUs.emplace_back(res.volCPU);
+            }
+            auto errMsg = multiCompressedVolCPUs[volID].Append(res.volCPU);
+            if (!errMsg.empty())
+                loadState.errMsgs.append(QString::fromStdString(errMsg));
+        } else if (res.errMsg.empty()) {
+            vols.emplace_back(res.vol);
+            if (keepCPUData)
+                volCPUs.emplace_back(res.volCPU);
+        } else
+            loadState.errMsgs.append(QString::fromStdString(res.errMsg));
+
+        loadState.loader->Release(res.byteSize);
+        loadState.pendings.erase(itr);
+        ++loadState.nextFileIdx;
+    }
 
-    vols.clear();
-    vols.reserve(filePaths.size());
-    if (keepCPUData) {
-        volCPUs.clear();
-        volCPUs.reserve(filePaths.size());
+    packVolumes();
+
+    if (prevTimeNum == 0 && !vols.empty()) {
+        if (volID == static_cast<uint32_t>(ui->comboBox_currVolID->currentIndex()))
+            updateVoxelPerVolume();
+        smoothVolume();
     }
-    for (const auto &filePath : filePaths) {
-        qDebug() << "Start Reading " << filePath;
-        auto volDat = RAWVolumeData::LoadFromFile(RAWVolumeData::FromFileParameters{
-            voxPerVol, ESupportedVoxelType::UInt8, filePath.toStdString()});
-        if (!volDat.ok) {
-            QMessageBox::warning(this, tr("Error"), tr(volDat.result.errMsg.c_str()));
-            continue;
-        }
 
-        vols.emplace_back(volDat.result.dat.ToOSGTexture());
-        if (keepCPUData)
-            volCPUs.emplace_back(volDat.result.dat);
-        qDebug() << "End Reading " << filePath;
+    if (loadState.nextFileIdx == loadState.loader->GetFileNumber()) {
+        qDebug() << "End Loading volume" << volID << "in"
+                 << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              loadState.start)
+                        .count()
+                 << "ms";
+        if (IsCompressed(volID))
+            multiCompressedVolCPUs[volID].LogStatistics();
+        loadState.loader.reset();
+        if (!loadState.errMsgs.isEmpty())
+            QMessageBox::warning(this, tr("Error"), loadState.errMsgs.join('\n'));
     }
+    updateLoadProgress();
+}
 
-    updateVoxelPerVolume();
-    smoothVolume();    
+void VIS4Earth::VolumeComponent::updateLoadProgress() {
+    auto &loadState = loadStates[ui->comboBox_currVolID->currentIndex()];
+    auto isLoading = loadState.loader && !loadState.loader->IsCancelled();
+
+    ui->pushButton_cancelLoad->setEnabled(isLoading);
+    if (!loadState.loader) {
+        ui->progressBar_load->setMaximum(std::max(1u, loadState.nextFileIdx));
+        ui->progressBar_load->setValue(loadState.nextFileIdx);
+        ui->progressBar_load->setFormat(tr("%v/%m"));
+        return;
+    }
+
+    ui->progressBar_load->setMaximum(loadState.loader->GetFileNumber());
+    ui->progressBar_load->setValue(loadState.finishedNum);
+    ui->progressBar_load->setFormat(isLoading ? tr("%v/%m") : tr("已取消 %v/%m"));
 }
 
-void VIS4Earth::VolumeComponent::smoothVolume() {
-    auto smooth = [&](uint32_t volID) {
-        auto &vols = multiTimeVaryingVols[volID];
-        auto &volCPUs = multiTimeVaryingVolCPUs[volID];
-        auto &volSmootheds = multiTimeVaryingVolSmootheds[volID];
-        auto &volCPUSmootheds = multiTimeVaryingVolCPUSmootheds[volID];
-
-        if (keepVolSmoothed) {
-            volSmootheds.clear();
-            volSmootheds.reserve(vols.size());
-        }
-        if (keepCPUData && keepVolSmoothed) {
-            volCPUSmootheds.clear();
-            volCPUSmootheds.reserve(vols.size());
-        }
+void VIS4Earth::VolumeComponent::packVolumes() {
+    if (!packVols || !keepCPUData)
+        return;
+    for (uint32_t i = 0; i < 2; ++i)
+        if (IsStreaming(i) || IsCompressed(i) || pyramids[i])
+            return;
+    // 打包的纹理与各体的纹理尺寸一致，2 的幂模式下各变量先分别按同样的方式重采样再打包
+    auto texSizeMode = volTexSizeModes[0];
+    if (volTexSizeModes[1] != texSizeMode)
+        return;
 
-        for (uint32_t timeID = 0; timeID < vols.size(); ++timeID) {
-            if (keepVolSmoothed) {
-                auto volDatSmoothed = volCPUs[timeID].GetSmoothed(
-                    RAWVolumeData::SmoothParameters{static_cast<RAWVolumeData::ESmoothType>(
-                                                        ui->comboBox_smoothType->currentIndex()),
-                                                    static_cast<RAWVolumeData::ESmoothDimension>(
-                                                        ui->comboBox_smoothDim->currentIndex())});
-                volSmootheds.emplace_back(volDatSmoothed.ToOSGTexture());
-
-                if (keepCPUData)
-                    volCPUSmootheds.emplace_back(volDatSmoothed);
+    auto timeNum = std::min(multiTimeVaryingVolCPUs[0].size(), multiTimeVaryingVolCPUs[1].size());
+    while (packedVols.size() < timeNum) {
+        auto timeID = packedVols.size();
+        std::vector<const RAWVolumeData *> vars = {&multiTimeVaryingVolCPUs[0][timeID],
+                                                   &multiTimeVaryingVolCPUs[1][timeID]};
+        std::array<RAWVolumeData, 2> resizedVars;
+        if (texSizeMode == RAWVolumeData::ETextureSizeMode::PowerOfTwo)
+            for (uint32_t i = 0; i < 2; ++i) {
+                auto potVoxPerVol =
+                    RAWVolumeData::GetPowerOfTwoVoxelPerVolume(vars[i]->GetVoxelPerVolume());
+                resizedVars[i] = vars[i]
+                                     ->GetResized(RAWVolumeData::ResizeParameters{
+                                         RAWVolumeData::EFilterType::Linear, potVoxPerVol})
+                                     .result.dat;
+                vars[i] = &resizedVars[i];
             }
+
+        auto packed = PackedVolumeData::Pack(vars);
+        if (!packed.ok) {
+            if (timeID == 0)
+                qDebug() << "Pack volumes failed:" << packed.result.errMsg.c_str();
+            return;
         }
-    };
+        packedVols.emplace_back(packed.result.dat.ToOSGTexture());
+    }
+}
 
-    for (uint32_t vi = 0; vi < 2; ++vi) {
-        auto tNum = GetVolumeTimeNumber(vi);
-        if (tNum == 0)
-            continue;
+void VIS4Earth::VolumeComponent::SetPackVolumes(bool pack) {
+    packVols = pack;
+    if (pack)
+        packVolumes();
+    else
+        packedVols.clear();
+}
 
-        qDebug() << "Start Smooth" << vi;
-        smooth(vi);
-        qDebug() << "End Smooth" << vi;
-    }
+void VIS4Earth::VolumeComponent::smoothVolume() {
+    // 仅预先计算当前可见的时间步（各渲染器目前只显示第 0 步），其余时间步在访问时计算；
+    // 已计算过的光滑参数组合直接命中缓存
+    if (keepVolSmoothed)
+        for (uint32_t vi = 0; vi < 2; ++vi) {
+            auto tNum = GetVolumeTimeNumber(vi);
+            if (tNum == 0)
+                continue;
+
+            qDebug() << "Start Smooth" << vi;
+            getSmoothed(vi, 0);
+            qDebug() << "End Smooth" << vi;
+        }
+    smoothedCache.LogStatistics();
 
     emit VolumeChanged();
 }
@@ -157,14 +451,31 @@ void VIS4Earth::VolumeComponent::loadTF() {
 void VIS4Earth::VolumeComponent::saveTF() { assert(false); }
 
 void VIS4Earth::VolumeComponent::sampleTF() {
-    auto sample = [&](uint32_t volID) {
-        multiTFs[volID] = tfEditors[volID]->GetTransferFunctionData().ToOSGTexture();
-        multiTFPreInts[volID] =
-            tfEditors[volID]->GetTransferFunctionData().ToPreIntegratedOSGTexture();
-    };
+    tfTimer.stop();
 
-    for (uint32_t vi = 0; vi < 2; ++vi)
-        sample(vi);
+    auto changed = false;
+    for (uint32_t vi = 0; vi < 2; ++vi) {
+        if (!tfDirties[vi])
+            continue;
+        tfDirties[vi] = false;
+
+        auto &tf = tfEditors[vi]->GetTransferFunctionData();
+        if (multiTFs[vi] && tf.GetFlatData() == sampledTFs[vi])
+            continue;
+        sampledTFs[vi] = tf.GetFlatData();
+        changed = true;
+
+        if (!multiTFs[vi]) {
+            multiTFs[vi] = tf.ToOSGTexture();
+            multiTFPreInts[vi] = tf.ToPreIntegratedOSGTexture();
+        } else {
+            tf.UpdateOSGTexture(*multiTFs[vi]);
+            tf.UpdatePreIntegratedOSGTexture(*multiTFPreInts[vi]);
+        }
+    }
+    if (!changed)
+        return;
+    ++tfRevision;
 
     emit TransferFunctionChanged();
 }
@@ -174,12 +485,12 @@ void VIS4Earth::VolumeComponent::updateVoxelPerVolume() {
 
     std::array<int, 3> voxPerVol;
     if (keepCPUData) {
-        auto &vol = multiTimeVaryingVolCPUs[volIdx][0];
+        auto &vol = GetVolumeCPU(volIdx, 0);
         voxPerVol[0] = vol.GetVoxelPerVolume()[0];
         voxPerVol[1] = vol.GetVoxelPerVolume()[1];
         voxPerVol[2] = vol.GetVoxelPerVolume()[2];
     } else {
-        auto vol = multiTimeVaryingVols[volIdx][0];
+        auto vol = GetVolume(volIdx, 0);
         voxPerVol[0] = vol->getImage()->s();
         voxPerVol[1] = vol->getImage()->t();
         voxPerVol[2] = vol->getImage()->r();
@@ -188,3 +499,127 @@ void VIS4Earth::VolumeComponent::updateVoxelPerVolume() {
     ui->label_voxPerVolY->setText(QString("%0").arg(voxPerVol[1]));
     ui->label_voxPerVolZ->setText(QString("%0").arg(voxPerVol[2]));
 }
+
+VIS4Earth::ESupportedVoxelType VIS4Earth::VolumeComponent::GetVoxelType() const {
+    return static_cast<ESupportedVoxelType>(ui->comboBox_voxTy->currentIndex());
+}
+
+VIS4Earth::RAWVolumeData::ETextureSizeMode VIS4Earth::VolumeComponent::textureSizeMode() const {
+    return ui->checkBox_npotTexture->isChecked() ? RAWVolumeData::ETextureSizeMode::NonPowerOfTwo
+                                                 : RAWVolumeData::ETextureSizeMode::PowerOfTwo;
+}
+
+VIS4Earth::RAWVolumeData::SmoothParameters VIS4Earth::VolumeComponent::smoothParameters() const {
+    return RAWVolumeData::SmoothParameters{
+        static_cast<RAWVolumeData::ESmoothType>(ui->comboBox_smoothType->currentIndex()),
+        static_cast<RAWVolumeData::ESmoothDimension>(ui->comboBox_smoothDim->currentIndex()),
+        static_cast<uint32_t>(ui->spinBox_smoothRadius->value())};
+}
+
+const VIS4Earth::VolumeComponent::DecodedStep &
+VIS4Earth::VolumeComponent::getDecoded(uint32_t volID, uint32_t timeID,
+                                       bool needTexture) const {
+    // 命中则直接使用，否则替换最久未用的一个。各项原地替换，不移动其余项
+    auto &steps = decodedSteps[volID];
+    auto *decoded = &steps[0];
+    for (auto &step : steps) {
+        if (step.timeID == timeID) {
+            decoded = &step;
+            break;
+        }
+        if (step.lastUse < decoded->lastUse)
+            decoded = &step;
+    }
+
+    if (decoded->timeID != timeID) {
+        *decoded = DecodedStep();
+        auto volDat = multiCompressedVolCPUs[volID].Decode(timeID);
+        if (!volDat.ok) {
+            qDebug() << "Decode" << timeID << "of volume" << volID << "failed:"
+                     << volDat.result.errMsg.c_str();
+            return *decoded;
+        }
+
+        decoded->timeID = timeID;
+        decoded->volCPU = std::move(volDat.result.dat);
+        multiCompressedVolCPUs[volID].LogStatistics();
+    }
+    decoded->lastUse = ++decodeUseCount;
+
+    auto texSizeMode = textureSizeMode();
+    if (needTexture && (!decoded->vol.valid() || decoded->texSizeMode != texSizeMode)) {
+        decoded->vol = decoded->volCPU.ToOSGTexture(texSizeMode);
+        decoded->texSizeMode = texSizeMode;
+    }
+    return *decoded;
+}
+
+osg::ref_ptr<osg::Texture3D>
+VIS4Earth::VolumeComponent::GetAmbientOcclusion(uint32_t volID, uint32_t timeID,
+                                                AmbientOcclusionVolume::Statistics *stats) const {
+    auto isStreamedFirst = IsStreaming(volID) && timeID == 0;
+    auto isCompressed = IsCompressed(volID) && timeID < GetVolumeTimeNumber(volID);
+    if (volID > 1 ||
+        (!isStreamedFirst && !isCompressed && timeID >= multiTimeVaryingVolCPUs[volID].size()))
+        return nullptr;
+
+    AmbientOcclusionCache::Key key(volID, timeID);
+    AmbientOcclusionCache::Entry entry;
+    if (aoCache.Find(key, entry) && entry.tfRevision == tfRevision)
+        return entry.ao->GetTexture();
+
+    auto &vol = GetVolumeCPU(volID, timeID);
+    auto &tf = GetTransferFunctionCPU(volID);
+    if (entry.ao) {
+        auto updated = entry.ao->Update(vol, tf);
+        if (stats)
+            *stats = updated;
+    } else {
+        auto ao = AmbientOcclusionVolume::Compute(vol, tf, AmbientOcclusionVolume::Parameters(),
+                                                  stats);
+        if (!ao.ok) {
+            qDebug() << "Compute ambient occlusion of volume" << volID << "failed:"
+                     << ao.result.errMsg.c_str();
+            return nullptr;
+        }
+        entry.ao = std::make_shared<AmbientOcclusionVolume>(std::move(ao.result.dat));
+    }
+    entry.tfRevision = tfRevision;
+    aoCache.Insert(key, entry);
+
+    return entry.ao->GetTexture();
+}
+
+VIS4Earth::SmoothedVolumeCache::Entry
+VIS4Earth::VolumeComponent::getSmoothed(uint32_t volID, uint32_t timeID) const {
+    SmoothedVolumeCache::Entry entry;
+    auto isStreamedFirst = IsStreaming(volID) && timeID == 0;
+    auto isCompressed = IsCompressed(volID) && timeID < GetVolumeTimeNumber(volID);
+    if (!keepVolSmoothed || volID > 1 ||
+        (!isStreamedFirst && !isCompressed && timeID >= multiTimeVaryingVolCPUs[volID].size()))
+        return entry;
+
+    auto param = smoothParameters();
+    auto texSizeMode = textureSizeMode();
+    SmoothedVolumeCache::Key key(volID, timeID, param.smoothType, param.smoothDim, param.radius,
+                                 texSizeMode);
+    if (smoothedCache.Find(key, entry))
+        return entry;
+
+    return smoothAndCache(volID, timeID, param, texSizeMode, GetVolumeCPU(volID, timeID));
+}
+
+VIS4Earth::SmoothedVolumeCache::Entry VIS4Earth::VolumeComponent::smoothAndCache(
+    uint32_t volID, uint32_t timeID, const RAWVolumeData::SmoothParameters &param,
+    RAWVolumeData::ETextureSizeMode texSizeMode, const RAWVolumeData &vol) const {
+    SmoothedVolumeCache::Entry entry;
+    auto volDatSmoothed = vol.GetSmoothed(param);
+    entry.vol = volDatSmoothed.ToOSGTexture(texSizeMode);
+    if (keepCPUData)
+        entry.volCPU = volDatSmoothed;
+    smoothedCache.Insert(SmoothedVolumeCache::Key(volID, timeID, param.smoothType, param.smoothDim,
+                                                  param.radius, texSizeMode),
+                         entry);
+
+    return entry;
+}
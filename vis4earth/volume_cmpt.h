@@ -1,8 +1,14 @@
 ﻿#ifndef VIS4EARTH_VOLUME_CMPT_H
 #define VIS4EARTH_VOLUME_CMPT_H
 
+#include <chrono>
+#include <limits>
+#include <memory>
+
+#include <map>
 #include <vector>
 
+#include <QtCore/QTimer>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
 
@@ -10,8 +16,18 @@
 #include <osg/Texture2D>
 #include <osg/Texture3D>
 
+#include <vis4earth/data/macro_cell.h>
 #include <vis4earth/data/tf_data.h>
+#include <vis4earth/data/vol_ao.h>
+#include <vis4earth/data/vol_cache.h>
+#include <vis4earth/data/vol_compressed.h>
+#include <vis4earth/data/vol_container.h>
 #include <vis4earth/data/vol_data.h>
+#include <vis4earth/data/vol_gradient.h>
+#include <vis4earth/data/vol_loader.h>
+#include <vis4earth/data/vol_packed.h>
+#include <vis4earth/data/vol_player.h>
+#include <vis4earth/data/vol_pyramid.h>
 #include <vis4earth/math.h>
 #include <vis4earth/qt_osg_reflectable.h>
 #include <vis4earth/tf_editor.h>
@@ -28,37 +44,144 @@ class VolumeComponent : public QtOSGReflectableWidget {
   public:
     VolumeComponent(bool keepCPUData = false, bool keepVolSmoothed = false,
                     QWidget *parent = nullptr);
+    ~VolumeComponent();
 
     const Ui::VolumeComponent *GetUI() const { return ui; }
 
-    ESupportedVoxelType GetVoxelType() const { return ESupportedVoxelType::UInt8; }
+    // RAW 文件的体素类型，加载容器或金字塔时同步为其中的类型
+    ESupportedVoxelType GetVoxelType() const;
+
+    // 非 0 时加载体数据的同时为每个时间步构建宏单元网格，应在加载前设置
+    void SetMacroCellSize(uint32_t cellSize) { macroCellSize = cellSize; }
+    // 为真时加载体数据的同时为每个时间步预先计算梯度纹理，应在加载前设置
+    void SetComputeGradient(bool compute) { computeGradient = compute; }
+    // 为真时将体 0 与体 1 的各时间步打包为双通道纹理，已加载的时间步随即打包，
+    // 此后加载的时间步在加载时打包；为假时释放已打包的纹理
+    void SetPackVolumes(bool pack);
 
     uint32_t GetVolumeTimeNumber(uint32_t volID) const {
         if (volID > 1)
             return 0;
+        if (players[volID])
+            return players[volID]->GetTimeNumber();
+        if (IsCompressed(volID))
+            return multiCompressedVolCPUs[volID].GetTimeNumber();
         return multiTimeVaryingVols[volID].size();
     }
 
+    // 流式播放时仅返回已驻留的时间步（第 0 步常驻），否则返回空；压缩存放时按需解码
     osg::ref_ptr<osg::Texture3D> GetVolume(uint32_t volID, uint32_t timeID) const {
-        if (volID > 1 || timeID >= multiTimeVaryingVols[volID].size())
+        if (volID > 1)
+            return nullptr;
+        if (players[volID])
+            return players[volID]->GetVolume(timeID);
+        if (IsCompressed(volID) && timeID != 0)
+            return getDecoded(volID, timeID, true).vol;
+        if (timeID >= multiTimeVaryingVols[volID].size())
             return nullptr;
         return multiTimeVaryingVols[volID][timeID];
     }
-    osg::ref_ptr<osg::Texture3D> GetVolumeSmoothed(uint32_t volID, uint32_t timeID) const {
-        if (volID > 1 || timeID >= multiTimeVaryingVolSmootheds[volID].size())
+    /*
+     * 函数: GetVolumeForPlayback
+     * 功能: 播放到 timeID 时获取应显示的纹理。流式播放时会预取后续时间步，
+     *       所需时间步未就绪时返回上一帧的纹理
+     */
+    osg::ref_ptr<osg::Texture3D> GetVolumeForPlayback(uint32_t volID, uint32_t timeID) {
+        if (volID <= 1 && players[volID])
+            return players[volID]->Present(timeID);
+        return GetVolume(volID, timeID);
+    }
+    bool IsStreaming(uint32_t volID) const { return volID <= 1 && players[volID]; }
+    // 流式播放的当前时间步未就绪、GetVolumeForPlayback 返回上一帧的纹理时为真
+    bool IsPlaybackLate(uint32_t volID) const {
+        return IsStreaming(volID) && players[volID]->IsLate();
+    }
+    bool IsCompressed(uint32_t volID) const {
+        return volID <= 1 && multiCompressedVolCPUs[volID].GetTimeNumber() != 0;
+    }
+    const CompressedVolumeSeries &GetCompressedVolumeCPUs(uint32_t volID) const {
+        return multiCompressedVolCPUs[volID];
+    }
+    // 由体数据金字塔加载时非空，此时第 0 个时间步为金字塔的预览层
+    std::shared_ptr<const VolumePyramid> GetPyramid(uint32_t volID) const {
+        if (volID > 1)
             return nullptr;
-        return multiTimeVaryingVolSmootheds[volID][timeID];
+        return pyramids[volID];
+    }
+    TimeVaryingVolumePlayer::Statistics GetPlaybackStatistics(uint32_t volID) const {
+        if (!IsStreaming(volID))
+            return {0, 0, 0, 0};
+        return players[volID]->GetStatistics();
+    }
+    /*
+     * 函数: GetVolumeSmoothed
+     * 功能: 返回按当前光滑参数光滑后的纹理，未缓存时即时计算并加入缓存
+     */
+    osg::ref_ptr<osg::Texture3D> GetVolumeSmoothed(uint32_t volID, uint32_t timeID) const {
+        return getSmoothed(volID, timeID).vol;
     }
+    // 流式播放时仅第 0 个时间步可用。压缩存放时其余时间步按需解码，
+    // 返回的引用在该时间步的解码结果被替换后失效。不可用时返回静态的空体
     const RAWVolumeData &GetVolumeCPU(uint32_t volID, uint32_t timeID) const {
+        static const RAWVolumeData Empty;
+        if (volID <= 1 && players[volID] && timeID == 0)
+            return players[volID]->GetFirstVolumeCPU();
+        if (IsCompressed(volID) && timeID != 0)
+            return getDecoded(volID, timeID, false).volCPU;
         if (volID > 1 || timeID >= multiTimeVaryingVolCPUs[volID].size())
-            return {};
+            return Empty;
         return multiTimeVaryingVolCPUs[volID][timeID];
     }
-    const RAWVolumeData &GetVolumeCPUSmoothed(uint32_t volID, uint32_t timeID) const {
-        if (volID > 1 || timeID >= multiTimeVaryingVolCPUSmootheds[volID].size())
-            return {};
-        return multiTimeVaryingVolCPUSmootheds[volID][timeID];
+    // 缓存项可能被淘汰，因此按值返回（体素缓冲共享，不复制数据）
+    RAWVolumeData GetVolumeCPUSmoothed(uint32_t volID, uint32_t timeID) const {
+        return getSmoothed(volID, timeID).volCPU;
+    }
+    // 未构建（未设置 SetMacroCellSize、流式播放的其余时间步或金字塔）时返回空
+    std::shared_ptr<const MacroCellGrid> GetMacroCells(uint32_t volID, uint32_t timeID) const {
+        if (volID > 1 || timeID >= multiMacroCells[volID].size())
+            return nullptr;
+        return multiMacroCells[volID][timeID];
+    }
+    // 未计算（同 GetMacroCells）时返回空
+    osg::ref_ptr<osg::Texture3D> GetGradient(uint32_t volID, uint32_t timeID) const {
+        if (volID > 1 || timeID >= multiGradients[volID].size())
+            return nullptr;
+        return multiGradients[volID][timeID];
     }
+    /*
+     * 函数: GetPackedVolume
+     * 功能: 返回体 0 与体 1 的第 timeID 步打包成的 RG 纹理，R、G 通道分别为两个体。
+     *       未设置 SetPackVolumes、未保留 CPU 数据，或两个体不可打包（流式播放、压缩存放、金字塔，
+     *       体素数、体素类型或加载时的纹理尺寸模式不同）时返回空。
+     *       纹理尺寸与各体单独的纹理相同。两个体的时间步数不同时，仅前面共有的时间步被打包
+     */
+    osg::ref_ptr<osg::Texture3D> GetPackedVolume(uint32_t timeID) const {
+        if (timeID >= packedVols.size())
+            return nullptr;
+        return packedVols[timeID];
+    }
+    /*
+     * 函数: ReleaseVolumeGLObjects
+     * 功能: 释放体 volID 各时间步的纹理已占用的显存，纹理保留图像，再次绑定时重新上传。
+     *       渲染器改为绑定打包的纹理时调用，使两份纹理不同时驻留显存
+     */
+    void ReleaseVolumeGLObjects(uint32_t volID) const {
+        if (volID > 1)
+            return;
+        for (auto &vol : multiTimeVaryingVols[volID])
+            if (vol.valid())
+                vol->releaseGLObjects();
+    }
+    /*
+     * 函数: GetAmbientOcclusion
+     * 功能: 返回按当前传输函数预先计算的环境光遮蔽纹理。需要该时间步的 CPU 数据，
+     *       不可用时返回空。已缓存但传输函数有变化时增量更新
+     * 参数:
+     * -- stats: 非空时，写入本次计算或更新的统计，命中缓存时不写入
+     */
+    osg::ref_ptr<osg::Texture3D>
+    GetAmbientOcclusion(uint32_t volID, uint32_t timeID,
+                        AmbientOcclusionVolume::Statistics *stats = nullptr) const;
 
     osg::ref_ptr<osg::Texture1D> GetTransferFunction(uint32_t volID) const {
         if (volID > 1)
@@ -66,8 +189,9 @@ class VolumeComponent : public QtOSGReflectableWidget {
         return multiTFs[volID];
     }
     const TransferFunctionData &GetTransferFunctionCPU(uint32_t volID) const {
+        static const TransferFunctionData Empty = {};
         if (volID > 1)
-            return {};
+            return Empty;
         return tfEditors[volID]->GetTransferFunctionData();
     }
     osg::ref_ptr<osg::Texture2D> GetPreIntegratedTransferFunction(uint32_t volID) const {
@@ -79,32 +203,127 @@ class VolumeComponent : public QtOSGReflectableWidget {
   Q_SIGNALS:
     void VolumeChanged();
     void TransferFunctionChanged();
+    // 从容器加载时发出，经纬度单位为度，高度单位为米
+    void GeographicsLoaded(float lonMin, float lonMax, float latMin, float latMax, float heightMin,
+                           float heightMax);
 
   private:
     bool keepCPUData;
     bool keepVolSmoothed;
+    uint32_t macroCellSize = 0;
+    bool computeGradient = false;
+    bool packVols = false;
 
     Ui::VolumeComponent *ui;
     std::array<TransferFunctionEditor *, 2> tfEditors;
     std::array<osg::ref_ptr<osg::Texture1D>, 2> multiTFs;
 	std::array<float, 2> multiRelativeAlphas; 
     std::array<osg::ref_ptr<osg::Texture2D>, 2> multiTFPreInts;
+    // 上次采样的传输函数，采样结果不变时不更新纹理
+    std::array<std::array<std::array<float, 4>, 256>, 2> sampledTFs;
+    // 为真时传输函数已改变、尚未采样
+    std::array<bool, 2> tfDirties = {true, true};
+    // 拖动控制点时编辑器每次鼠标移动都发出改变，由其合并为每帧至多一次采样
+    QTimer tfTimer;
     std::array<std::vector<osg::ref_ptr<osg::Texture3D>>, 2> multiTimeVaryingVols;
-    std::array<std::vector<osg::ref_ptr<osg::Texture3D>>, 2> multiTimeVaryingVolSmootheds;
     std::array<std::vector<RAWVolumeData>, 2> multiTimeVaryingVolCPUs;
-    std::array<std::vector<RAWVolumeData>, 2> multiTimeVaryingVolCPUSmootheds;
+    // 压缩存放时仅第 0 个时间步同时保留于上面两个数组中，供渲染器直接使用
+    std::array<CompressedVolumeSeries, 2> multiCompressedVolCPUs;
+    std::array<std::vector<std::shared_ptr<const MacroCellGrid>>, 2> multiMacroCells;
+    std::array<std::vector<osg::ref_ptr<osg::Texture3D>>, 2> multiGradients;
+    // 两个体共有的时间步打包成的纹理，任一体重新加载时清空
+    std::vector<osg::ref_ptr<osg::Texture3D>> packedVols;
+    // 各体加载时的纹理尺寸模式，打包的纹理按同一模式构建
+    std::array<RAWVolumeData::ETextureSizeMode, 2> volTexSizeModes = {
+        RAWVolumeData::ETextureSizeMode::NonPowerOfTwo,
+        RAWVolumeData::ETextureSizeMode::NonPowerOfTwo};
+    /*
+     * 结构体: DecodedStep
+     * 功能: 每个体最近解码的若干时间步。播放时当前与下一时间步交替访问，
+     *       按最近最少使用替换；纹理在首次按纹理访问时才构建
+     */
+    struct DecodedStep {
+        uint32_t timeID = std::numeric_limits<uint32_t>::max();
+        uint64_t lastUse = 0;
+        RAWVolumeData volCPU;
+        osg::ref_ptr<osg::Texture3D> vol;
+        RAWVolumeData::ETextureSizeMode texSizeMode =
+            RAWVolumeData::ETextureSizeMode::NonPowerOfTwo;
+    };
+    static constexpr uint32_t DecodedStepNumber = 2;
+    mutable std::array<std::array<DecodedStep, DecodedStepNumber>, 2> decodedSteps;
+    mutable uint64_t decodeUseCount = 0;
+    mutable SmoothedVolumeCache smoothedCache;
+    // 传输函数每次重新采样时递增，环境光遮蔽缓存项据此判断是否需要更新
+    uint64_t tfRevision = 0;
+    mutable AmbientOcclusionCache aoCache;
+
+    /*
+     * 结构体: LoadState
+     * 功能: 单个体的异步加载状态，仅在 UI 线程中访问。
+     *       工作线程的结果可能乱序到达，按文件顺序交付后才追加到时间序列中
+     */
+    struct LoadState {
+        std::unique_ptr<AsyncVolumeLoader> loader;
+        uint32_t generation = 0; // 每次加载递增，用于丢弃已取消加载的迟到结果
+        uint32_t nextFileIdx = 0;
+        uint32_t finishedNum = 0;
+        bool compress = false;
+        std::map<uint32_t, AsyncVolumeLoader::Result> pendings;
+        QStringList errMsgs;
+        std::chrono::steady_clock::time_point start;
+    };
+    std::array<LoadState, 2> loadStates;
+    std::array<std::shared_ptr<TimeVaryingVolumePlayer>, 2> players;
+    std::array<std::shared_ptr<const VolumePyramid>, 2> pyramids;
 
     void loadRAWVolume();
 
+    void cancelLoadRAWVolume();
+
+    void loadVolumePyramid(uint32_t volID, const QString &filePath);
+
+    void streamRAWVolume(uint32_t volID, const QStringList &filePaths,
+                         const std::array<uint32_t, 3> &voxPerVol, ESupportedVoxelType voxTy,
+                         std::shared_ptr<const VolumeContainer> container);
+
+    void onRAWVolumeLoaded(uint32_t volID, uint32_t generation, AsyncVolumeLoader::Result result);
+
+    void updateLoadProgress();
+
+    /*
+     * 函数: packVolumes
+     * 功能: 打包两个体均已交付、尚未打包的时间步，遇到不可打包的时间步时停止
+     */
+    void packVolumes();
+
     void smoothVolume();
 
     void loadTF();
 
     void saveTF();
 
+    /*
+     * 函数: sampleTF
+     * 功能: 重新采样已改变的传输函数。首次采样时创建纹理，此后原地更新纹理的图像并标记为脏，
+     *       采样结果不变时不重新计算预积分表，也不发出 TransferFunctionChanged
+     */
     void sampleTF();
 
     void updateVoxelPerVolume();
+
+    RAWVolumeData::ETextureSizeMode textureSizeMode() const;
+
+    RAWVolumeData::SmoothParameters smoothParameters() const;
+
+    const DecodedStep &getDecoded(uint32_t volID, uint32_t timeID, bool needTexture) const;
+
+    SmoothedVolumeCache::Entry getSmoothed(uint32_t volID, uint32_t timeID) const;
+
+    SmoothedVolumeCache::Entry smoothAndCache(uint32_t volID, uint32_t timeID,
+                                              const RAWVolumeData::SmoothParameters &param,
+                                              RAWVolumeData::ETextureSizeMode texSizeMode,
+                                              const RAWVolumeData &vol) const;
 };
 
 } // namespace VIS4Earth